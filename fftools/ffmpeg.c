@@ -145,7 +145,7 @@ static int restore_tty;
    This is a temporary solution until libavfilter gets real subtitles support.
  */
 
-static void sub2video_heartbeat(InputFile *infile, int64_t pts, AVRational tb)
+static int sub2video_heartbeat(InputFile *infile, int64_t pts, AVRational tb)
 {
     /* When a frame is read from a file, examine all sub2video streams in
        the same file and send the sub2video frame again. Otherwise, decoded
@@ -157,9 +157,14 @@ static void sub2video_heartbeat(InputFile *infile, int64_t pts, AVRational tb)
         if (ist->dec_ctx->codec_type != AVMEDIA_TYPE_SUBTITLE)
             continue;
 
-        for (int j = 0; j < ist->nb_filters; j++)
-            ifilter_sub2video_heartbeat(ist->filters[j], pts, tb);
+        for (int j = 0; j < ist->nb_filters; j++) {
+            int ret = ifilter_sub2video_heartbeat(ist->filters[j], pts, tb);
+            if (ret < 0)
+                return ret;
+        }
     }
+
+    return 0;
 }
 
 /* end of sub2video hack */
@@ -980,7 +985,7 @@ static void set_tty_echo(int on)
 
 static int check_keyboard_interaction(int64_t cur_time)
 {
-    int i, ret, key;
+    int i, key, ret;
     static int64_t last_time;
     if (received_nb_signals)
         return AVERROR_EXIT;
@@ -1014,21 +1019,10 @@ static int check_keyboard_interaction(int64_t cur_time)
             av_log(NULL, AV_LOG_DEBUG, "Processing command target:%s time:%f command:%s arg:%s",
                    target, time, command, arg);
             for (i = 0; i < nb_filtergraphs; i++) {
-                FilterGraph *fg = filtergraphs[i];
-                if (fg->graph) {
-                    if (time < 0) {
-                        ret = avfilter_graph_send_command(fg->graph, target, command, arg, buf, sizeof(buf),
-                                                          key == 'c' ? AVFILTER_CMD_FLAG_ONE : 0);
-                        fprintf(stderr, "Command reply for stream %d: ret:%d res:\n%s", i, ret, buf);
-                    } else if (key == 'c') {
-                        fprintf(stderr, "Queuing commands only on filters supporting the specific command is unsupported\n");
-                        ret = AVERROR_PATCHWELCOME;
-                    } else {
-                        ret = avfilter_graph_queue_command(fg->graph, target, command, arg, 0, time);
-                        if (ret < 0)
-                            fprintf(stderr, "Queuing command failed with error %s\n", av_err2str(ret));
-                    }
-                }
+                ret = fg_send_command(filtergraphs[i], time, target, command, arg,
+                                      key == 'C');
+                if (ret < 0)
+                    return ret;
             }
         } else {
             av_log(NULL, AV_LOG_ERROR,
@@ -1132,7 +1126,11 @@ static int process_input(int file_index)
 
     ist = ifile->streams[pkt->stream_index];
 
-    sub2video_heartbeat(ifile, pkt->pts, pkt->time_base);
+    ret = sub2video_heartbeat(ifile, pkt->pts, pkt->time_base);
+    if (ret < 0) {
+        av_packet_free(&pkt);
+        return ret;
+    }
 
     ret = process_input_packet(ist, pkt, 0);
 
@@ -1171,7 +1169,7 @@ static int transcode_step(OutputStream *ost)
     if (ret < 0)
         return ret == AVERROR_EOF ? 0 : ret;
 
-    return reap_filters(0);
+    return reap_filters();
 }
 
 /*
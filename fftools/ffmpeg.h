@@ -734,7 +734,7 @@ FrameData *frame_data(AVFrame *frame);
 int ifilter_send_frame(InputFilter *ifilter, AVFrame *frame, int keep_reference);
 int ifilter_send_eof(InputFilter *ifilter, int64_t pts, AVRational tb);
 int ifilter_sub2video(InputFilter *ifilter, const AVFrame *frame);
-void ifilter_sub2video_heartbeat(InputFilter *ifilter, int64_t pts, AVRational tb);
+int ifilter_sub2video_heartbeat(InputFilter *ifilter, int64_t pts, AVRational tb);
 
 /**
  * Set up fallback filtering parameters from a decoder context. They will only
@@ -765,12 +765,26 @@ void fg_free(FilterGraph **pfg);
 int fg_transcode_step(FilterGraph *graph, InputStream **best_ist);
 
 /**
- * Get and encode new output from any of the filtergraphs, without causing
- * activity.
+ * Send a command to all filters in the graph, or queue it to be executed at
+ * the given time. The command is processed asynchronously by the filtering
+ * thread, which also prints the reply.
+ *
+ * @param time        time at which to execute the command, or <0 to send it
+ *                    immediately
+ * @param all_filters send the command to all filters matching target instead
+ *                    of just the first one
+ * @return  0 for success, <0 for errors
+ */
+int fg_send_command(FilterGraph *fg, double time, const char *target,
+                    const char *command, const char *arg, int all_filters);
+
+/**
+ * Wait for all the filtergraphs to finish processing the input sent to them
+ * so far, and encode their output.
  *
  * @return  0 for success, <0 for severe errors
  */
-int reap_filters(int flush);
+int reap_filters(void);
 
 int ffmpeg_parse_options(int argc, char **argv);
 
@@ -20,6 +20,7 @@
 #include <stdint.h>
 
 #include "ffmpeg.h"
+#include "thread_queue.h"
 
 #include "libavutil/avassert.h"
 #include "libavutil/avstring.h"
@@ -67,8 +68,65 @@ struct Encoder {
     uint64_t dup_warning;
 
     int opened;
+
+    // sample aspect ratio forced with -aspect, stored in every frame sent to
+    // the encoder thread; the encoder context is not touched once the
+    // thread runs
+    AVRational      sample_aspect_ratio;
+
+    pthread_t       thread;
+    /**
+     * Queue for sending frames from the main thread to the encoder thread.
+     *
+     * An empty frame is sent to flush the encoder.
+     */
+    ThreadQueue    *queue_in;
+    /**
+     * Queue for sending encoded packets from the encoder thread to the main
+     * thread. Stream 0 carries the packets. For every frame sent to the
+     * encoder thread, an empty packet is sent on stream 1 once that frame has
+     * been fully processed, with the result code stored in its opaque field.
+     */
+    ThreadQueue    *queue_out;
+
+    // frame for sending data to the encoder thread
+    AVFrame        *send_frame;
+    // number of frames sent to the encoder thread that were not fully
+    // processed yet
+    unsigned        frames_in_flight;
 };
 
+// data that is local to the encoder thread and not visible outside of it
+typedef struct EncThreadContext {
+    AVFrame         *frame;
+    AVPacket        *pkt;
+} EncThreadContext;
+
+/* maximum number of frames queued for encoding before the main thread waits
+ * for the encoder to catch up */
+#define ENC_FRAMES_IN_FLIGHT 8
+
+static int enc_thread_stop(Encoder *e)
+{
+    void *ret;
+
+    if (!e->queue_in)
+        return 0;
+
+    tq_send_finish(e->queue_in, 0);
+    tq_receive_finish(e->queue_out, 0);
+    tq_receive_finish(e->queue_out, 1);
+
+    pthread_join(e->thread, &ret);
+
+    tq_free(&e->queue_in);
+    tq_free(&e->queue_out);
+
+    return (intptr_t)ret;
+}
+
+static int enc_thread_start(OutputStream *ost);
+
 void enc_free(Encoder **penc)
 {
     Encoder *enc = *penc;
@@ -76,8 +134,11 @@ void enc_free(Encoder **penc)
     if (!enc)
         return;
 
+    enc_thread_stop(enc);
+
     av_frame_free(&enc->last_frame);
     av_frame_free(&enc->sq_frame);
+    av_frame_free(&enc->send_frame);
 
     av_packet_free(&enc->pkt);
 
@@ -104,6 +165,10 @@ int enc_alloc(Encoder **penc, const AVCodec *codec)
     if (!enc->pkt)
         goto fail;
 
+    enc->send_frame = av_frame_alloc();
+    if (!enc->send_frame)
+        goto fail;
+
     enc->dup_warning = 1000;
 
     *penc = enc;
@@ -295,6 +360,8 @@ int enc_open(OutputStream *ost, AVFrame *frame)
             ost->frame_aspect_ratio.num ? // overridden by the -aspect cli option
             av_mul_q(ost->frame_aspect_ratio, (AVRational){ enc_ctx->height, enc_ctx->width }) :
             frame->sample_aspect_ratio;
+        if (ost->frame_aspect_ratio.num)
+            e->sample_aspect_ratio = enc_ctx->sample_aspect_ratio;
 
         enc_ctx->pix_fmt = frame->format;
 
@@ -458,6 +525,13 @@ int enc_open(OutputStream *ost, AVFrame *frame)
 
     ost->mux_timebase = enc_ctx->time_base;
 
+    if (enc_ctx->codec_type == AVMEDIA_TYPE_VIDEO ||
+        enc_ctx->codec_type == AVMEDIA_TYPE_AUDIO) {
+        ret = enc_thread_start(ost);
+        if (ret < 0)
+            return ret;
+    }
+
     ret = of_stream_init(of, ost);
     if (ret < 0)
         return ret;
@@ -691,34 +765,20 @@ static void update_video_stats(OutputStream *ost, const AVPacket *pkt, int write
     fprintf(vstats_file, "type= %c\n", av_get_picture_type_char(pict_type));
 }
 
-static int encode_frame(OutputFile *of, OutputStream *ost, AVFrame *frame)
+/* Runs in the encoder thread. */
+static int frame_encode(OutputStream *ost, AVFrame *frame, AVPacket *pkt)
 {
     Encoder            *e = ost->enc;
     AVCodecContext   *enc = ost->enc_ctx;
-    AVPacket         *pkt = e->pkt;
     const char *type_desc = av_get_media_type_string(enc->codec_type);
     const char    *action = frame ? "encode" : "flush";
     int ret;
 
-    if (frame) {
-        if (ost->enc_stats_pre.io)
-            enc_stats_write(ost, &ost->enc_stats_pre, frame, NULL,
-                            ost->frames_encoded);
-
-        ost->frames_encoded++;
-        ost->samples_encoded += frame->nb_samples;
-
-        if (debug_ts) {
-            av_log(ost, AV_LOG_INFO, "encoder <- type:%s "
-                   "frame_pts:%s frame_pts_time:%s time_base:%d/%d\n",
-                   type_desc,
-                   av_ts2str(frame->pts), av_ts2timestr(frame->pts, &enc->time_base),
-                   enc->time_base.num, enc->time_base.den);
-        }
-
-        if (frame->sample_aspect_ratio.num && !ost->frame_aspect_ratio.num)
-            enc->sample_aspect_ratio = frame->sample_aspect_ratio;
-    }
+    // an aspect ratio forced with -aspect comes with the frame as well (see
+    // encode_frame()), so no other thread needs to touch the encoder context
+    if (frame && enc->codec_type == AVMEDIA_TYPE_VIDEO &&
+        frame->sample_aspect_ratio.num)
+        enc->sample_aspect_ratio = frame->sample_aspect_ratio;
 
     update_benchmark(NULL);
 
@@ -744,44 +804,273 @@ static int encode_frame(OutputFile *of, OutputStream *ost, AVFrame *frame)
             av_assert0(frame); // should never happen during flushing
             return 0;
         } else if (ret == AVERROR_EOF) {
-            of_output_packet(of, ost, NULL);
             return ret;
         } else if (ret < 0) {
             av_log(ost, AV_LOG_ERROR, "%s encoding failed\n", type_desc);
             return ret;
         }
 
-        if (enc->codec_type == AVMEDIA_TYPE_VIDEO)
-            update_video_stats(ost, pkt, !!vstats_filename);
-        if (ost->enc_stats_post.io)
-            enc_stats_write(ost, &ost->enc_stats_post, NULL, pkt,
-                            e->packets_encoded);
+        ret = tq_send(e->queue_out, 0, pkt);
+        if (ret < 0) {
+            av_packet_unref(pkt);
+            return ret;
+        }
+    }
+
+    av_assert0(0);
+}
 
-        if (debug_ts) {
-            av_log(ost, AV_LOG_INFO, "encoder -> type:%s "
-                   "pkt_pts:%s pkt_pts_time:%s pkt_dts:%s pkt_dts_time:%s "
-                   "duration:%s duration_time:%s\n",
-                   type_desc,
-                   av_ts2str(pkt->pts), av_ts2timestr(pkt->pts, &enc->time_base),
-                   av_ts2str(pkt->dts), av_ts2timestr(pkt->dts, &enc->time_base),
-                   av_ts2str(pkt->duration), av_ts2timestr(pkt->duration, &enc->time_base));
+static void enc_thread_set_name(const OutputStream *ost)
+{
+    char name[16];
+    snprintf(name, sizeof(name), "enc%d:%d:%s", ost->file_index, ost->index,
+             ost->enc_ctx->codec->name);
+    ff_thread_setname(name);
+}
+
+static void enc_thread_uninit(EncThreadContext *et)
+{
+    av_packet_free(&et->pkt);
+    av_frame_free(&et->frame);
+
+    memset(et, 0, sizeof(*et));
+}
+
+static int enc_thread_init(EncThreadContext *et)
+{
+    memset(et, 0, sizeof(*et));
+
+    et->frame = av_frame_alloc();
+    if (!et->frame)
+        goto fail;
+
+    et->pkt = av_packet_alloc();
+    if (!et->pkt)
+        goto fail;
+
+    return 0;
+
+fail:
+    enc_thread_uninit(et);
+    return AVERROR(ENOMEM);
+}
+
+static void *encoder_thread(void *arg)
+{
+    OutputStream *ost = arg;
+    Encoder        *e = ost->enc;
+    EncThreadContext et;
+    int ret = 0;
+
+    ret = enc_thread_init(&et);
+    if (ret < 0)
+        goto finish;
+
+    enc_thread_set_name(ost);
+
+    while (1) {
+        int dummy;
+
+        // the main thread finished sending frames
+        if (tq_receive(e->queue_in, &dummy, et.frame) < 0)
+            break;
+
+        ret = frame_encode(ost, et.frame->buf[0] ? et.frame : NULL, et.pkt);
+
+        av_frame_unref(et.frame);
+
+        // signal to the main thread that the entire frame was processed;
+        // errors are reported to it rather than terminating the thread
+        et.pkt->opaque = (void*)(intptr_t)ret;
+        ret = tq_send(e->queue_out, 1, et.pkt);
+        if (ret < 0) {
+            if (ret != AVERROR_EOF)
+                av_log(ost, AV_LOG_ERROR, "Error communicating with the main thread\n");
+            break;
         }
+    }
 
-        if ((ret = trigger_fix_sub_duration_heartbeat(ost, pkt)) < 0) {
-            av_log(NULL, AV_LOG_ERROR,
-                   "Subtitle heartbeat logic failed in %s! (%s)\n",
-                   __func__, av_err2str(ret));
-            exit_program(1);
+    // EOF is normal thread termination
+    if (ret == AVERROR_EOF)
+        ret = 0;
+
+finish:
+    tq_receive_finish(e->queue_in,  0);
+    tq_send_finish   (e->queue_out, 0);
+    tq_send_finish   (e->queue_out, 1);
+
+    enc_thread_uninit(&et);
+
+    av_log(ost, AV_LOG_VERBOSE, "Terminating encoder thread\n");
+
+    return (void*)(intptr_t)ret;
+}
+
+static int enc_thread_start(OutputStream *ost)
+{
+    Encoder *e = ost->enc;
+    ObjPool *op;
+    int ret = 0;
+
+    op = objpool_alloc_frames();
+    if (!op)
+        return AVERROR(ENOMEM);
+
+    e->queue_in = tq_alloc(1, ENC_FRAMES_IN_FLIGHT, op, frame_move);
+    if (!e->queue_in) {
+        objpool_free(&op);
+        return AVERROR(ENOMEM);
+    }
+
+    op = objpool_alloc_packets();
+    if (!op)
+        goto fail;
+
+    e->queue_out = tq_alloc(2, 2 * ENC_FRAMES_IN_FLIGHT, op, pkt_move);
+    if (!e->queue_out) {
+        objpool_free(&op);
+        goto fail;
+    }
+
+    ret = pthread_create(&e->thread, NULL, encoder_thread, ost);
+    if (ret) {
+        ret = AVERROR(ret);
+        av_log(ost, AV_LOG_ERROR, "pthread_create() failed: %s\n",
+               av_err2str(ret));
+        goto fail;
+    }
+
+    return 0;
+fail:
+    if (ret >= 0)
+        ret = AVERROR(ENOMEM);
+
+    tq_free(&e->queue_in);
+    tq_free(&e->queue_out);
+    return ret;
+}
+
+/* Pass a packet received from the encoder thread to the muxer. */
+static void enc_output_packet(OutputFile *of, OutputStream *ost, AVPacket *pkt)
+{
+    Encoder            *e = ost->enc;
+    AVCodecContext   *enc = ost->enc_ctx;
+    const char *type_desc = av_get_media_type_string(enc->codec_type);
+    int ret;
+
+    if (enc->codec_type == AVMEDIA_TYPE_VIDEO)
+        update_video_stats(ost, pkt, !!vstats_filename);
+    if (ost->enc_stats_post.io)
+        enc_stats_write(ost, &ost->enc_stats_post, NULL, pkt,
+                        e->packets_encoded);
+
+    if (debug_ts) {
+        av_log(ost, AV_LOG_INFO, "encoder -> type:%s "
+               "pkt_pts:%s pkt_pts_time:%s pkt_dts:%s pkt_dts_time:%s "
+               "duration:%s duration_time:%s\n",
+               type_desc,
+               av_ts2str(pkt->pts), av_ts2timestr(pkt->pts, &enc->time_base),
+               av_ts2str(pkt->dts), av_ts2timestr(pkt->dts, &enc->time_base),
+               av_ts2str(pkt->duration), av_ts2timestr(pkt->duration, &enc->time_base));
+    }
+
+    if ((ret = trigger_fix_sub_duration_heartbeat(ost, pkt)) < 0) {
+        av_log(NULL, AV_LOG_ERROR,
+               "Subtitle heartbeat logic failed in %s! (%s)\n",
+               __func__, av_err2str(ret));
+        exit_program(1);
+    }
+
+    e->data_size += pkt->size;
+
+    e->packets_encoded++;
+
+    of_output_packet(of, ost, pkt);
+}
+
+/* Receive output from the encoder thread until at most max_in_flight of the
+ * frames sent to it remain unprocessed.
+ *
+ * @return the first error the encoder thread returned for the processed
+ *         frames, 0 otherwise */
+static int enc_thread_receive(OutputFile *of, OutputStream *ost,
+                              unsigned max_in_flight)
+{
+    Encoder *e = ost->enc;
+    int err = 0;
+
+    while (e->frames_in_flight > max_in_flight) {
+        int idx, ret;
+
+        ret = tq_receive(e->queue_out, &idx, e->pkt);
+        if (ret < 0) {
+            av_log(ost, AV_LOG_ERROR, "Encoder thread terminated unexpectedly\n");
+            return AVERROR_BUG;
         }
 
-        e->data_size += pkt->size;
+        if (idx == 1) {
+            ret = (intptr_t)e->pkt->opaque;
+            av_packet_unref(e->pkt);
 
-        e->packets_encoded++;
+            e->frames_in_flight--;
+            if (ret < 0 && !err)
+                err = ret;
+            continue;
+        }
 
-        of_output_packet(of, ost, pkt);
+        enc_output_packet(of, ost, e->pkt);
+        av_packet_unref(e->pkt);
     }
 
-    av_assert0(0);
+    return err;
+}
+
+static int encode_frame(OutputFile *of, OutputStream *ost, AVFrame *frame)
+{
+    Encoder            *e = ost->enc;
+    AVCodecContext   *enc = ost->enc_ctx;
+    const char *type_desc = av_get_media_type_string(enc->codec_type);
+    int ret;
+
+    if (frame) {
+        if (ost->enc_stats_pre.io)
+            enc_stats_write(ost, &ost->enc_stats_pre, frame, NULL,
+                            ost->frames_encoded);
+
+        ost->frames_encoded++;
+        ost->samples_encoded += frame->nb_samples;
+
+        if (debug_ts) {
+            av_log(ost, AV_LOG_INFO, "encoder <- type:%s "
+                   "frame_pts:%s frame_pts_time:%s time_base:%d/%d\n",
+                   type_desc,
+                   av_ts2str(frame->pts), av_ts2timestr(frame->pts, &enc->time_base),
+                   enc->time_base.num, enc->time_base.den);
+        }
+
+        // the caller may still use the frame, e.g. for duplicating it
+        ret = av_frame_ref(e->send_frame, frame);
+        if (ret < 0)
+            return ret;
+        if (e->sample_aspect_ratio.num)
+            e->send_frame->sample_aspect_ratio = e->sample_aspect_ratio;
+    }
+
+    // an empty frame flushes the encoder
+    ret = tq_send(e->queue_in, 0, e->send_frame);
+    if (ret < 0) {
+        av_frame_unref(e->send_frame);
+        return ret;
+    }
+    e->frames_in_flight++;
+
+    // only wait for the encoder when it falls too far behind, unless flushing,
+    // which needs all the output to be muxed before signalling EOF
+    ret = enc_thread_receive(of, ost, frame ? ENC_FRAMES_IN_FLIGHT - 1 : 0);
+    if (ret == AVERROR_EOF)
+        of_output_packet(of, ost, NULL);
+
+    return ret;
 }
 
 static int submit_encode_frame(OutputFile *of, OutputStream *ost,
@@ -21,6 +21,7 @@
 #include <stdint.h>
 
 #include "ffmpeg.h"
+#include "thread_queue.h"
 
 #include "libavfilter/avfilter.h"
 #include "libavfilter/buffersink.h"
@@ -54,6 +55,40 @@ typedef struct FilterGraphPriv {
 
     // frame for temporarily holding output from the filtergraph
     AVFrame *frame;
+
+    pthread_t       thread;
+    /**
+     * Queue for sending frames and control messages from the main thread to
+     * the filtering thread. Stream i < nb_inputs carries messages for input i,
+     * stream nb_inputs carries messages for the whole graph.
+     */
+    ThreadQueue    *queue_in;
+    /**
+     * Queue for sending filtered frames from the filtering thread to the main
+     * thread. Stream i < nb_outputs carries output i, stream nb_outputs
+     * carries replies signalling that a message has been fully processed.
+     */
+    ThreadQueue    *queue_out;
+
+    // the fields below are only accessed by the main thread
+
+    // a message was sent to the filtering thread and its reply was not
+    // received yet; all the other graph state must not be touched while set
+    int             busy;
+    // frames for sending messages to and receiving output from the
+    // filtering thread
+    AVFrame        *frame_send;
+    AVFrame        *frame_recv;
+
+    // the fields below are only accessed by the filtering thread
+
+    // frame for receiving messages from the main thread
+    AVFrame        *frame_msg;
+    // index of the input that should receive data, set when replying to
+    // FILTER_MSG_CHOOSE_INPUT with CHOOSE_INPUT_INPUT
+    int             best_input;
+    // EOF was signalled on all outputs
+    int             eof;
 } FilterGraphPriv;
 
 static FilterGraphPriv *fgp_from_fg(FilterGraph *fg)
@@ -73,8 +108,8 @@ typedef struct InputFilterPriv {
 
     InputStream *ist;
 
-    // used to hold submitted input
-    AVFrame *frame;
+    // index of this input in the filtergraph
+    int index;
 
     /* for filters that are not yet bound to an input stream,
      * this stores the input linklabel, if any */
@@ -99,6 +134,10 @@ typedef struct InputFilterPriv {
 
     AVRational time_base;
 
+    // number of failed requests on the buffer source, as of the last
+    // FILTER_MSG_CHOOSE_INPUT request
+    unsigned nb_failed_requests;
+
     AVFifo *frame_queue;
 
     AVBufferRef *hw_frames_ctx;
@@ -148,6 +187,11 @@ typedef struct OutputFilterPriv {
     AVRational time_base;
     AVRational sample_aspect_ratio;
 
+    // encoder and compliance level, copied at setup so that the filtering
+    // thread does not read the encoder context
+    const AVCodec *enc_codec;
+    int strict_std_compliance;
+
     // those are only set if no format is specified and the encoder gives us multiple options
     // They point directly to the relevant lists of the encoder.
     const int *formats;
@@ -156,14 +200,61 @@ typedef struct OutputFilterPriv {
 
     // set to 1 after at least one frame passed through this output
     int got_frame;
+
+    // main thread only: set to 1 after at least one filtered frame was
+    // received for this output
+    int got_frame_recv;
 } OutputFilterPriv;
 
+/* Control messages are sent through the thread queues as frames without
+ * data, with the message type stored in AVFrame.opaque. */
+enum FilterMsgType {
+    /* to the filtering thread, on an input stream: EOF on that input, with
+     * the EOF timestamp in pts/time_base
+     * from the filtering thread, on an output stream: EOF on that output */
+    FILTER_MSG_EOF = 1,
+    /* to the filtering thread, on an input stream: sub2video heartbeat, with
+     * the timestamp in pts/time_base */
+    FILTER_MSG_SUB2VIDEO_HEARTBEAT,
+    /* to the filtering thread, on the graph stream: request a frame from the
+     * graph and determine which input needs data to make progress; the reply
+     * is one of the CHOOSE_INPUT_* values or an error code */
+    FILTER_MSG_CHOOSE_INPUT,
+    /* to the filtering thread, on the graph stream: send or queue a filter
+     * command, described by a FilterCommand in buf[0] */
+    FILTER_MSG_COMMAND,
+};
+
+enum {
+    // the graph is not configured and the input fgp->best_input needs data
+    CHOOSE_INPUT_INPUT = 1,
+    // the graph is not configured, but all inputs are initialized or EOF
+    CHOOSE_INPUT_INPUTS_DONE,
+    // the graph produced some output
+    CHOOSE_INPUT_PROGRESS,
+    // all the outputs are finished
+    CHOOSE_INPUT_EOF,
+    // the graph needs more input, nb_failed_requests is updated for all inputs
+    CHOOSE_INPUT_EAGAIN,
+};
+
+typedef struct FilterCommand {
+    char *target;
+    char *command;
+    char *arg;
+
+    double time;
+    int    all_filters;
+} FilterCommand;
+
 static OutputFilterPriv *ofp_from_ofilter(OutputFilter *ofilter)
 {
     return (OutputFilterPriv*)ofilter;
 }
 
 static int configure_filtergraph(FilterGraph *fg);
+static int fg_thread_start(FilterGraph *fg);
+static int fg_thread_stop(FilterGraph *fg);
 
 static int sub2video_get_blank_frame(InputFilterPriv *ifp)
 {
@@ -322,27 +413,28 @@ choose_pixel_fmt(const AVCodec *codec, enum AVPixelFormat target,
  * NULL is returned. The AVBPrint provided should be clean. */
 static const char *choose_pix_fmts(OutputFilter *ofilter, AVBPrint *bprint)
 {
+    OutputFilterPriv *ofp = ofp_from_ofilter(ofilter);
     OutputStream *ost = ofilter->ost;
-    AVCodecContext *enc = ost->enc_ctx;
-    const AVDictionaryEntry *strict_dict = av_dict_get(ost->encoder_opts, "strict", NULL, 0);
-    if (strict_dict)
-        // used by choose_pixel_fmt() and below
-        av_opt_set(ost->enc_ctx, "strict", strict_dict->value, 0);
+    const AVCodec *codec = ofp->enc_codec;
 
+    // this runs in the filtering thread, so only use the encoder parameters
+    // that are fixed before transcoding starts and copied in
+    // ofilter_bind_ost(); the format selected by the encoder is tracked in
+    // ofp->format
      if (ost->keep_pix_fmt) {
-        if (ost->enc_ctx->pix_fmt == AV_PIX_FMT_NONE)
+        if (ofp->format == AV_PIX_FMT_NONE)
             return NULL;
-        return av_get_pix_fmt_name(ost->enc_ctx->pix_fmt);
+        return av_get_pix_fmt_name(ofp->format);
     }
-    if (ost->enc_ctx->pix_fmt != AV_PIX_FMT_NONE) {
-        return av_get_pix_fmt_name(choose_pixel_fmt(enc->codec, enc->pix_fmt,
-                                                    ost->enc_ctx->strict_std_compliance));
-    } else if (enc->codec->pix_fmts) {
+    if (ofp->format != AV_PIX_FMT_NONE) {
+        return av_get_pix_fmt_name(choose_pixel_fmt(codec, ofp->format,
+                                                    ofp->strict_std_compliance));
+    } else if (codec->pix_fmts) {
         const enum AVPixelFormat *p;
 
-        p = enc->codec->pix_fmts;
-        if (ost->enc_ctx->strict_std_compliance > FF_COMPLIANCE_UNOFFICIAL) {
-            p = get_compliance_normal_pix_fmts(enc->codec, p);
+        p = codec->pix_fmts;
+        if (ofp->strict_std_compliance > FF_COMPLIANCE_UNOFFICIAL) {
+            p = get_compliance_normal_pix_fmts(codec, p);
         }
 
         for (; *p != AV_PIX_FMT_NONE; p++) {
@@ -695,7 +787,14 @@ void ofilter_bind_ost(OutputFilter *ofilter, OutputStream *ost)
     av_freep(&ofilter->linklabel);
 
     switch (ost->enc_ctx->codec_type) {
-    case AVMEDIA_TYPE_VIDEO:
+    case AVMEDIA_TYPE_VIDEO: {
+        const AVDictionaryEntry *strict_dict = av_dict_get(ost->encoder_opts, "strict", NULL, 0);
+        if (strict_dict)
+            // used by choose_pix_fmts()
+            av_opt_set(ost->enc_ctx, "strict", strict_dict->value, 0);
+        ofp->enc_codec             = c;
+        ofp->strict_std_compliance = ost->enc_ctx->strict_std_compliance;
+
         ofp->width      = ost->enc_ctx->width;
         ofp->height     = ost->enc_ctx->height;
         if (ost->enc_ctx->pix_fmt != AV_PIX_FMT_NONE) {
@@ -707,6 +806,7 @@ void ofilter_bind_ost(OutputFilter *ofilter, OutputStream *ost)
         fgp->disable_conversions |= ost->keep_pix_fmt;
 
         break;
+        }
     case AVMEDIA_TYPE_AUDIO:
         if (ost->enc_ctx->sample_fmt != AV_SAMPLE_FMT_NONE) {
             ofp->format = ost->enc_ctx->sample_fmt;
@@ -752,10 +852,7 @@ static InputFilter *ifilter_alloc(FilterGraph *fg)
 
     ifilter->graph  = fg;
 
-    ifp->frame = av_frame_alloc();
-    if (!ifp->frame)
-        report_and_exit(AVERROR(ENOMEM));
-
+    ifp->index           = fg->nb_inputs - 1;
     ifp->format          = -1;
     ifp->fallback.format = -1;
 
@@ -775,6 +872,8 @@ void fg_free(FilterGraph **pfg)
         return;
     fgp = fgp_from_fg(fg);
 
+    fg_thread_stop(fg);
+
     avfilter_graph_free(&fg->graph);
     for (int j = 0; j < fg->nb_inputs; j++) {
         InputFilter *ifilter = fg->inputs[j];
@@ -790,8 +889,6 @@ void fg_free(FilterGraph **pfg)
 
         av_channel_layout_uninit(&ifp->fallback.ch_layout);
 
-        av_frame_free(&ifp->frame);
-
         av_buffer_unref(&ifp->hw_frames_ctx);
         av_freep(&ifp->linklabel);
         av_freep(&ifilter->name);
@@ -811,6 +908,9 @@ void fg_free(FilterGraph **pfg)
     av_freep(&fgp->graph_desc);
 
     av_frame_free(&fgp->frame);
+    av_frame_free(&fgp->frame_send);
+    av_frame_free(&fgp->frame_recv);
+    av_frame_free(&fgp->frame_msg);
 
     av_freep(pfg);
 }
@@ -845,8 +945,11 @@ FilterGraph *fg_create(char *graph_desc)
 
     snprintf(fgp->log_name, sizeof(fgp->log_name), "fc#%d", fg->index);
 
-    fgp->frame = av_frame_alloc();
-    if (!fgp->frame)
+    fgp->frame      = av_frame_alloc();
+    fgp->frame_send = av_frame_alloc();
+    fgp->frame_recv = av_frame_alloc();
+    fgp->frame_msg  = av_frame_alloc();
+    if (!fgp->frame || !fgp->frame_send || !fgp->frame_recv || !fgp->frame_msg)
         report_and_exit(AVERROR(ENOMEM));
 
     /* this graph is only used for determining the kinds of inputs
@@ -889,6 +992,8 @@ FilterGraph *fg_create(char *graph_desc)
         goto fail;
     }
 
+    ret = fg_thread_start(fg);
+
 fail:
     avfilter_inout_free(&inputs);
     avfilter_inout_free(&outputs);
@@ -1729,61 +1834,49 @@ int filtergraph_is_simple(const FilterGraph *fg)
     return fgp->is_simple;
 }
 
-int reap_filters(int flush)
+/* Send all the frames currently available on the outputs to the main thread.
+ * Runs in the filtering thread. */
+static int read_frames(FilterGraph *fg)
 {
-    /* Reap all buffers present in the buffer sinks */
-    for (OutputStream *ost = ost_iter(NULL); ost; ost = ost_iter(ost)) {
-        OutputFilterPriv *ofp;
-        FilterGraphPriv *fgp;
-        AVFrame *filtered_frame;
-        AVFilterContext *filter;
-        int ret = 0;
+    FilterGraphPriv *fgp = fgp_from_fg(fg);
+    AVFrame *frame = fgp->frame;
+    int ret;
 
-        if (!ost->filter || !ost->filter->graph->graph)
-            continue;
-        fgp    = fgp_from_fg(ost->filter->graph);
-        ofp    = ofp_from_ofilter(ost->filter);
-        filter = ofp->filter;
+    if (!fg->graph)
+        return 0;
 
-        filtered_frame = fgp->frame;
+    for (int i = 0; i < fg->nb_outputs; i++) {
+        OutputFilter *ofilter = fg->outputs[i];
+        OutputFilterPriv *ofp = ofp_from_ofilter(ofilter);
+        AVFilterContext *filter = ofp->filter;
 
         while (1) {
             FrameData *fd;
 
-            ret = av_buffersink_get_frame_flags(filter, filtered_frame,
+            ret = av_buffersink_get_frame_flags(filter, frame,
                                                AV_BUFFERSINK_FLAG_NO_REQUEST);
             if (ret < 0) {
-                if (ret != AVERROR(EAGAIN) && ret != AVERROR_EOF) {
+                if (ret != AVERROR(EAGAIN) && ret != AVERROR_EOF)
                     av_log(fgp, AV_LOG_WARNING,
                            "Error in av_buffersink_get_frame_flags(): %s\n", av_err2str(ret));
-                } else if (flush && ret == AVERROR_EOF && ofp->got_frame &&
-                           av_buffersink_get_type(filter) == AVMEDIA_TYPE_VIDEO)
-                    enc_frame(ost, NULL);
-
                 break;
             }
-            if (ost->finished) {
-                av_frame_unref(filtered_frame);
-                continue;
-            }
 
-            if (filtered_frame->pts != AV_NOPTS_VALUE) {
+            if (frame->pts != AV_NOPTS_VALUE) {
                 AVRational tb = av_buffersink_get_time_base(filter);
-                ost->filter->last_pts = av_rescale_q(filtered_frame->pts, tb,
-                                                     AV_TIME_BASE_Q);
-                filtered_frame->time_base = tb;
+                frame->time_base = tb;
 
                 if (debug_ts)
                     av_log(fgp, AV_LOG_INFO, "filter_raw -> pts:%s pts_time:%s time_base:%d/%d\n",
-                           av_ts2str(filtered_frame->pts),
-                           av_ts2timestr(filtered_frame->pts, &tb),
+                           av_ts2str(frame->pts),
+                           av_ts2timestr(frame->pts, &tb),
                            tb.num, tb.den);
             }
 
-            fd = frame_data(filtered_frame);
+            fd = frame_data(frame);
             if (!fd) {
-                av_frame_unref(filtered_frame);
-                report_and_exit(AVERROR(ENOMEM));
+                av_frame_unref(frame);
+                return AVERROR(ENOMEM);
             }
 
             // only use bits_per_raw_sample passed through from the decoder
@@ -1791,24 +1884,90 @@ int reap_filters(int flush)
             if (!fgp->is_meta)
                 fd->bits_per_raw_sample = 0;
 
-            if (ost->type == AVMEDIA_TYPE_VIDEO)
+            if (ofilter->ost->type == AVMEDIA_TYPE_VIDEO)
                 fd->frame_rate_filter = av_buffersink_get_frame_rate(filter);
 
-            enc_frame(ost, filtered_frame);
-            av_frame_unref(filtered_frame);
             ofp->got_frame = 1;
+
+            ret = tq_send(fgp->queue_out, i, frame);
+            if (ret < 0) {
+                av_frame_unref(frame);
+                return ret;
+            }
         }
     }
 
     return 0;
 }
 
-void ifilter_sub2video_heartbeat(InputFilter *ifilter, int64_t pts, AVRational tb)
+/* Signal EOF on all outputs to the main thread. Runs in the filtering thread. */
+static int send_outputs_eof(FilterGraph *fg)
+{
+    FilterGraphPriv *fgp = fgp_from_fg(fg);
+    AVFrame *frame = fgp->frame;
+    int ret;
+
+    if (fgp->eof)
+        return 0;
+    fgp->eof = 1;
+
+    ret = read_frames(fg);
+    if (ret < 0)
+        return ret;
+
+    for (int i = 0; i < fg->nb_outputs; i++) {
+        OutputFilter *ofilter = fg->outputs[i];
+        OutputFilterPriv *ofp = ofp_from_ofilter(ofilter);
+
+        // we are finished and no frames were ever seen at this output,
+        // at least initialize the encoder with a dummy frame
+        if (!ofp->got_frame) {
+            frame->time_base   = ofp->time_base;
+            frame->format      = ofp->format;
+
+            frame->width               = ofp->width;
+            frame->height              = ofp->height;
+            frame->sample_aspect_ratio = ofp->sample_aspect_ratio;
+
+            frame->sample_rate = ofp->sample_rate;
+            if (ofp->ch_layout.nb_channels) {
+                ret = av_channel_layout_copy(&frame->ch_layout, &ofp->ch_layout);
+                if (ret < 0) {
+                    av_frame_unref(frame);
+                    return ret;
+                }
+            }
+
+            av_assert0(!frame->buf[0]);
+
+            av_log(ofilter->ost, AV_LOG_WARNING,
+                   "No filtered frames for output stream, trying to "
+                   "initialize anyway.\n");
+
+            ret = tq_send(fgp->queue_out, i, frame);
+            if (ret < 0) {
+                av_frame_unref(frame);
+                return ret;
+            }
+        }
+
+        frame->opaque = (void*)(intptr_t)FILTER_MSG_EOF;
+
+        ret = tq_send(fgp->queue_out, i, frame);
+        if (ret < 0) {
+            av_frame_unref(frame);
+            return ret;
+        }
+    }
+
+    return 0;
+}
+
+static void sub2video_heartbeat(InputFilterPriv *ifp, int64_t pts, AVRational tb)
 {
-    InputFilterPriv *ifp = ifp_from_ifilter(ifilter);
     int64_t pts2;
 
-    if (!ifilter->graph->graph)
+    if (!ifp->ifilter.graph->graph)
         return;
 
     /* subtitles seem to be usually muxed ahead of other streams;
@@ -1829,12 +1988,11 @@ void ifilter_sub2video_heartbeat(InputFilter *ifilter, int64_t pts, AVRational t
         sub2video_push_ref(ifp, pts2);
 }
 
-int ifilter_sub2video(InputFilter *ifilter, const AVFrame *frame)
+static int sub2video_frame(InputFilterPriv *ifp, AVFrame *frame)
 {
-    InputFilterPriv *ifp = ifp_from_ifilter(ifilter);
     int ret;
 
-    if (ifilter->graph->graph) {
+    if (ifp->ifilter.graph->graph) {
         if (!frame) {
             if (ifp->sub2video.end_pts < INT64_MAX)
                 sub2video_update(ifp, INT64_MAX, NULL);
@@ -1862,9 +2020,9 @@ int ifilter_sub2video(InputFilter *ifilter, const AVFrame *frame)
     return 0;
 }
 
-int ifilter_send_eof(InputFilter *ifilter, int64_t pts, AVRational tb)
+static int send_eof(FilterGraph *fg, InputFilterPriv *ifp,
+                    int64_t pts, AVRational tb)
 {
-    InputFilterPriv *ifp = ifp_from_ifilter(ifilter);
     int ret;
 
     ifp->eof = 1;
@@ -1890,8 +2048,8 @@ int ifilter_send_eof(InputFilter *ifilter, int64_t pts, AVRational tb)
             if (ret < 0)
                 return ret;
 
-            if (ifilter_has_all_input_formats(ifilter->graph)) {
-                ret = configure_filtergraph(ifilter->graph);
+            if (ifilter_has_all_input_formats(fg)) {
+                ret = configure_filtergraph(fg);
                 if (ret < 0) {
                     av_log(NULL, AV_LOG_ERROR, "Error initializing filters!\n");
                     return ret;
@@ -1910,10 +2068,9 @@ int ifilter_send_eof(InputFilter *ifilter, int64_t pts, AVRational tb)
     return 0;
 }
 
-int ifilter_send_frame(InputFilter *ifilter, AVFrame *frame, int keep_reference)
+static int send_frame(FilterGraph *fg, InputFilterPriv *ifp, AVFrame *frame)
 {
-    InputFilterPriv *ifp = ifp_from_ifilter(ifilter);
-    FilterGraph *fg = ifilter->graph;
+    InputFilter *ifilter = &ifp->ifilter;
     AVFrameSideData *sd;
     int need_reinit, ret;
 
@@ -1965,7 +2122,7 @@ int ifilter_send_frame(InputFilter *ifilter, AVFrame *frame, int keep_reference)
             return ret;
         }
 
-        ret = reap_filters(0);
+        ret = read_frames(fg);
         if (ret < 0 && ret != AVERROR_EOF) {
             av_log(fg, AV_LOG_ERROR, "Error while filtering: %s\n", av_err2str(ret));
             return ret;
@@ -1978,14 +2135,6 @@ int ifilter_send_frame(InputFilter *ifilter, AVFrame *frame, int keep_reference)
         }
     }
 
-    if (keep_reference) {
-        ret = av_frame_ref(ifp->frame, frame);
-        if (ret < 0)
-            return ret;
-    } else
-        av_frame_move_ref(ifp->frame, frame);
-    frame = ifp->frame;
-
     frame->pts       = av_rescale_q(frame->pts,      frame->time_base, ifp->time_base);
     frame->duration  = av_rescale_q(frame->duration, frame->time_base, ifp->time_base);
     frame->time_base = ifp->time_base;
@@ -2007,93 +2156,475 @@ int ifilter_send_frame(InputFilter *ifilter, AVFrame *frame, int keep_reference)
     return 0;
 }
 
-int fg_transcode_step(FilterGraph *graph, InputStream **best_ist)
+static int choose_input(FilterGraph *fg)
 {
-    FilterGraphPriv *fgp = fgp_from_fg(graph);
-    int i, ret;
-    int nb_requests, nb_requests_max = 0;
-    InputStream *ist;
+    FilterGraphPriv *fgp = fgp_from_fg(fg);
+    int ret;
 
-    if (!graph->graph) {
-        for (int i = 0; i < graph->nb_inputs; i++) {
-            InputFilter *ifilter = graph->inputs[i];
-            InputFilterPriv *ifp = ifp_from_ifilter(ifilter);
+    if (!fg->graph) {
+        for (int i = 0; i < fg->nb_inputs; i++) {
+            InputFilterPriv *ifp = ifp_from_ifilter(fg->inputs[i]);
             if (ifp->format < 0 && !ifp->eof) {
-                *best_ist = ifp->ist;
-                return 0;
+                fgp->best_input = i;
+                return CHOOSE_INPUT_INPUT;
             }
         }
 
-        // graph not configured, but all inputs are either initialized or EOF
-        for (int i = 0; i < graph->nb_outputs; i++)
-            graph->outputs[i]->ost->inputs_done = 1;
-
-        return 0;
+        return CHOOSE_INPUT_INPUTS_DONE;
     }
 
-    *best_ist = NULL;
-    ret = avfilter_graph_request_oldest(graph->graph);
-    if (ret >= 0)
-        return reap_filters(0);
+    ret = avfilter_graph_request_oldest(fg->graph);
+    if (ret >= 0) {
+        ret = read_frames(fg);
+        return ret < 0 ? ret : CHOOSE_INPUT_PROGRESS;
+    }
 
     if (ret == AVERROR_EOF) {
-        reap_filters(1);
-        for (int i = 0; i < graph->nb_outputs; i++) {
-            OutputFilter *ofilter = graph->outputs[i];
-            OutputFilterPriv *ofp = ofp_from_ofilter(ofilter);
-
-            // we are finished and no frames were ever seen at this output,
-            // at least initialize the encoder with a dummy frame
-            if (!ofp->got_frame) {
-                AVFrame *frame = fgp->frame;
-
-                frame->time_base   = ofp->time_base;
-                frame->format      = ofp->format;
-
-                frame->width               = ofp->width;
-                frame->height              = ofp->height;
-                frame->sample_aspect_ratio = ofp->sample_aspect_ratio;
-
-                frame->sample_rate = ofp->sample_rate;
-                if (ofp->ch_layout.nb_channels) {
-                    ret = av_channel_layout_copy(&frame->ch_layout, &ofp->ch_layout);
-                    if (ret < 0)
-                        return ret;
-                }
+        ret = send_outputs_eof(fg);
+        return ret < 0 ? ret : CHOOSE_INPUT_EOF;
+    }
+    if (ret != AVERROR(EAGAIN))
+        return ret;
 
-                av_assert0(!frame->buf[0]);
+    for (int i = 0; i < fg->nb_inputs; i++) {
+        InputFilterPriv *ifp = ifp_from_ifilter(fg->inputs[i]);
+        ifp->nb_failed_requests = av_buffersrc_get_nb_failed_requests(ifp->filter);
+    }
 
-                av_log(ofilter->ost, AV_LOG_WARNING,
-                       "No filtered frames for output stream, trying to "
-                       "initialize anyway.\n");
+    return CHOOSE_INPUT_EAGAIN;
+}
 
-                enc_open(ofilter->ost, frame);
-                av_frame_unref(frame);
+static void send_command(FilterGraph *fg, const FilterCommand *fc)
+{
+    int ret;
+
+    if (!fg->graph)
+        return;
+
+    if (fc->time < 0) {
+        char response[4096];
+        ret = avfilter_graph_send_command(fg->graph, fc->target, fc->command, fc->arg,
+                                          response, sizeof(response),
+                                          fc->all_filters ? 0 : AVFILTER_CMD_FLAG_ONE);
+        fprintf(stderr, "Command reply for stream %d: ret:%d res:\n%s",
+                fg->index, ret, response);
+    } else if (!fc->all_filters) {
+        fprintf(stderr, "Queuing commands only on filters supporting the specific command is unsupported\n");
+    } else {
+        ret = avfilter_graph_queue_command(fg->graph, fc->target, fc->command, fc->arg, 0, fc->time);
+        if (ret < 0)
+            fprintf(stderr, "Queuing command failed with error %s\n", av_err2str(ret));
+    }
+}
+
+static int filter_message(FilterGraph *fg, int idx, AVFrame *frame)
+{
+    intptr_t msg;
+    int ret;
+
+    if (idx == fg->nb_inputs) {
+        msg = (intptr_t)frame->opaque;
+
+        switch (msg) {
+        case FILTER_MSG_CHOOSE_INPUT:
+            return choose_input(fg);
+        case FILTER_MSG_COMMAND:
+            send_command(fg, (const FilterCommand*)frame->buf[0]->data);
+            return read_frames(fg);
+        default:
+            av_assert0(0);
+            return AVERROR_BUG;
+        }
+    } else {
+        InputFilterPriv *ifp = ifp_from_ifilter(fg->inputs[idx]);
+
+        msg = frame->buf[0] ? 0 : (intptr_t)frame->opaque;
+
+        if (msg == FILTER_MSG_SUB2VIDEO_HEARTBEAT) {
+            sub2video_heartbeat(ifp, frame->pts, frame->time_base);
+            ret = 0;
+        } else if (ifp->type_src == AVMEDIA_TYPE_SUBTITLE) {
+            ret = sub2video_frame(ifp, msg == FILTER_MSG_EOF ? NULL : frame);
+        } else if (msg == FILTER_MSG_EOF) {
+            ret = send_eof(fg, ifp, frame->pts, frame->time_base);
+        } else
+            ret = send_frame(fg, ifp, frame);
+
+        // EOF from the filtergraph inputs is not an error
+        if (ret < 0 && ret != AVERROR_EOF)
+            return ret;
+
+        return read_frames(fg);
+    }
+}
+
+static void *filter_thread(void *arg)
+{
+    FilterGraph *fg = arg;
+    FilterGraphPriv *fgp = fgp_from_fg(fg);
+    AVFrame *frame = fgp->frame_msg;
+    int ret = 0;
+
+    while (1) {
+        int idx;
+
+        ret = tq_receive(fgp->queue_in, &idx, frame);
+        if (ret < 0) {
+            // all the inputs were finished by the main thread, we are done
+            if (idx < 0) {
+                ret = 0;
+                break;
             }
+            continue;
+        }
+
+        ret = filter_message(fg, idx, frame);
+        av_frame_unref(frame);
 
-            close_output_stream(ofilter->ost);
+        // reply to the main thread with the result of processing the message
+        frame->opaque = (void*)(intptr_t)ret;
+        ret = tq_send(fgp->queue_out, fg->nb_outputs, frame);
+        if (ret < 0) {
+            av_frame_unref(frame);
+            // the main thread stopped receiving our output
+            if (ret == AVERROR_EOF)
+                ret = 0;
+            break;
         }
+    }
+
+    for (int i = 0; i <= fg->nb_inputs; i++)
+        tq_receive_finish(fgp->queue_in, i);
+    for (int i = 0; i <= fg->nb_outputs; i++)
+        tq_send_finish(fgp->queue_out, i);
+
+    return (void*)(intptr_t)ret;
+}
+
+static int fg_thread_stop(FilterGraph *fg)
+{
+    FilterGraphPriv *fgp = fgp_from_fg(fg);
+    void *ret;
+
+    if (!fgp->queue_in)
         return 0;
+
+    for (int i = 0; i <= fg->nb_inputs; i++)
+        tq_send_finish(fgp->queue_in, i);
+    for (int i = 0; i <= fg->nb_outputs; i++)
+        tq_receive_finish(fgp->queue_out, i);
+
+    pthread_join(fgp->thread, &ret);
+
+    tq_free(&fgp->queue_in);
+    tq_free(&fgp->queue_out);
+
+    return (intptr_t)ret;
+}
+
+static int fg_thread_start(FilterGraph *fg)
+{
+    FilterGraphPriv *fgp = fgp_from_fg(fg);
+    ObjPool *op;
+    int ret = 0;
+
+    op = objpool_alloc_frames();
+    if (!op)
+        return AVERROR(ENOMEM);
+
+    // the main thread never has more than one message in flight
+    fgp->queue_in = tq_alloc(fg->nb_inputs + 1, 1, op, frame_move);
+    if (!fgp->queue_in) {
+        objpool_free(&op);
+        return AVERROR(ENOMEM);
     }
-    if (ret != AVERROR(EAGAIN))
+
+    op = objpool_alloc_frames();
+    if (!op)
+        goto fail;
+
+    fgp->queue_out = tq_alloc(fg->nb_outputs + 1, 8, op, frame_move);
+    if (!fgp->queue_out) {
+        objpool_free(&op);
+        goto fail;
+    }
+
+    ret = pthread_create(&fgp->thread, NULL, filter_thread, fg);
+    if (ret) {
+        ret = AVERROR(ret);
+        av_log(fg, AV_LOG_ERROR, "pthread_create() failed: %s\n",
+               av_err2str(ret));
+        goto fail;
+    }
+
+    return 0;
+fail:
+    if (ret >= 0)
+        ret = AVERROR(ENOMEM);
+
+    tq_free(&fgp->queue_in);
+    tq_free(&fgp->queue_out);
+    return ret;
+}
+
+/* Pass a frame received from the filtering thread to its encoder.
+ * Runs in the main thread. */
+static void fg_output_frame(FilterGraph *fg, int idx, AVFrame *frame)
+{
+    OutputFilter *ofilter = fg->outputs[idx];
+    OutputFilterPriv *ofp = ofp_from_ofilter(ofilter);
+    OutputStream *ost = ofilter->ost;
+
+    if (frame->buf[0]) {
+        if (ost->finished) {
+            av_frame_unref(frame);
+            return;
+        }
+
+        if (frame->pts != AV_NOPTS_VALUE)
+            ofilter->last_pts = av_rescale_q(frame->pts, frame->time_base,
+                                             AV_TIME_BASE_Q);
+
+        enc_frame(ost, frame);
+        av_frame_unref(frame);
+        ofp->got_frame_recv = 1;
+    } else if ((intptr_t)frame->opaque == FILTER_MSG_EOF) {
+        if (ofp->got_frame_recv && ost->type == AVMEDIA_TYPE_VIDEO)
+            enc_frame(ost, NULL);
+
+        close_output_stream(ost);
+    } else {
+        // no frames were ever seen at this output, this frame only carries
+        // the output parameters
+        enc_open(ost, frame);
+        av_frame_unref(frame);
+    }
+}
+
+/* Wait until the filtering thread is done with the last message sent to it,
+ * passing all its output to the encoders.
+ *
+ * @return the filtering thread's reply to the message, <0 on error */
+static int fg_wait(FilterGraph *fg)
+{
+    FilterGraphPriv *fgp = fgp_from_fg(fg);
+    AVFrame *frame = fgp->frame_recv;
+
+    while (fgp->busy) {
+        int idx, ret;
+
+        ret = tq_receive(fgp->queue_out, &idx, frame);
+        if (ret < 0) {
+            fgp->busy = 0;
+            av_log(fg, AV_LOG_ERROR, "Filtering thread terminated unexpectedly\n");
+            return AVERROR_BUG;
+        }
+
+        if (idx == fg->nb_outputs) {
+            fgp->busy = 0;
+            ret = (intptr_t)frame->opaque;
+            av_frame_unref(frame);
+            return ret;
+        }
+
+        fg_output_frame(fg, idx, frame);
+    }
+
+    return 0;
+}
+
+/* Send a message to the filtering thread, once it is done with the previous
+ * one. The frame is consumed even on failure. */
+static int fg_send(FilterGraph *fg, int idx, AVFrame *frame)
+{
+    FilterGraphPriv *fgp = fgp_from_fg(fg);
+    int ret;
+
+    ret = fg_wait(fg);
+    if (ret < 0)
+        goto fail;
+
+    ret = tq_send(fgp->queue_in, idx, frame);
+    if (ret < 0)
+        goto fail;
+
+    fgp->busy = 1;
+
+    return 0;
+fail:
+    av_frame_unref(frame);
+    return ret;
+}
+
+int reap_filters(void)
+{
+    for (OutputStream *ost = ost_iter(NULL); ost; ost = ost_iter(ost)) {
+        int ret;
+
+        if (!ost->filter)
+            continue;
+
+        ret = fg_wait(ost->filter->graph);
+        if (ret < 0)
+            return ret;
+    }
+
+    return 0;
+}
+
+int ifilter_sub2video_heartbeat(InputFilter *ifilter, int64_t pts, AVRational tb)
+{
+    InputFilterPriv *ifp = ifp_from_ifilter(ifilter);
+    FilterGraphPriv *fgp = fgp_from_fg(ifilter->graph);
+    AVFrame *frame = fgp->frame_send;
+
+    frame->opaque    = (void*)(intptr_t)FILTER_MSG_SUB2VIDEO_HEARTBEAT;
+    frame->pts       = pts;
+    frame->time_base = tb;
+
+    return fg_send(ifilter->graph, ifp->index, frame);
+}
+
+int ifilter_sub2video(InputFilter *ifilter, const AVFrame *frame)
+{
+    InputFilterPriv *ifp = ifp_from_ifilter(ifilter);
+    FilterGraphPriv *fgp = fgp_from_fg(ifilter->graph);
+    int ret;
+
+    if (frame) {
+        ret = av_frame_ref(fgp->frame_send, frame);
+        if (ret < 0)
+            return ret;
+    } else
+        fgp->frame_send->opaque = (void*)(intptr_t)FILTER_MSG_EOF;
+
+    return fg_send(ifilter->graph, ifp->index, fgp->frame_send);
+}
+
+int ifilter_send_eof(InputFilter *ifilter, int64_t pts, AVRational tb)
+{
+    InputFilterPriv *ifp = ifp_from_ifilter(ifilter);
+    FilterGraphPriv *fgp = fgp_from_fg(ifilter->graph);
+    AVFrame *frame = fgp->frame_send;
+
+    frame->opaque    = (void*)(intptr_t)FILTER_MSG_EOF;
+    frame->pts       = pts;
+    frame->time_base = tb;
+
+    return fg_send(ifilter->graph, ifp->index, frame);
+}
+
+int ifilter_send_frame(InputFilter *ifilter, AVFrame *frame, int keep_reference)
+{
+    InputFilterPriv *ifp = ifp_from_ifilter(ifilter);
+    FilterGraphPriv *fgp = fgp_from_fg(ifilter->graph);
+    int ret;
+
+    if (keep_reference) {
+        ret = av_frame_ref(fgp->frame_send, frame);
+        if (ret < 0)
+            return ret;
+        frame = fgp->frame_send;
+    }
+
+    return fg_send(ifilter->graph, ifp->index, frame);
+}
+
+static void filter_command_free(void *opaque, uint8_t *data)
+{
+    FilterCommand *fc = (FilterCommand*)data;
+
+    av_freep(&fc->target);
+    av_freep(&fc->command);
+    av_freep(&fc->arg);
+
+    av_free(data);
+}
+
+int fg_send_command(FilterGraph *fg, double time, const char *target,
+                    const char *command, const char *arg, int all_filters)
+{
+    FilterGraphPriv *fgp = fgp_from_fg(fg);
+    AVFrame *frame = fgp->frame_send;
+    FilterCommand *fc;
+
+    fc = av_mallocz(sizeof(*fc));
+    if (!fc)
+        return AVERROR(ENOMEM);
+
+    frame->buf[0] = av_buffer_create((uint8_t*)fc, sizeof(*fc),
+                                     filter_command_free, NULL, 0);
+    if (!frame->buf[0]) {
+        av_freep(&fc);
+        return AVERROR(ENOMEM);
+    }
+
+    fc->target  = av_strdup(target);
+    fc->command = av_strdup(command);
+    fc->arg     = av_strdup(arg);
+    if (!fc->target || !fc->command || !fc->arg) {
+        av_frame_unref(frame);
+        return AVERROR(ENOMEM);
+    }
+
+    fc->time        = time;
+    fc->all_filters = all_filters;
+
+    frame->opaque = (void*)(intptr_t)FILTER_MSG_COMMAND;
+
+    return fg_send(fg, fg->nb_inputs, frame);
+}
+
+int fg_transcode_step(FilterGraph *graph, InputStream **best_ist)
+{
+    FilterGraphPriv *fgp = fgp_from_fg(graph);
+    AVFrame *frame = fgp->frame_send;
+    unsigned nb_requests_max = 0;
+    int ret;
+
+    frame->opaque = (void*)(intptr_t)FILTER_MSG_CHOOSE_INPUT;
+    ret = fg_send(graph, graph->nb_inputs, frame);
+    if (ret < 0)
         return ret;
 
-    for (i = 0; i < graph->nb_inputs; i++) {
+    ret = fg_wait(graph);
+    if (ret < 0)
+        return ret;
+
+    // the filtering thread is idle now, so its state may be inspected
+    switch (ret) {
+    case CHOOSE_INPUT_INPUT:
+        *best_ist = ifp_from_ifilter(graph->inputs[fgp->best_input])->ist;
+        return 0;
+    case CHOOSE_INPUT_INPUTS_DONE:
+        // graph not configured, but all inputs are either initialized or EOF
+        for (int i = 0; i < graph->nb_outputs; i++)
+            graph->outputs[i]->ost->inputs_done = 1;
+        return 0;
+    case CHOOSE_INPUT_PROGRESS:
+    case CHOOSE_INPUT_EOF:
+        *best_ist = NULL;
+        return 0;
+    }
+
+    av_assert0(ret == CHOOSE_INPUT_EAGAIN);
+
+    *best_ist = NULL;
+    for (int i = 0; i < graph->nb_inputs; i++) {
         InputFilter *ifilter = graph->inputs[i];
         InputFilterPriv *ifp = ifp_from_ifilter(ifilter);
+        InputStream *ist = ifp->ist;
 
-        ist = ifp->ist;
         if (input_files[ist->file_index]->eagain || ifp->eof)
             continue;
-        nb_requests = av_buffersrc_get_nb_failed_requests(ifp->filter);
-        if (nb_requests > nb_requests_max) {
-            nb_requests_max = nb_requests;
+        if (ifp->nb_failed_requests > nb_requests_max) {
+            nb_requests_max = ifp->nb_failed_requests;
             *best_ist = ist;
         }
     }
 
     if (!*best_ist)
-        for (i = 0; i < graph->nb_outputs; i++)
+        for (int i = 0; i < graph->nb_outputs; i++)
             graph->outputs[i]->ost->unavailable = 1;
 
     return 0;
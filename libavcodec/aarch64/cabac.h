@@ -99,6 +99,88 @@ static av_always_inline int get_cabac_inline_aarch64(CABACContext *c,
     return bit & 1;
 }
 
+#define get_cabac_bypass get_cabac_bypass_aarch64
+static av_always_inline int get_cabac_bypass_aarch64(CABACContext *c)
+{
+    int bit, tmp;
+
+    __asm__ volatile(
+        "lsl        %w[low]       , %w[low]     , #1            \n\t"
+        "tst        %w[low]       , #0xFFFF                     \n\t"
+        "b.ne       1f                                          \n\t"
+        "ldrh       %w[tmp]       , [%[ptr]]                    \n\t"
+#if UNCHECKED_BITSTREAM_READER
+        "add        %[ptr]        , %[ptr]      , #2            \n\t"
+#else
+        "cmp        %[ptr]        , %[end]                      \n\t"
+        "cinc       %[ptr]        , %[ptr]      , lo            \n\t"
+        "cinc       %[ptr]        , %[ptr]      , lo            \n\t"
+#endif
+        "rev16      %w[tmp]       , %w[tmp]                     \n\t"
+        "add        %w[low]       , %w[low]     , %w[tmp], lsl #1 \n\t"
+        "sub        %w[low]       , %w[low]     , #0x10, lsl #12 \n\t"
+        "add        %w[low]       , %w[low]     , #1            \n\t"
+        "1:                                                     \n\t"
+        "lsl        %w[tmp]       , %w[range]   , #17           \n\t"
+        "cmp        %w[low]       , %w[tmp]                     \n\t"
+        "csel       %w[tmp]       , %w[tmp]     , wzr      , hs \n\t"
+        "cset       %w[bit]       , hs                          \n\t"
+        "sub        %w[low]       , %w[low]     , %w[tmp]       \n\t"
+        :   [bit]"=&r"(bit),
+            [tmp]"=&r"(tmp),
+            [low]"+&r"(c->low),
+            [ptr]"+&r"(c->bytestream)
+        : [range]"r"(c->range)
+#if !UNCHECKED_BITSTREAM_READER
+        , [end]"r"(c->bytestream_end)
+#endif
+        : "memory", "cc"
+        );
+
+    return bit;
+}
+
+#define get_cabac_bypass_sign get_cabac_bypass_sign_aarch64
+static av_always_inline int get_cabac_bypass_sign_aarch64(CABACContext *c, int val)
+{
+    int tmp;
+
+    __asm__ volatile(
+        "lsl        %w[low]       , %w[low]     , #1            \n\t"
+        "tst        %w[low]       , #0xFFFF                     \n\t"
+        "b.ne       1f                                          \n\t"
+        "ldrh       %w[tmp]       , [%[ptr]]                    \n\t"
+#if UNCHECKED_BITSTREAM_READER
+        "add        %[ptr]        , %[ptr]      , #2            \n\t"
+#else
+        "cmp        %[ptr]        , %[end]                      \n\t"
+        "cinc       %[ptr]        , %[ptr]      , lo            \n\t"
+        "cinc       %[ptr]        , %[ptr]      , lo            \n\t"
+#endif
+        "rev16      %w[tmp]       , %w[tmp]                     \n\t"
+        "add        %w[low]       , %w[low]     , %w[tmp], lsl #1 \n\t"
+        "sub        %w[low]       , %w[low]     , #0x10, lsl #12 \n\t"
+        "add        %w[low]       , %w[low]     , #1            \n\t"
+        "1:                                                     \n\t"
+        "lsl        %w[tmp]       , %w[range]   , #17           \n\t"
+        "cmp        %w[low]       , %w[tmp]                     \n\t"
+        "csel       %w[tmp]       , %w[tmp]     , wzr      , hs \n\t"
+        "cneg       %w[val]       , %w[val]     , lo            \n\t"
+        "sub        %w[low]       , %w[low]     , %w[tmp]       \n\t"
+        :   [val]"+&r"(val),
+            [tmp]"=&r"(tmp),
+            [low]"+&r"(c->low),
+            [ptr]"+&r"(c->bytestream)
+        : [range]"r"(c->range)
+#if !UNCHECKED_BITSTREAM_READER
+        , [end]"r"(c->bytestream_end)
+#endif
+        : "memory", "cc"
+        );
+
+    return val;
+}
+
 #endif /* HAVE_INLINE_ASM */
 
 #endif /* AVCODEC_AARCH64_CABAC_H */
@@ -42,6 +42,20 @@ void ff_avg_h264_chroma_mc4_neon(uint8_t *dst, const uint8_t *src, ptrdiff_t str
 void ff_avg_h264_chroma_mc2_neon(uint8_t *dst, const uint8_t *src, ptrdiff_t stride,
                                  int h, int x, int y);
 
+void ff_put_h264_chroma_mc8_neon_10(uint8_t *dst, const uint8_t *src, ptrdiff_t stride,
+                                    int h, int x, int y);
+void ff_put_h264_chroma_mc4_neon_10(uint8_t *dst, const uint8_t *src, ptrdiff_t stride,
+                                    int h, int x, int y);
+void ff_put_h264_chroma_mc2_neon_10(uint8_t *dst, const uint8_t *src, ptrdiff_t stride,
+                                    int h, int x, int y);
+
+void ff_avg_h264_chroma_mc8_neon_10(uint8_t *dst, const uint8_t *src, ptrdiff_t stride,
+                                    int h, int x, int y);
+void ff_avg_h264_chroma_mc4_neon_10(uint8_t *dst, const uint8_t *src, ptrdiff_t stride,
+                                    int h, int x, int y);
+void ff_avg_h264_chroma_mc2_neon_10(uint8_t *dst, const uint8_t *src, ptrdiff_t stride,
+                                    int h, int x, int y);
+
 av_cold void ff_h264chroma_init_aarch64(H264ChromaContext *c, int bit_depth)
 {
     const int high_bit_depth = bit_depth > 8;
@@ -55,5 +69,13 @@ av_cold void ff_h264chroma_init_aarch64(H264ChromaContext *c, int bit_depth)
         c->avg_h264_chroma_pixels_tab[0] = ff_avg_h264_chroma_mc8_neon;
         c->avg_h264_chroma_pixels_tab[1] = ff_avg_h264_chroma_mc4_neon;
         c->avg_h264_chroma_pixels_tab[2] = ff_avg_h264_chroma_mc2_neon;
+    } else if (have_neon(cpu_flags) && bit_depth <= 10) {
+        c->put_h264_chroma_pixels_tab[0] = ff_put_h264_chroma_mc8_neon_10;
+        c->put_h264_chroma_pixels_tab[1] = ff_put_h264_chroma_mc4_neon_10;
+        c->put_h264_chroma_pixels_tab[2] = ff_put_h264_chroma_mc2_neon_10;
+
+        c->avg_h264_chroma_pixels_tab[0] = ff_avg_h264_chroma_mc8_neon_10;
+        c->avg_h264_chroma_pixels_tab[1] = ff_avg_h264_chroma_mc4_neon_10;
+        c->avg_h264_chroma_pixels_tab[2] = ff_avg_h264_chroma_mc2_neon_10;
     }
 }
@@ -38,6 +38,18 @@ void ff_hevc_h_loop_filter_chroma_10_neon(uint8_t *_pix, ptrdiff_t _stride,
                                           const int *_tc, const uint8_t *_no_p, const uint8_t *_no_q);
 void ff_hevc_h_loop_filter_chroma_12_neon(uint8_t *_pix, ptrdiff_t _stride,
                                           const int *_tc, const uint8_t *_no_p, const uint8_t *_no_q);
+void ff_hevc_v_loop_filter_luma_8_neon(uint8_t *_pix, ptrdiff_t _stride, int _beta,
+                                       const int *_tc, const uint8_t *_no_p, const uint8_t *_no_q);
+void ff_hevc_v_loop_filter_luma_10_neon(uint8_t *_pix, ptrdiff_t _stride, int _beta,
+                                        const int *_tc, const uint8_t *_no_p, const uint8_t *_no_q);
+void ff_hevc_v_loop_filter_luma_12_neon(uint8_t *_pix, ptrdiff_t _stride, int _beta,
+                                        const int *_tc, const uint8_t *_no_p, const uint8_t *_no_q);
+void ff_hevc_h_loop_filter_luma_8_neon(uint8_t *_pix, ptrdiff_t _stride, int _beta,
+                                       const int *_tc, const uint8_t *_no_p, const uint8_t *_no_q);
+void ff_hevc_h_loop_filter_luma_10_neon(uint8_t *_pix, ptrdiff_t _stride, int _beta,
+                                        const int *_tc, const uint8_t *_no_p, const uint8_t *_no_q);
+void ff_hevc_h_loop_filter_luma_12_neon(uint8_t *_pix, ptrdiff_t _stride, int _beta,
+                                        const int *_tc, const uint8_t *_no_p, const uint8_t *_no_q);
 void ff_hevc_add_residual_4x4_8_neon(uint8_t *_dst, const int16_t *coeffs,
                                      ptrdiff_t stride);
 void ff_hevc_add_residual_4x4_10_neon(uint8_t *_dst, const int16_t *coeffs,
@@ -199,6 +211,54 @@ NEON8_FNPROTO_PARTIAL_5(qpel_uni_w_hv, (uint8_t *_dst,  ptrdiff_t _dststride,
         int height, int denom, int wx, int ox,
         intptr_t mx, intptr_t my, int width), _i8mm);
 
+#define NEON16_FNPROTO(fn, args) \
+    void ff_hevc_put_hevc_##fn##_10_neon args; \
+    void ff_hevc_put_hevc_##fn##_12_neon args; \
+
+#define NEON16_MC_FNPROTO(type, dir) \
+    NEON16_FNPROTO(type##_##dir, (int16_t *dst, \
+        const uint8_t *_src, ptrdiff_t _srcstride, \
+        int height, intptr_t mx, intptr_t my, int width)) \
+    NEON16_FNPROTO(type##_uni_##dir, (uint8_t *_dst, ptrdiff_t _dststride, \
+        const uint8_t *_src, ptrdiff_t _srcstride, \
+        int height, intptr_t mx, intptr_t my, int width)) \
+    NEON16_FNPROTO(type##_bi_##dir, (uint8_t *_dst, ptrdiff_t _dststride, \
+        const uint8_t *_src, ptrdiff_t _srcstride, const int16_t *src2, \
+        int height, intptr_t mx, intptr_t my, int width)) \
+    NEON16_FNPROTO(type##_uni_w_##dir, (uint8_t *_dst, ptrdiff_t _dststride, \
+        const uint8_t *_src, ptrdiff_t _srcstride, \
+        int height, int denom, int wx, int ox, \
+        intptr_t mx, intptr_t my, int width)) \
+    NEON16_FNPROTO(type##_bi_w_##dir, (uint8_t *_dst, ptrdiff_t _dststride, \
+        const uint8_t *_src, ptrdiff_t _srcstride, const int16_t *src2, \
+        int height, int denom, int wx0, int wx1, int ox0, int ox1, \
+        intptr_t mx, intptr_t my, int width))
+
+NEON16_MC_FNPROTO(qpel, h)
+NEON16_MC_FNPROTO(qpel, v)
+NEON16_MC_FNPROTO(qpel, hv)
+NEON16_MC_FNPROTO(epel, h)
+NEON16_MC_FNPROTO(epel, v)
+NEON16_MC_FNPROTO(epel, hv)
+
+NEON16_FNPROTO(pel_pixels, (int16_t *dst,
+        const uint8_t *_src, ptrdiff_t _srcstride,
+        int height, intptr_t mx, intptr_t my, int width))
+NEON16_FNPROTO(pel_uni_pixels, (uint8_t *_dst, ptrdiff_t _dststride,
+        const uint8_t *_src, ptrdiff_t _srcstride,
+        int height, intptr_t mx, intptr_t my, int width))
+NEON16_FNPROTO(pel_bi_pixels, (uint8_t *_dst, ptrdiff_t _dststride,
+        const uint8_t *_src, ptrdiff_t _srcstride, const int16_t *src2,
+        int height, intptr_t mx, intptr_t my, int width))
+NEON16_FNPROTO(pel_uni_w_pixels, (uint8_t *_dst, ptrdiff_t _dststride,
+        const uint8_t *_src, ptrdiff_t _srcstride,
+        int height, int denom, int wx, int ox,
+        intptr_t mx, intptr_t my, int width))
+NEON16_FNPROTO(pel_bi_w_pixels, (uint8_t *_dst, ptrdiff_t _dststride,
+        const uint8_t *_src, ptrdiff_t _srcstride, const int16_t *src2,
+        int height, int denom, int wx0, int wx1, int ox0, int ox1,
+        intptr_t mx, intptr_t my, int width))
+
 #define NEON8_FNASSIGN(member, v, h, fn, ext) \
         member[1][v][h] = ff_hevc_put_hevc_##fn##4_8_neon##ext;  \
         member[2][v][h] = ff_hevc_put_hevc_##fn##6_8_neon##ext;  \
@@ -225,12 +285,49 @@ NEON8_FNPROTO_PARTIAL_5(qpel_uni_w_hv, (uint8_t *_dst,  ptrdiff_t _dststride,
         member[7][v][h] = ff_hevc_put_hevc_##fn##32_8_neon##ext; \
         member[9][v][h] = ff_hevc_put_hevc_##fn##64_8_neon##ext;
 
+/* The 10 and 12 bit functions take the width as a parameter */
+#define NEON16_FNASSIGN(member, v, h, fn, depth) \
+        member[0][v][h] = \
+        member[1][v][h] = \
+        member[2][v][h] = \
+        member[3][v][h] = \
+        member[4][v][h] = \
+        member[5][v][h] = \
+        member[6][v][h] = \
+        member[7][v][h] = \
+        member[8][v][h] = \
+        member[9][v][h] = ff_hevc_put_hevc_##fn##_##depth##_neon;
+
+#define NEON16_MC_FNASSIGN(type, depth) \
+        NEON16_FNASSIGN(c->put_hevc_##type,          0, 0, pel_pixels,        depth); \
+        NEON16_FNASSIGN(c->put_hevc_##type##_uni,    0, 0, pel_uni_pixels,    depth); \
+        NEON16_FNASSIGN(c->put_hevc_##type##_bi,     0, 0, pel_bi_pixels,     depth); \
+        NEON16_FNASSIGN(c->put_hevc_##type##_uni_w,  0, 0, pel_uni_w_pixels,  depth); \
+        NEON16_FNASSIGN(c->put_hevc_##type##_bi_w,   0, 0, pel_bi_w_pixels,   depth); \
+        NEON16_FNASSIGN(c->put_hevc_##type,          0, 1, type##_h,          depth); \
+        NEON16_FNASSIGN(c->put_hevc_##type##_uni,    0, 1, type##_uni_h,      depth); \
+        NEON16_FNASSIGN(c->put_hevc_##type##_bi,     0, 1, type##_bi_h,       depth); \
+        NEON16_FNASSIGN(c->put_hevc_##type##_uni_w,  0, 1, type##_uni_w_h,    depth); \
+        NEON16_FNASSIGN(c->put_hevc_##type##_bi_w,   0, 1, type##_bi_w_h,     depth); \
+        NEON16_FNASSIGN(c->put_hevc_##type,          1, 0, type##_v,          depth); \
+        NEON16_FNASSIGN(c->put_hevc_##type##_uni,    1, 0, type##_uni_v,      depth); \
+        NEON16_FNASSIGN(c->put_hevc_##type##_bi,     1, 0, type##_bi_v,       depth); \
+        NEON16_FNASSIGN(c->put_hevc_##type##_uni_w,  1, 0, type##_uni_w_v,    depth); \
+        NEON16_FNASSIGN(c->put_hevc_##type##_bi_w,   1, 0, type##_bi_w_v,     depth); \
+        NEON16_FNASSIGN(c->put_hevc_##type,          1, 1, type##_hv,         depth); \
+        NEON16_FNASSIGN(c->put_hevc_##type##_uni,    1, 1, type##_uni_hv,     depth); \
+        NEON16_FNASSIGN(c->put_hevc_##type##_bi,     1, 1, type##_bi_hv,      depth); \
+        NEON16_FNASSIGN(c->put_hevc_##type##_uni_w,  1, 1, type##_uni_w_hv,   depth); \
+        NEON16_FNASSIGN(c->put_hevc_##type##_bi_w,   1, 1, type##_bi_w_hv,    depth);
+
 av_cold void ff_hevc_dsp_init_aarch64(HEVCDSPContext *c, const int bit_depth)
 {
     int cpu_flags = av_get_cpu_flags();
     if (!have_neon(cpu_flags)) return;
 
     if (bit_depth == 8) {
+        c->hevc_h_loop_filter_luma     = ff_hevc_h_loop_filter_luma_8_neon;
+        c->hevc_v_loop_filter_luma     = ff_hevc_v_loop_filter_luma_8_neon;
         c->hevc_h_loop_filter_chroma   = ff_hevc_h_loop_filter_chroma_8_neon;
         c->hevc_v_loop_filter_chroma   = ff_hevc_v_loop_filter_chroma_8_neon;
         c->add_residual[0]             = ff_hevc_add_residual_4x4_8_neon;
@@ -302,6 +399,8 @@ av_cold void ff_hevc_dsp_init_aarch64(HEVCDSPContext *c, const int bit_depth)
 
     }
     if (bit_depth == 10) {
+        c->hevc_h_loop_filter_luma     = ff_hevc_h_loop_filter_luma_10_neon;
+        c->hevc_v_loop_filter_luma     = ff_hevc_v_loop_filter_luma_10_neon;
         c->hevc_h_loop_filter_chroma   = ff_hevc_h_loop_filter_chroma_10_neon;
         c->hevc_v_loop_filter_chroma   = ff_hevc_v_loop_filter_chroma_10_neon;
         c->add_residual[0]             = ff_hevc_add_residual_4x4_10_neon;
@@ -316,13 +415,21 @@ av_cold void ff_hevc_dsp_init_aarch64(HEVCDSPContext *c, const int bit_depth)
         c->idct_dc[1]                  = ff_hevc_idct_8x8_dc_10_neon;
         c->idct_dc[2]                  = ff_hevc_idct_16x16_dc_10_neon;
         c->idct_dc[3]                  = ff_hevc_idct_32x32_dc_10_neon;
+
+        NEON16_MC_FNASSIGN(qpel, 10);
+        NEON16_MC_FNASSIGN(epel, 10);
     }
     if (bit_depth == 12) {
+        c->hevc_h_loop_filter_luma     = ff_hevc_h_loop_filter_luma_12_neon;
+        c->hevc_v_loop_filter_luma     = ff_hevc_v_loop_filter_luma_12_neon;
         c->hevc_h_loop_filter_chroma   = ff_hevc_h_loop_filter_chroma_12_neon;
         c->hevc_v_loop_filter_chroma   = ff_hevc_v_loop_filter_chroma_12_neon;
         c->add_residual[0]             = ff_hevc_add_residual_4x4_12_neon;
         c->add_residual[1]             = ff_hevc_add_residual_8x8_12_neon;
         c->add_residual[2]             = ff_hevc_add_residual_16x16_12_neon;
         c->add_residual[3]             = ff_hevc_add_residual_32x32_12_neon;
+
+        NEON16_MC_FNASSIGN(qpel, 12);
+        NEON16_MC_FNASSIGN(epel, 12);
     }
 }
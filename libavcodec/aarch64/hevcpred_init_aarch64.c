@@ -0,0 +1,79 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "libavutil/attributes.h"
+#include "libavutil/cpu.h"
+#include "libavutil/aarch64/cpu.h"
+#include "libavcodec/hevcpred.h"
+
+#define PRED_FUNCS(depth)                                                                    \
+void ff_hevc_pred_planar_0_ ## depth ## _neon(uint8_t *src, const uint8_t *top,              \
+                                              const uint8_t *left, ptrdiff_t stride);        \
+void ff_hevc_pred_planar_1_ ## depth ## _neon(uint8_t *src, const uint8_t *top,              \
+                                              const uint8_t *left, ptrdiff_t stride);        \
+void ff_hevc_pred_planar_2_ ## depth ## _neon(uint8_t *src, const uint8_t *top,              \
+                                              const uint8_t *left, ptrdiff_t stride);        \
+void ff_hevc_pred_planar_3_ ## depth ## _neon(uint8_t *src, const uint8_t *top,              \
+                                              const uint8_t *left, ptrdiff_t stride);        \
+void ff_hevc_pred_dc_ ## depth ## _neon(uint8_t *src, const uint8_t *top,                    \
+                                        const uint8_t *left, ptrdiff_t stride,               \
+                                        int log2_size, int c_idx);                           \
+void ff_hevc_pred_angular_0_ ## depth ## _neon(uint8_t *src, const uint8_t *top,             \
+                                               const uint8_t *left, ptrdiff_t stride,        \
+                                               int c_idx, int mode);                         \
+void ff_hevc_pred_angular_1_ ## depth ## _neon(uint8_t *src, const uint8_t *top,             \
+                                               const uint8_t *left, ptrdiff_t stride,        \
+                                               int c_idx, int mode);                         \
+void ff_hevc_pred_angular_2_ ## depth ## _neon(uint8_t *src, const uint8_t *top,             \
+                                               const uint8_t *left, ptrdiff_t stride,        \
+                                               int c_idx, int mode);                         \
+void ff_hevc_pred_angular_3_ ## depth ## _neon(uint8_t *src, const uint8_t *top,             \
+                                               const uint8_t *left, ptrdiff_t stride,        \
+                                               int c_idx, int mode);
+
+PRED_FUNCS(8)
+PRED_FUNCS(10)
+
+#define PRED_INIT(depth)                                                  \
+    do {                                                                  \
+        hpc->pred_planar[0]  = ff_hevc_pred_planar_0_  ## depth ## _neon; \
+        hpc->pred_planar[1]  = ff_hevc_pred_planar_1_  ## depth ## _neon; \
+        hpc->pred_planar[2]  = ff_hevc_pred_planar_2_  ## depth ## _neon; \
+        hpc->pred_planar[3]  = ff_hevc_pred_planar_3_  ## depth ## _neon; \
+        hpc->pred_dc         = ff_hevc_pred_dc_        ## depth ## _neon; \
+        hpc->pred_angular[0] = ff_hevc_pred_angular_0_ ## depth ## _neon; \
+        hpc->pred_angular[1] = ff_hevc_pred_angular_1_ ## depth ## _neon; \
+        hpc->pred_angular[2] = ff_hevc_pred_angular_2_ ## depth ## _neon; \
+        hpc->pred_angular[3] = ff_hevc_pred_angular_3_ ## depth ## _neon; \
+    } while (0)
+
+av_cold void ff_hevc_pred_init_aarch64(HEVCPredContext *hpc, int bit_depth)
+{
+    int cpu_flags = av_get_cpu_flags();
+
+    if (!have_neon(cpu_flags))
+        return;
+
+    if (bit_depth == 8)
+        PRED_INIT(8);
+    else if (bit_depth == 10)
+        PRED_INIT(10);
+}
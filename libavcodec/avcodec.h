@@ -410,6 +410,15 @@ typedef struct RcOverride{
  * Do not apply film grain, export it instead.
  */
 #define AV_CODEC_EXPORT_DATA_FILM_GRAIN (1 << 3)
+/**
+ * Decoding only.
+ * Track how many rows of the frames allocated by the decoder have been
+ * decoded, so that a frame obtained before it is output (i.e. from
+ * draw_horiz_band()) can be read while it is being decoded, see
+ * avcodec_get_row_progress(). Decoders that do not report rows complete the
+ * progress when they output or drop the frame.
+ */
+#define AV_CODEC_EXPORT_DATA_ROW_PROGRESS (1 << 4)
 
 /**
  * The decoder will keep a reference to the frame and may reuse it later.
@@ -664,6 +673,11 @@ typedef struct AVCodecContext {
      * at the same time; threads might draw different parts of the same AVFrame,
      * or multiple AVFrames, and there is no guarantee that slices will be drawn
      * in order.
+     * With frame threading, it is called from the frame threads as soon as rows
+     * of a frame are finished, i.e. before the frame is returned by
+     * avcodec_receive_frame(). The AVFrame is the one passed to get_buffer2(),
+     * so it can be matched by its buffers or, with AV_CODEC_FLAG_COPY_OPAQUE,
+     * by its opaque fields.
      * The function is also used by hardware acceleration APIs.
      * It is called at least once during frame decoding to pass
      * the data needed for hardware render.
@@ -2102,6 +2116,22 @@ typedef struct AVCodecContext {
      *   an error.
      */
     int64_t frame_num;
+
+    /**
+     * A reference to a thread pool created with av_codec_thread_pool_alloc().
+     * If set, frame threads run as jobs on this pool instead of on threads
+     * of their own; thread_count still sets how many frames are decoded at
+     * once. Setting the same pool on several decoders bounds the number of
+     * threads they use together. Slice threading is not affected.
+     * Decoders that may use a hwaccel requiring its frame threads to wait
+     * for the caller keep threads of their own, so that they cannot hold
+     * the workers of the pool.
+     *
+     * - decoding: May be set by the caller before avcodec_open2(). Owned and
+     *             freed by libavcodec after that.
+     * - encoding: unused
+     */
+    AVBufferRef *thread_pool;
 } AVCodecContext;
 
 /**
@@ -2575,6 +2605,36 @@ int avcodec_default_get_buffer2(AVCodecContext *s, AVFrame *frame, int flags);
  */
 int avcodec_default_get_encode_buffer(AVCodecContext *s, AVPacket *pkt, int flags);
 
+/**
+ * Get the decoding progress of a frame passed to
+ * AVCodecContext.draw_horiz_band(), with AV_CODEC_EXPORT_DATA_ROW_PROGRESS
+ * set in AVCodecContext.export_side_data.
+ *
+ * The progress counts rows of the frame as allocated by the decoder, i.e. of
+ * the coded picture before the cropping described by the crop_* fields of
+ * the frame is applied. It is completed when the decoder outputs the frame,
+ * and also when it drops the frame on errors or flushing, so a frame which is
+ * never output can be only partly decoded once complete.
+ *
+ * @param frame the frame passed to draw_horiz_band()
+ * @return a new reference to the progress, which is opaque and must only be
+ *         passed to avcodec_row_progress_await() and av_buffer_unref(), or
+ *         NULL if the frame has no progress attached or on allocation failure
+ */
+AVBufferRef *avcodec_get_row_progress(const AVFrame *frame);
+
+/**
+ * Wait until at least the first rows luma rows of a frame are decoded.
+ * This must not be called from the thread decoding the frame, e.g. from
+ * draw_horiz_band().
+ *
+ * @param progress a reference returned by avcodec_get_row_progress()
+ * @param rows     the number of rows to wait for, INT_MAX for the whole frame
+ * @return the number of rows decoded so far, which may be more than rows,
+ *         or INT_MAX once the frame is complete
+ */
+int avcodec_row_progress_await(AVBufferRef *progress, int rows);
+
 /**
  * Modify width and height values so that they will result in a memory
  * buffer that is acceptable for the codec if you do not use any horizontal
@@ -3190,6 +3250,17 @@ int avcodec_default_execute(AVCodecContext *c, int (*func)(AVCodecContext *c2, v
 int avcodec_default_execute2(AVCodecContext *c, int (*func)(AVCodecContext *c2, void *arg2, int, int),void *arg, int *ret, int count);
 //FIXME func typedef
 
+/**
+ * Allocate a pool of worker threads which can be shared by frame threaded
+ * decoders through AVCodecContext.thread_pool.
+ *
+ * @param nb_threads number of worker threads, or 0 for one per CPU
+ * @return a reference to the pool, or NULL on failure or if libavcodec was
+ *         built without threading support. The threads exit when the last
+ *         reference is unreferenced.
+ */
+AVBufferRef *av_codec_thread_pool_alloc(int nb_threads);
+
 /**
  * Fill AVFrame audio data and linesize pointers.
  *
@@ -55,6 +55,24 @@
 #   include "loongarch/cabac.h"
 #endif
 
+/**
+ * Shortest run of bypass bins decoded with a divide in
+ * get_cabac_bypass_bits().
+ *
+ * A refill yields at most CABAC_BITS - 1 bins for one 64-bit divide, a
+ * count trailing zeros and a multiply. The divide dominates; its latency
+ * is data dependent, up to 36 cycles on Cortex-A72 and 20 on Cortex-A76
+ * according to their optimization guides, and shorter for the small
+ * quotients produced here. The per-bin path of get_cabac_bypass() is a
+ * dependent chain of 3-4 single-cycle instructions on those cores. The
+ * batch thus pays off from 6-10 bins, in line with the cut-over measured
+ * on x86 (even at 8 bins, slower below). Not tuned on aarch64 hardware;
+ * arches may override it.
+ */
+#ifndef CABAC_BYPASS_BATCH_MIN
+#define CABAC_BYPASS_BATCH_MIN 8
+#endif
+
 static const uint8_t * const ff_h264_norm_shift = ff_h264_cabac_tables + H264_NORM_SHIFT_OFFSET;
 static const uint8_t * const ff_h264_lps_range = ff_h264_cabac_tables + H264_LPS_RANGE_OFFSET;
 static const uint8_t * const ff_h264_mlps_state = ff_h264_cabac_tables + H264_MLPS_STATE_OFFSET;
@@ -180,6 +198,50 @@ static av_always_inline int get_cabac_bypass_sign(CABACContext *c, int val){
 }
 #endif
 
+/**
+ * Decode n consecutive bypass bins, the first one ending up in the most
+ * significant bit of the result.
+ *
+ * Decoding bypass bins is a restoring division of the offset by the
+ * range, so longer runs are produced by a single divide per refill
+ * instead of one compare and subtract per bin.
+ *
+ * @param n number of bins, at most 32
+ */
+static av_always_inline unsigned get_cabac_bypass_bits(CABACContext *c, int n)
+{
+    unsigned val = 0;
+
+    // the divide only pays off for longer runs of bins
+    if (n < CABAC_BYPASS_BATCH_MIN) {
+        while (n--)
+            val = (val << 1) | get_cabac_bypass(c);
+        return val;
+    }
+
+    while (n > 0) {
+        // shifts left before the low CABAC_BITS of c->low run empty
+        int k = FFMIN(n, CABAC_BITS - 1 - ff_ctz(c->low));
+
+        if (k > 0) {
+            uint64_t low   = (uint64_t)c->low   << k;
+            uint64_t range = (uint64_t)c->range << (CABAC_BITS + 1);
+            unsigned q     = low / range;
+
+            // c->low == range is not rejected by ff_init_cabac_decoder()
+            q     -= q >> k;
+            c->low = low - q * range;
+            val    = (val << k) | q;
+            n     -= k;
+        }
+        if (n > 0) {
+            val = (val << 1) | get_cabac_bypass(c);
+            n--;
+        }
+    }
+    return val;
+}
+
 /**
  * @return the number of bytes read or 0 if no end
  */
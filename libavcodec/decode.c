@@ -18,6 +18,7 @@
  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
  */
 
+#include <stdatomic.h>
 #include <stdint.h>
 #include <string.h>
 
@@ -39,6 +40,7 @@
 #include "libavutil/internal.h"
 #include "libavutil/intmath.h"
 #include "libavutil/opt.h"
+#include "libavutil/thread.h"
 
 #include "avcodec.h"
 #include "avcodec_internal.h"
@@ -633,6 +635,8 @@ static int decode_receive_frame_internal(AVCodecContext *avctx, AVFrame *frame)
 
     if (!ret) {
         if (avctx->codec_type == AVMEDIA_TYPE_VIDEO) {
+            ff_decode_report_rows(frame, INT_MAX);
+
             if (!frame->width)
                 frame->width = avctx->width;
             if (!frame->height)
@@ -1519,10 +1523,116 @@ static void validate_avframe_allocation(AVCodecContext *avctx, AVFrame *frame)
     }
 }
 
+typedef struct RowProgress {
+    atomic_int rows;
+#if HAVE_THREADS
+    pthread_mutex_t mutex;
+    pthread_cond_t  cond;
+#endif
+} RowProgress;
+
+static void row_progress_free(void *opaque, uint8_t *data)
+{
+#if HAVE_THREADS
+    RowProgress *p = (RowProgress *)data;
+
+    pthread_cond_destroy(&p->cond);
+    pthread_mutex_destroy(&p->mutex);
+#endif
+    av_free(data);
+}
+
+static AVBufferRef *row_progress_alloc(void)
+{
+    RowProgress *p = av_mallocz(sizeof(*p));
+    AVBufferRef *buf;
+
+    if (!p)
+        return NULL;
+    atomic_init(&p->rows, 0);
+#if HAVE_THREADS
+    if (pthread_mutex_init(&p->mutex, NULL)) {
+        av_free(p);
+        return NULL;
+    }
+    if (pthread_cond_init(&p->cond, NULL)) {
+        pthread_mutex_destroy(&p->mutex);
+        av_free(p);
+        return NULL;
+    }
+#endif
+
+    buf = av_buffer_create((uint8_t *)p, sizeof(*p), row_progress_free, NULL, 0);
+    if (!buf)
+        row_progress_free(NULL, (uint8_t *)p);
+    return buf;
+}
+
+static void row_progress_report(RowProgress *p, int rows)
+{
+    if (atomic_load_explicit(&p->rows, memory_order_relaxed) >= rows)
+        return;
+
+#if HAVE_THREADS
+    pthread_mutex_lock(&p->mutex);
+    if (atomic_load_explicit(&p->rows, memory_order_relaxed) < rows) {
+        atomic_store_explicit(&p->rows, rows, memory_order_release);
+        pthread_cond_broadcast(&p->cond);
+    }
+    pthread_mutex_unlock(&p->mutex);
+#else
+    atomic_store_explicit(&p->rows, rows, memory_order_release);
+#endif
+}
+
+void ff_decode_report_rows(const AVFrame *frame, int rows)
+{
+    const FrameDecodeData *fdd;
+
+    if (!frame->private_ref)
+        return;
+    fdd = (const FrameDecodeData *)frame->private_ref->data;
+    if (fdd->row_progress)
+        row_progress_report((RowProgress *)fdd->row_progress->data, rows);
+}
+
+AVBufferRef *avcodec_get_row_progress(const AVFrame *frame)
+{
+    const FrameDecodeData *fdd;
+
+    if (!frame->private_ref)
+        return NULL;
+    fdd = (const FrameDecodeData *)frame->private_ref->data;
+    return fdd->row_progress ? av_buffer_ref(fdd->row_progress) : NULL;
+}
+
+int avcodec_row_progress_await(AVBufferRef *progress, int rows)
+{
+    RowProgress *p = (RowProgress *)progress->data;
+    int ret = atomic_load_explicit(&p->rows, memory_order_acquire);
+
+#if HAVE_THREADS
+    if (ret < rows) {
+        pthread_mutex_lock(&p->mutex);
+        while ((ret = atomic_load_explicit(&p->rows, memory_order_acquire)) < rows)
+            pthread_cond_wait(&p->cond, &p->mutex);
+        pthread_mutex_unlock(&p->mutex);
+    }
+#endif
+    return ret;
+}
+
 static void decode_data_free(void *opaque, uint8_t *data)
 {
     FrameDecodeData *fdd = (FrameDecodeData*)data;
 
+    /* the decoder is done with the frame, whether it was fully decoded
+     * or not, so nobody may wait for its rows forever */
+    if (fdd->row_progress) {
+        row_progress_report((RowProgress *)fdd->row_progress->data, INT_MAX);
+        av_buffer_unref(&fdd->row_progress);
+    }
+
     if (fdd->post_process_opaque_free)
         fdd->post_process_opaque_free(fdd->post_process_opaque);
 
@@ -1621,6 +1731,17 @@ FF_ENABLE_DEPRECATION_WARNINGS
     if (ret < 0)
         goto fail;
 
+    if (avctx->codec_type == AVMEDIA_TYPE_VIDEO && !hwaccel &&
+        (avctx->export_side_data & AV_CODEC_EXPORT_DATA_ROW_PROGRESS)) {
+        FrameDecodeData *fdd = (FrameDecodeData *)frame->private_ref->data;
+
+        fdd->row_progress = row_progress_alloc();
+        if (!fdd->row_progress) {
+            ret = AVERROR(ENOMEM);
+            goto fail;
+        }
+    }
+
 end:
     if (avctx->codec_type == AVMEDIA_TYPE_VIDEO && !override_dimensions &&
         !(ffcodec(avctx->codec)->caps_internal & FF_CODEC_CAP_EXPORTS_CROPPING)) {
@@ -51,6 +51,12 @@ typedef struct FrameDecodeData {
      */
     void *hwaccel_priv;
     void (*hwaccel_priv_free)(void *priv);
+
+    /**
+     * Decoding progress of the frame with AV_CODEC_EXPORT_DATA_ROW_PROGRESS,
+     * shared with the callers of avcodec_get_row_progress().
+     */
+    AVBufferRef *row_progress;
 } FrameDecodeData;
 
 /**
@@ -85,6 +91,14 @@ int ff_decode_get_hw_frames_ctx(AVCodecContext *avctx,
 
 int ff_attach_decode_data(AVFrame *frame);
 
+/**
+ * Report that the first rows luma rows of a frame allocated with
+ * ff_get_buffer() are decoded, waking up the callers of
+ * avcodec_row_progress_await() waiting for them. INT_MAX marks the frame
+ * as complete. Does nothing without AV_CODEC_EXPORT_DATA_ROW_PROGRESS.
+ */
+void ff_decode_report_rows(const AVFrame *frame, int rows);
+
 /**
  * Check whether the side-data of src contains a palette of
  * size AVPALETTE_SIZE; if so, copy it to dst and return 1;
@@ -28,6 +28,7 @@
 #include "libavutil/avassert.h"
 #include "error_resilience.h"
 #include "avcodec.h"
+#include "decode.h"
 #include "h264dec.h"
 #include "mpegutils.h"
 #include "thread.h"
@@ -255,6 +256,8 @@ int ff_h264_field_end(H264Context *h, H264SliceContext *sl, int in_setup)
     if (!in_setup && !h->droppable)
         ff_thread_report_progress(&cur->tf, INT_MAX,
                                   h->picture_structure == PICT_BOTTOM_FIELD);
+    if (!in_setup && (!FIELD_PICTURE(h) || !h->first_field))
+        ff_decode_report_rows(cur->f, INT_MAX);
     emms_c();
 
     h->current_slice = 0;
@@ -1294,6 +1294,14 @@ static int h264_select_output_frame(H264Context *h)
     cur->mmco_reset = h->mmco_reset;
     h->mmco_reset = 0;
 
+    /* Intra keyframes decoded in isolation need no reordering and are
+     * correct on their own, even after a recovery point SEI. */
+    if (h->keyframes_only) {
+        cur->recovered     = 1;
+        h->next_output_pic = cur;
+        return 0;
+    }
+
     if (sps->bitstream_restriction_flag ||
         h->avctx->strict_std_compliance >= FF_COMPLIANCE_STRICT) {
         h->avctx->has_b_frames = FFMAX(h->avctx->has_b_frames, sps->num_reorder_frames);
@@ -1497,7 +1505,9 @@ static int h264_field_start(H264Context *h, const H264SliceContext *sl,
         }
     }
 
-    while (h->poc.frame_num != h->poc.prev_frame_num && !h->first_field &&
+    /* with keyframes_only the gaps are just the skipped pictures, which
+     * the intra keyframes do not need concealed */
+    while (h->poc.frame_num != h->poc.prev_frame_num && !h->first_field && !h->keyframes_only &&
            h->poc.frame_num != (h->poc.prev_frame_num + 1) % (1 << sps->log2_max_frame_num)) {
         const H264Picture *prev = h->short_ref_count ? h->short_ref[0] : NULL;
         av_log(h->avctx, AV_LOG_DEBUG, "Frame num gap %d %d\n",
@@ -1572,6 +1582,7 @@ static int h264_field_start(H264Context *h, const H264SliceContext *sl,
             /* Previous field is unmatched. Don't display it, but let it
              * remain for reference if marked as such. */
             h->missing_fields ++;
+            ff_decode_report_rows(h->cur_pic_ptr->f, INT_MAX);
             h->cur_pic_ptr = NULL;
             h->first_field = FIELD_PICTURE(h);
         } else {
@@ -1583,6 +1594,7 @@ static int h264_field_start(H264Context *h, const H264SliceContext *sl,
                  * Consider this field first in pair. Throw away previous
                  * one except for reference purposes. */
                 h->first_field = 1;
+                ff_decode_report_rows(h->cur_pic_ptr->f, INT_MAX);
                 h->cur_pic_ptr = NULL;
             } else if (h->cur_pic_ptr->reference & DELAYED_PIC_REF) {
                 /* This frame was already output, we cannot draw into it
@@ -2110,6 +2122,7 @@ int ff_h264_queue_decode_slice(H264Context *h, const H2645NAL *nal)
             (h->avctx->skip_frame >= AVDISCARD_BIDIR  && sl->slice_type_nos == AV_PICTURE_TYPE_B) ||
             (h->avctx->skip_frame >= AVDISCARD_NONINTRA && sl->slice_type_nos != AV_PICTURE_TYPE_I) ||
             (h->avctx->skip_frame >= AVDISCARD_NONKEY && h->nal_unit_type != H264_NAL_IDR_SLICE && h->sei.recovery_point.recovery_frame_cnt < 0) ||
+            (h->keyframes_only && sl->slice_type_nos != AV_PICTURE_TYPE_I) ||
             h->avctx->skip_frame >= AVDISCARD_ALL) {
             return 0;
         }
@@ -36,6 +36,7 @@
 #include "libavutil/video_enc_params.h"
 
 #include "codec_internal.h"
+#include "decode.h"
 #include "internal.h"
 #include "error_resilience.h"
 #include "avcodec.h"
@@ -111,6 +112,12 @@ void ff_h264_draw_horiz_band(const H264Context *h, H264SliceContext *sl,
 
     height = FFMIN(height, avctx->height - y);
 
+    /* rows are only complete once both fields are, and slice threads
+     * finish them out of order */
+    if ((!field_pic || !h->first_field) && !h->er.error_occurred &&
+        !(avctx->active_thread_type & FF_THREAD_SLICE))
+        ff_decode_report_rows(src, y + height);
+
     if (field_pic && h->first_field && !(avctx->slice_flags & SLICE_FLAG_ALLOW_FIELD))
         return;
 
@@ -450,6 +457,7 @@ void ff_h264_flush_change(H264Context *h)
 
     h->poc.prev_frame_num = -1;
     if (h->cur_pic_ptr) {
+        ff_decode_report_rows(h->cur_pic_ptr->f, INT_MAX);
         h->cur_pic_ptr->reference = 0;
         for (j=i=0; h->delayed_pic[i]; i++)
             if (h->delayed_pic[i] != h->cur_pic_ptr)
@@ -576,6 +584,7 @@ static int decode_nal_units(H264Context *h, const uint8_t *buf, int buf_size)
     AVCodecContext *const avctx = h->avctx;
     int nals_needed = 0; ///< number of NALs that need decoding before the next frame thread starts
     int idr_cleared=0;
+    int has_idr = 0;
     int i, ret = 0;
 
     h->has_slice = 0;
@@ -609,6 +618,11 @@ static int decode_nal_units(H264Context *h, const uint8_t *buf, int buf_size)
     if (nals_needed < 0)
         return nals_needed;
 
+    if (h->keyframes_only) {
+        for (i = 0; i < h->pkt.nb_nals; i++)
+            has_idr |= h->pkt.nals[i].type == H264_NAL_IDR_SLICE;
+    }
+
     for (i = 0; i < h->pkt.nb_nals; i++) {
         H2645NAL *nal = &h->pkt.nals[i];
         int max_slice_ctx, err;
@@ -617,6 +631,17 @@ static int decode_nal_units(H264Context *h, const uint8_t *buf, int buf_size)
             nal->ref_idc == 0 && nal->type != H264_NAL_SEI)
             continue;
 
+        /* With keyframes_only, SEI is only needed to find recovery points
+         * in packets without an IDR picture, and non-IDR slices are only
+         * decoded after one or as the second field of a keyframe. */
+        if (h->keyframes_only &&
+            ((nal->type == H264_NAL_SEI && has_idr) ||
+             (nal->type == H264_NAL_SLICE && !h->first_field &&
+              h->sei.recovery_point.recovery_frame_cnt < 0) ||
+             nal->type == H264_NAL_DPA || nal->type == H264_NAL_DPB ||
+             nal->type == H264_NAL_DPC))
+            continue;
+
         // FIXME these should stop being context-global variables
         h->nal_ref_idc   = nal->ref_idc;
         h->nal_unit_type = nal->type;
@@ -791,6 +816,9 @@ end:
         ff_thread_report_progress(&h->cur_pic_ptr->tf, INT_MAX,
                                   h->picture_structure == PICT_BOTTOM_FIELD);
     }
+    /* the rest of a picture which failed is not going to be decoded */
+    if (ret < 0 && h->cur_pic_ptr)
+        ff_decode_report_rows(h->cur_pic_ptr->f, INT_MAX);
 
     return (ret < 0) ? ret : buf_size;
 }
@@ -1022,7 +1050,7 @@ static int h264_decode_frame(AVCodecContext *avctx, AVFrame *pict,
     }
 
     if (!(avctx->flags2 & AV_CODEC_FLAG2_CHUNKS) && (!h->cur_pic_ptr || !h->has_slice)) {
-        if (avctx->skip_frame >= AVDISCARD_NONREF ||
+        if (avctx->skip_frame >= AVDISCARD_NONREF || h->keyframes_only ||
             buf_size >= 4 && !memcmp("Q264", buf, 4))
             return buf_size;
         av_log(avctx, AV_LOG_ERROR, "no frame!\n");
@@ -1057,6 +1085,7 @@ static const AVOption h264_options[] = {
     { "nal_length_size", "nal_length_size", OFFSET(nal_length_size), AV_OPT_TYPE_INT, {.i64 = 0}, 0, 4, VDX },
     { "enable_er", "Enable error resilience on damaged frames (unsafe)", OFFSET(enable_er), AV_OPT_TYPE_BOOL, { .i64 = -1 }, -1, 1, VD },
     { "x264_build", "Assume this x264 version if no x264 version found in any SEI", OFFSET(x264_build), AV_OPT_TYPE_INT, {.i64 = -1}, -1, INT_MAX, VD },
+    { "keyframes_only", "Only decode keyframes, skipping everything else as early as possible", OFFSET(keyframes_only), AV_OPT_TYPE_BOOL, {.i64 = 0}, 0, 1, VD },
     { NULL },
 };
 
@@ -543,6 +543,8 @@ typedef struct H264Context {
 
     int enable_er;
     ERContext er;
+
+    int keyframes_only;
     int16_t *dc_val_base;
 
     H264SEIContext sei;
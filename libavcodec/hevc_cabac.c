@@ -950,13 +950,9 @@ static av_always_inline void last_significant_coeff_xy_prefix_decode(HEVCLocalCo
 static av_always_inline int last_significant_coeff_suffix_decode(HEVCLocalContext *lc,
                                                  int last_significant_coeff_prefix)
 {
-    int i;
     int length = (last_significant_coeff_prefix >> 1) - 1;
-    int value = get_cabac_bypass(&lc->cc);
 
-    for (i = 1; i < length; i++)
-        value = (value << 1) | get_cabac_bypass(&lc->cc);
-    return value;
+    return get_cabac_bypass_bits(&lc->cc, length);
 }
 
 static av_always_inline int significant_coeff_group_flag_decode(HEVCLocalContext *lc, int c_idx, int ctx_cg)
@@ -999,16 +995,14 @@ static av_always_inline int coeff_abs_level_greater2_flag_decode(HEVCLocalContex
 static av_always_inline int coeff_abs_level_remaining_decode(HEVCLocalContext *lc, int rc_rice_param)
 {
     int prefix = 0;
-    int suffix = 0;
+    int suffix;
     int last_coeff_abs_level_remaining;
-    int i;
 
     while (prefix < CABAC_MAX_BIN && get_cabac_bypass(&lc->cc))
         prefix++;
 
     if (prefix < 3) {
-        for (i = 0; i < rc_rice_param; i++)
-            suffix = (suffix << 1) | get_cabac_bypass(&lc->cc);
+        suffix = get_cabac_bypass_bits(&lc->cc, rc_rice_param);
         last_coeff_abs_level_remaining = (prefix << rc_rice_param) + suffix;
     } else {
         int prefix_minus3 = prefix - 3;
@@ -1018,8 +1012,7 @@ static av_always_inline int coeff_abs_level_remaining_decode(HEVCLocalContext *l
             return 0;
         }
 
-        for (i = 0; i < prefix_minus3 + rc_rice_param; i++)
-            suffix = (suffix << 1) | get_cabac_bypass(&lc->cc);
+        suffix = get_cabac_bypass_bits(&lc->cc, prefix_minus3 + rc_rice_param);
         last_coeff_abs_level_remaining = (((1 << prefix_minus3) + 3 - 1)
                                               << rc_rice_param) + suffix;
     }
@@ -1028,12 +1021,7 @@ static av_always_inline int coeff_abs_level_remaining_decode(HEVCLocalContext *l
 
 static av_always_inline int coeff_sign_flag_decode(HEVCLocalContext *lc, uint8_t nb)
 {
-    int i;
-    int ret = 0;
-
-    for (i = 0; i < nb; i++)
-        ret = (ret << 1) | get_cabac_bypass(&lc->cc);
-    return ret;
+    return get_cabac_bypass_bits(&lc->cc, nb);
 }
 
 void ff_hevc_hls_residual_coding(HEVCLocalContext *lc, int x0, int y0,
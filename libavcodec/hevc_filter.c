@@ -25,6 +25,7 @@
 #include "libavutil/common.h"
 #include "libavutil/internal.h"
 
+#include "decode.h"
 #include "hevcdec.h"
 #include "threadframe.h"
 
@@ -848,10 +849,38 @@ void ff_hevc_deblocking_boundary_strengths(HEVCLocalContext *lc, int x0, int y0,
 #undef CB
 #undef CR
 
+/* Report the finished luma rows [y, y_end) of the current frame through
+ * its row progress and draw_horiz_band(). With frame threading this happens
+ * from the frame threads, before the frame is output. */
+static void rows_finished(const HEVCContext *s, int y, int y_end)
+{
+    AVCodecContext *avctx = s->avctx;
+    const AVFrame *frame  = s->ref->frame;
+    int offset[AV_NUM_DATA_POINTERS] = { 0 };
+
+    y     = FFMAX(y, 0);
+    y_end = FFMIN(y_end, s->ps.sps->height);
+    if (y >= y_end)
+        return;
+
+    ff_decode_report_rows(frame, y_end);
+
+    if (!avctx->draw_horiz_band)
+        return;
+
+    for (int i = 0; i < 3 && frame->data[i]; i++)
+        offset[i] = (y >> s->ps.sps->vshift[i]) * frame->linesize[i];
+
+    emms_c();
+
+    avctx->draw_horiz_band(avctx, frame, offset, y, 3, y_end - y);
+}
+
 void ff_hevc_hls_filter(HEVCLocalContext *lc, int x, int y, int ctb_size)
 {
     const HEVCContext *const s = lc->parent;
     int x_end = x >= s->ps.sps->width  - ctb_size;
+    int y_end = y >= s->ps.sps->height - ctb_size;
     int skip = 0;
     if (s->avctx->skip_loop_filter >= AVDISCARD_ALL ||
         (s->avctx->skip_loop_filter >= AVDISCARD_NONKEY && !IS_IDR(s)) ||
@@ -866,23 +895,28 @@ void ff_hevc_hls_filter(HEVCLocalContext *lc, int x, int y, int ctb_size)
     if (!skip)
         deblocking_filter_CTB(s, x, y);
     if (s->ps.sps->sao_enabled && !skip) {
-        int y_end = y >= s->ps.sps->height - ctb_size;
         if (y && x)
             sao_filter_CTB(lc, s, x - ctb_size, y - ctb_size);
         if (x && y_end)
             sao_filter_CTB(lc, s, x - ctb_size, y);
         if (y && x_end) {
             sao_filter_CTB(lc, s, x, y - ctb_size);
+            rows_finished(s, y - ctb_size, y);
             if (s->threads_type & FF_THREAD_FRAME )
                 ff_thread_report_progress(&s->ref->tf, y, 0);
         }
         if (x_end && y_end) {
             sao_filter_CTB(lc, s, x , y);
+            rows_finished(s, y, y + ctb_size);
             if (s->threads_type & FF_THREAD_FRAME )
                 ff_thread_report_progress(&s->ref->tf, y + ctb_size, 0);
         }
-    } else if (s->threads_type & FF_THREAD_FRAME && x_end)
-        ff_thread_report_progress(&s->ref->tf, y + ctb_size - 4, 0);
+    } else if (x_end) {
+        // the last rows are only final once the next CTB row is deblocked
+        rows_finished(s, y - 4, y_end ? y + ctb_size : y + ctb_size - 4);
+        if (s->threads_type & FF_THREAD_FRAME)
+            ff_thread_report_progress(&s->ref->tf, y + ctb_size - 4, 0);
+    }
 }
 
 void ff_hevc_hls_filters(HEVCLocalContext *lc, int x_ctb, int y_ctb, int ctb_size)
@@ -78,8 +78,10 @@ void ff_hevc_clear_refs(HEVCContext *s)
 void ff_hevc_flush_dpb(HEVCContext *s)
 {
     int i;
-    for (i = 0; i < FF_ARRAY_ELEMS(s->DPB); i++)
+    for (i = 0; i < FF_ARRAY_ELEMS(s->DPB); i++) {
+        ff_decode_report_rows(s->DPB[i].frame, INT_MAX);
         ff_hevc_unref_frame(s, &s->DPB[i], ~0);
+    }
 }
 
 static HEVCFrame *alloc_frame(HEVCContext *s)
@@ -35,6 +35,7 @@
 #include "libavutil/md5.h"
 #include "libavutil/opt.h"
 #include "libavutil/pixdesc.h"
+#include "libavutil/thread.h"
 #include "libavutil/timecode.h"
 
 #include "bswapdsp.h"
@@ -50,6 +51,7 @@
 #include "hwconfig.h"
 #include "internal.h"
 #include "profiles.h"
+#include "pthread_internal.h"
 #include "thread.h"
 #include "threadframe.h"
 
@@ -980,11 +982,13 @@ static int hls_slice_header(HEVCContext *s)
                 unsigned val = get_bits_long(gb, offset_len);
                 sh->entry_point_offset[i] = val + 1; // +1; // +1 to get the size
             }
-            if (s->threads_number > 1 && (s->ps.pps->num_tile_rows > 1 || s->ps.pps->num_tile_columns > 1)) {
+            if (s->nb_local_ctx > 1 && (s->ps.pps->num_tile_rows > 1 || s->ps.pps->num_tile_columns > 1)) {
                 s->enable_parallel_tiles = 0; // TODO: you can enable tiles in parallel here
                 s->threads_number = 1;
-            } else
+            } else {
                 s->enable_parallel_tiles = 0;
+                s->threads_number = s->nb_local_ctx;
+            }
         } else
             s->enable_parallel_tiles = 0;
     }
@@ -2586,6 +2590,315 @@ static int hls_slice_data(HEVCContext *s)
     s->avctx->execute(s->avctx, hls_decode_entry, NULL, &ret , 1, 0);
     return ret;
 }
+
+#if HAVE_THREADS
+typedef struct HEVCWPPProgress {
+    pthread_mutex_t mutex;
+    pthread_cond_t  cond;
+} HEVCWPPProgress;
+
+/**
+ * Helper job decoding rows for a frame thread on the shared WPP pool,
+ * using local context idx.
+ */
+typedef struct HEVCWPPHelper {
+    FFThreadPoolJob job;
+    HEVCContext    *s;
+    int             idx;
+    /**
+     * Set from submission until the job is done, protected by
+     * HEVCWPPContext.mutex.
+     */
+    int             busy;
+} HEVCWPPHelper;
+
+/**
+ * Per frame thread state for decoding the CTB rows of a WPP slice segment.
+ *
+ * With frame threading, the frame threads cannot also use the libavcodec
+ * slice threads. Instead, they share one pool of wpp_threads workers: the
+ * frame thread queues a helper job for each of its other local contexts,
+ * then decodes rows itself too. Rows are taken in order by whoever is free,
+ * so every row that has been taken is being decoded, and as the frame
+ * thread always takes part, a slice segment completes even if all the
+ * workers are busy with other frames.
+ *
+ * Rows synchronize on each other through entries[] exactly like the slice
+ * threading progress functions, while ff_hevc_hls_filter() still reports
+ * per-row frame progress to the frames referencing this one.
+ */
+typedef struct HEVCWPPContext {
+    HEVCWPPProgress *progress;
+    int              nb_progress;
+    int             *entries;
+    int              nb_entries;
+
+    HEVCWPPHelper   *helpers;
+    int              nb_helpers;
+
+    int              mutex_init;
+    pthread_mutex_t  mutex;        ///< protects the fields below and the helpers
+    pthread_cond_t   cond;         ///< signalled when a row or a helper is done
+    int             *rets;
+    int              nb_rows;
+    int              next_row;
+    int              rows_done;
+} HEVCWPPContext;
+
+static void wpp_await_progress(const HEVCContext *s, int ctb_row, int thread, int shift)
+{
+    HEVCWPPContext *wpp = s->wpp;
+    HEVCWPPProgress *progress;
+
+    if (!wpp) {
+        ff_thread_await_progress2(s->avctx, ctb_row, thread, shift);
+        return;
+    }
+    if (!ctb_row)
+        return;
+
+    progress = &wpp->progress[thread ? thread - 1 : s->threads_number - 1];
+    pthread_mutex_lock(&progress->mutex);
+    while (wpp->entries[ctb_row - 1] - wpp->entries[ctb_row] < shift)
+        pthread_cond_wait(&progress->cond, &progress->mutex);
+    pthread_mutex_unlock(&progress->mutex);
+}
+
+static void wpp_report_progress(const HEVCContext *s, int ctb_row, int thread, int n)
+{
+    HEVCWPPContext *wpp = s->wpp;
+    HEVCWPPProgress *progress;
+
+    if (!wpp) {
+        ff_thread_report_progress2(s->avctx, ctb_row, thread, n);
+        return;
+    }
+
+    progress = &wpp->progress[thread];
+    pthread_mutex_lock(&progress->mutex);
+    wpp->entries[ctb_row] += n;
+    pthread_cond_signal(&progress->cond);
+    pthread_mutex_unlock(&progress->mutex);
+}
+
+static int wpp_alloc_entries(HEVCContext *s, int count)
+{
+    HEVCWPPContext *wpp = s->wpp;
+
+    if (!wpp)
+        return ff_slice_thread_allocz_entries(s->avctx, count);
+
+    if (wpp->nb_entries == count) {
+        memset(wpp->entries, 0, count * sizeof(*wpp->entries));
+        return 0;
+    }
+    av_freep(&wpp->entries);
+    wpp->entries = av_calloc(count, sizeof(*wpp->entries));
+    if (!wpp->entries) {
+        wpp->nb_entries = 0;
+        return AVERROR(ENOMEM);
+    }
+    wpp->nb_entries = count;
+    return 0;
+}
+
+static int hls_decode_entry_wpp(AVCodecContext *avctxt, void *hevc_lclist,
+                                int job, int self_id);
+
+/**
+ * Decode rows of the current slice segment until none is left to take.
+ * Must be called with wpp->mutex held.
+ */
+static void wpp_run_rows(HEVCContext *s, int self_id)
+{
+    HEVCWPPContext *wpp = s->wpp;
+
+    while (wpp->next_row < wpp->nb_rows) {
+        int row = wpp->next_row++;
+
+        pthread_mutex_unlock(&wpp->mutex);
+        wpp->rets[row] = hls_decode_entry_wpp(s->avctx, s->HEVClcList, row, self_id);
+        pthread_mutex_lock(&wpp->mutex);
+
+        if (++wpp->rows_done == wpp->nb_rows)
+            pthread_cond_broadcast(&wpp->cond);
+    }
+}
+
+static void wpp_helper(void *arg)
+{
+    HEVCWPPHelper *helper = arg;
+    HEVCWPPContext *wpp = helper->s->wpp;
+
+    pthread_mutex_lock(&wpp->mutex);
+    wpp_run_rows(helper->s, helper->idx);
+    helper->busy = 0;
+    pthread_cond_broadcast(&wpp->cond);
+    pthread_mutex_unlock(&wpp->mutex);
+}
+
+static void wpp_execute(HEVCContext *s, int *ret, int nb_rows)
+{
+    HEVCWPPContext *wpp = s->wpp;
+
+    if (!wpp) {
+        s->avctx->execute2(s->avctx, hls_decode_entry_wpp, s->HEVClcList, ret, nb_rows);
+        return;
+    }
+
+    pthread_mutex_lock(&wpp->mutex);
+    wpp->rets      = ret;
+    wpp->nb_rows   = nb_rows;
+    wpp->next_row  = 0;
+    wpp->rows_done = 0;
+
+    if (s->wpp_pool) {
+        for (int i = 0; i < FFMIN(wpp->nb_helpers, nb_rows - 1); i++) {
+            HEVCWPPHelper *helper = &wpp->helpers[i];
+
+            // a helper still queued from a previous slice segment joins
+            // this one when it starts
+            if (helper->busy)
+                continue;
+            helper->busy = 1;
+            ff_thread_pool_submit(s->wpp_pool, &helper->job);
+        }
+    }
+
+    wpp_run_rows(s, 0);
+    while (wpp->rows_done < wpp->nb_rows)
+        pthread_cond_wait(&wpp->cond, &wpp->mutex);
+
+    wpp->rets    = NULL;
+    wpp->nb_rows = wpp->next_row = 0;
+    pthread_mutex_unlock(&wpp->mutex);
+}
+
+static av_cold void wpp_uninit(HEVCContext *s)
+{
+    HEVCWPPContext *wpp = s->wpp;
+
+    if (!wpp)
+        return;
+
+    if (wpp->mutex_init) {
+        // helpers may still sit in the pool queue; they find no rows to
+        // decode but still reference this context
+        pthread_mutex_lock(&wpp->mutex);
+        for (int i = 0; i < wpp->nb_helpers; i++) {
+            while (wpp->helpers[i].busy)
+                pthread_cond_wait(&wpp->cond, &wpp->mutex);
+        }
+        pthread_mutex_unlock(&wpp->mutex);
+
+        pthread_mutex_destroy(&wpp->mutex);
+        pthread_cond_destroy(&wpp->cond);
+    }
+    for (int i = 0; i < wpp->nb_progress; i++) {
+        pthread_mutex_destroy(&wpp->progress[i].mutex);
+        pthread_cond_destroy(&wpp->progress[i].cond);
+    }
+    av_freep(&wpp->progress);
+    av_freep(&wpp->helpers);
+    av_freep(&wpp->entries);
+    av_freep(&s->wpp);
+    av_buffer_unref(&s->wpp_pool);
+}
+
+/**
+ * Set up WPP decoding for a frame thread. The first frame thread creates
+ * the worker pool, the others get it in hevc_update_thread_context().
+ * Without a pool, the frame thread decodes the rows on its own.
+ */
+static av_cold int wpp_init(HEVCContext *s)
+{
+    HEVCWPPContext *wpp;
+    int nb_threads = s->wpp_threads + 1, ret;
+
+    wpp = s->wpp = av_mallocz(sizeof(*wpp));
+    if (!wpp)
+        return AVERROR(ENOMEM);
+
+    if ((ret = pthread_mutex_init(&wpp->mutex, NULL)))
+        return AVERROR(ret);
+    if ((ret = pthread_cond_init(&wpp->cond, NULL))) {
+        pthread_mutex_destroy(&wpp->mutex);
+        return AVERROR(ret);
+    }
+    wpp->mutex_init = 1;
+
+    wpp->helpers = av_calloc(nb_threads - 1, sizeof(*wpp->helpers));
+    if (!wpp->helpers)
+        return AVERROR(ENOMEM);
+    for (; wpp->nb_helpers < nb_threads - 1; wpp->nb_helpers++) {
+        HEVCWPPHelper *const helper = &wpp->helpers[wpp->nb_helpers];
+
+        helper->job.func = wpp_helper;
+        helper->job.arg  = helper;
+        helper->s        = s;
+        helper->idx      = wpp->nb_helpers + 1;
+    }
+
+    wpp->progress = av_calloc(nb_threads, sizeof(*wpp->progress));
+    if (!wpp->progress)
+        return AVERROR(ENOMEM);
+    for (; wpp->nb_progress < nb_threads; wpp->nb_progress++) {
+        HEVCWPPProgress *const progress = &wpp->progress[wpp->nb_progress];
+
+        if ((ret = pthread_mutex_init(&progress->mutex, NULL)))
+            return AVERROR(ret);
+        if ((ret = pthread_cond_init(&progress->cond, NULL))) {
+            pthread_mutex_destroy(&progress->mutex);
+            return AVERROR(ret);
+        }
+    }
+
+    if (!s->avctx->internal->is_copy) {
+        s->wpp_pool = ff_thread_pool_alloc(s->wpp_threads);
+        if (!s->wpp_pool)
+            av_log(s->avctx, AV_LOG_WARNING,
+                   "Could not create the WPP threads, decoding rows in the frame threads only\n");
+    }
+
+    s->threads_number = nb_threads;
+    return 0;
+}
+#else
+static void wpp_await_progress(const HEVCContext *s, int ctb_row, int thread, int shift)
+{
+    ff_thread_await_progress2(s->avctx, ctb_row, thread, shift);
+}
+
+static void wpp_report_progress(const HEVCContext *s, int ctb_row, int thread, int n)
+{
+    ff_thread_report_progress2(s->avctx, ctb_row, thread, n);
+}
+
+static int wpp_alloc_entries(HEVCContext *s, int count)
+{
+    return ff_slice_thread_allocz_entries(s->avctx, count);
+}
+
+static int hls_decode_entry_wpp(AVCodecContext *avctxt, void *hevc_lclist,
+                                int job, int self_id);
+
+static void wpp_execute(HEVCContext *s, int *ret, int nb_rows)
+{
+    s->avctx->execute2(s->avctx, hls_decode_entry_wpp, s->HEVClcList, ret, nb_rows);
+}
+
+static av_cold void wpp_uninit(HEVCContext *s)
+{
+}
+
+static av_cold int wpp_init(HEVCContext *s)
+{
+    av_log(s->avctx, AV_LOG_WARNING,
+           "WPP threads are not supported in this build, using frame threads only\n");
+    return 0;
+}
+#endif
+
 static int hls_decode_entry_wpp(AVCodecContext *avctxt, void *hevc_lclist,
                                 int job, int self_id)
 {
@@ -2612,13 +2925,13 @@ static int hls_decode_entry_wpp(AVCodecContext *avctxt, void *hevc_lclist,
 
         hls_decode_neighbour(lc, x_ctb, y_ctb, ctb_addr_ts);
 
-        ff_thread_await_progress2(s->avctx, ctb_row, thread, SHIFT_CTB_WPP);
+        wpp_await_progress(s, ctb_row, thread, SHIFT_CTB_WPP);
 
         /* atomic_load's prototype requires a pointer to non-const atomic variable
          * (due to implementations via mutexes, where reads involve writes).
          * Of course, casting const away here is nevertheless safe. */
         if (atomic_load((atomic_int*)&s->wpp_err)) {
-            ff_thread_report_progress2(s->avctx, ctb_row , thread, SHIFT_CTB_WPP);
+            wpp_report_progress(s, ctb_row , thread, SHIFT_CTB_WPP);
             return 0;
         }
 
@@ -2636,19 +2949,19 @@ static int hls_decode_entry_wpp(AVCodecContext *avctxt, void *hevc_lclist,
         ctb_addr_ts++;
 
         ff_hevc_save_states(lc, ctb_addr_ts);
-        ff_thread_report_progress2(s->avctx, ctb_row, thread, 1);
+        wpp_report_progress(s, ctb_row, thread, 1);
         ff_hevc_hls_filters(lc, x_ctb, y_ctb, ctb_size);
 
         if (!more_data && (x_ctb+ctb_size) < s->ps.sps->width && ctb_row != s->sh.num_entry_point_offsets) {
             /* Casting const away here is safe, because it is an atomic operation. */
             atomic_store((atomic_int*)&s->wpp_err, 1);
-            ff_thread_report_progress2(s->avctx, ctb_row ,thread, SHIFT_CTB_WPP);
+            wpp_report_progress(s, ctb_row ,thread, SHIFT_CTB_WPP);
             return 0;
         }
 
         if ((x_ctb+ctb_size) >= s->ps.sps->width && (y_ctb+ctb_size) >= s->ps.sps->height ) {
             ff_hevc_hls_filter(lc, x_ctb, y_ctb, ctb_size);
-            ff_thread_report_progress2(s->avctx, ctb_row , thread, SHIFT_CTB_WPP);
+            wpp_report_progress(s, ctb_row , thread, SHIFT_CTB_WPP);
             return ctb_addr_ts;
         }
         ctb_addr_rs       = s->ps.pps->ctb_addr_ts_to_rs[ctb_addr_ts];
@@ -2658,14 +2971,14 @@ static int hls_decode_entry_wpp(AVCodecContext *avctxt, void *hevc_lclist,
             break;
         }
     }
-    ff_thread_report_progress2(s->avctx, ctb_row ,thread, SHIFT_CTB_WPP);
+    wpp_report_progress(s, ctb_row ,thread, SHIFT_CTB_WPP);
 
     return 0;
 error:
     s->tab_slice_address[ctb_addr_rs] = -1;
     /* Casting const away here is safe, because it is an atomic operation. */
     atomic_store((atomic_int*)&s->wpp_err, 1);
-    ff_thread_report_progress2(s->avctx, ctb_row ,thread, SHIFT_CTB_WPP);
+    wpp_report_progress(s, ctb_row ,thread, SHIFT_CTB_WPP);
     return ret;
 }
 
@@ -2738,7 +3051,7 @@ static int hls_slice_data_wpp(HEVCContext *s, const H2645NAL *nal)
     }
 
     atomic_store(&s->wpp_err, 0);
-    res = ff_slice_thread_allocz_entries(s->avctx, s->sh.num_entry_point_offsets + 1);
+    res = wpp_alloc_entries(s, s->sh.num_entry_point_offsets + 1);
     if (res < 0)
         return res;
 
@@ -2747,7 +3060,7 @@ static int hls_slice_data_wpp(HEVCContext *s, const H2645NAL *nal)
         return AVERROR(ENOMEM);
 
     if (s->ps.pps->entropy_coding_sync_enabled_flag)
-        s->avctx->execute2(s->avctx, hls_decode_entry_wpp, s->HEVClcList, ret, s->sh.num_entry_point_offsets + 1);
+        wpp_execute(s, ret, s->sh.num_entry_point_offsets + 1);
 
     for (i = 0; i <= s->sh.num_entry_point_offsets; i++)
         res += ret[i];
@@ -2920,14 +3233,25 @@ static int hevc_frame_start(HEVCContext *s)
     if (s->ps.pps->tiles_enabled_flag)
         lc->end_of_tiles_x = s->ps.pps->column_width[0] << s->ps.sps->log2_ctb_size;
 
+    /* IRAP pictures never reference other pictures, so with keyframes_only
+     * the DPB only has to hold the current picture until it is output;
+     * building the RPS would just allocate the missing leading references. */
+    if (s->keyframes_only)
+        ff_hevc_clear_refs(s);
+
     ret = ff_hevc_set_new_ref(s, &s->frame, s->poc);
     if (ret < 0)
         goto fail;
 
-    ret = ff_hevc_frame_rps(s);
-    if (ret < 0) {
-        av_log(s->avctx, AV_LOG_ERROR, "Error constructing the frame RPS.\n");
-        goto fail;
+    if (s->keyframes_only) {
+        for (int i = 0; i < NB_RPS_TYPE; i++)
+            s->rps[i].nb_refs = 0;
+    } else {
+        ret = ff_hevc_frame_rps(s);
+        if (ret < 0) {
+            av_log(s->avctx, AV_LOG_ERROR, "Error constructing the frame RPS.\n");
+            goto fail;
+        }
     }
 
     if (IS_IRAP(s))
@@ -2957,7 +3281,7 @@ static int hevc_frame_start(HEVCContext *s)
         ff_hevc_bump_frame(s);
 
     av_frame_unref(s->output_frame);
-    ret = ff_hevc_output_frame(s, s->output_frame, 0);
+    ret = ff_hevc_output_frame(s, s->output_frame, s->keyframes_only);
     if (ret < 0)
         goto fail;
 
@@ -2967,8 +3291,10 @@ static int hevc_frame_start(HEVCContext *s)
     return 0;
 
 fail:
-    if (s->ref)
+    if (s->ref) {
+        ff_decode_report_rows(s->ref->frame, INT_MAX);
         ff_hevc_unref_frame(s, s->ref, ~0);
+    }
     s->ref = NULL;
     return ret;
 }
@@ -3193,6 +3519,17 @@ fail:
     return 0;
 }
 
+/**
+ * @return whether a NAL unit of this type is used with keyframes_only, which
+ * drops the slices of non-IRAP pictures and all SEI messages
+ */
+static int nal_needed_for_keyframes(enum HEVCNALUnitType type)
+{
+    if (type <= HEVC_NAL_RSV_VCL31)
+        return type >= HEVC_NAL_BLA_W_LP && type <= HEVC_NAL_RSV_IRAP_VCL23;
+    return type != HEVC_NAL_SEI_PREFIX && type != HEVC_NAL_SEI_SUFFIX;
+}
+
 static int decode_nal_units(HEVCContext *s, const uint8_t *buf, int length)
 {
     int i, ret = 0;
@@ -3262,7 +3599,8 @@ static int decode_nal_units(HEVCContext *s, const uint8_t *buf, int length)
 
         if (s->avctx->skip_frame >= AVDISCARD_ALL ||
             (s->avctx->skip_frame >= AVDISCARD_NONREF
-            && ff_hevc_nal_is_nonref(nal->type)) || nal->nuh_layer_id > 0)
+            && ff_hevc_nal_is_nonref(nal->type)) || nal->nuh_layer_id > 0 ||
+            (s->keyframes_only && !nal_needed_for_keyframes(nal->type)))
             continue;
 
         ret = decode_nal_unit(s, nal);
@@ -3278,6 +3616,8 @@ static int decode_nal_units(HEVCContext *s, const uint8_t *buf, int length)
 fail:
     if (s->ref && s->threads_type == FF_THREAD_FRAME)
         ff_thread_report_progress(&s->ref->tf, INT_MAX, 0);
+    if (s->ref)
+        ff_decode_report_rows(s->ref->frame, INT_MAX);
 
     return ret;
 }
@@ -3496,6 +3836,7 @@ static av_cold int hevc_decode_free(AVCodecContext *avctx)
     HEVCContext       *s = avctx->priv_data;
     int i;
 
+    wpp_uninit(s);
     pic_arrays_free(s);
 
     ff_dovi_ctx_unref(&s->dovi_ctx);
@@ -3522,7 +3863,7 @@ static av_cold int hevc_decode_free(AVCodecContext *avctx)
     av_freep(&s->sh.size);
 
     if (s->HEVClcList) {
-        for (i = 1; i < s->threads_number; i++) {
+        for (i = 1; i < s->nb_local_ctx; i++) {
             av_freep(&s->HEVClcList[i]);
         }
     }
@@ -3547,6 +3888,7 @@ static av_cold int hevc_init_context(AVCodecContext *avctx)
     s->HEVClcList = av_mallocz(sizeof(HEVCLocalContext*) * s->threads_number);
     if (!s->HEVClc || !s->HEVClcList)
         return AVERROR(ENOMEM);
+    s->nb_local_ctx = s->threads_number;
     s->HEVClc->parent = s;
     s->HEVClc->logctx = avctx;
     s->HEVClc->common_cabac_state = &s->cabac;
@@ -3634,9 +3976,12 @@ static int hevc_update_thread_context(AVCodecContext *dst,
     s->is_nalff        = s0->is_nalff;
     s->nal_length_size = s0->nal_length_size;
 
-    s->threads_number      = s0->threads_number;
     s->threads_type        = s0->threads_type;
 
+    ret = av_buffer_replace(&s->wpp_pool, s0->wpp_pool);
+    if (ret < 0)
+        return ret;
+
     if (s0->eos) {
         s->seq_decode = (s->seq_decode + 1) & HEVC_SEQUENCE_COUNTER_MASK;
         s->max_ra = INT_MAX;
@@ -3696,6 +4041,12 @@ static av_cold int hevc_decode_init(AVCodecContext *avctx)
     else
         s->threads_type = FF_THREAD_SLICE;
 
+    if (s->threads_type == FF_THREAD_FRAME && s->wpp_threads > 0) {
+        ret = wpp_init(s);
+        if (ret < 0)
+            return ret;
+    }
+
     ret = hevc_init_context(avctx);
     if (ret < 0)
         return ret;
@@ -3740,6 +4091,10 @@ static const AVOption options[] = {
         AV_OPT_TYPE_BOOL, {.i64 = 0}, 0, 1, PAR },
     { "strict-displaywin", "stricly apply default display window size", OFFSET(apply_defdispwin),
         AV_OPT_TYPE_BOOL, {.i64 = 0}, 0, 1, PAR },
+    { "wpp_threads", "Decode WPP rows of the frame threads with this many shared worker threads", OFFSET(wpp_threads),
+        AV_OPT_TYPE_INT, {.i64 = 0}, 0, 64, PAR },
+    { "keyframes_only", "Only decode keyframes, skipping everything else as early as possible", OFFSET(keyframes_only),
+        AV_OPT_TYPE_BOOL, {.i64 = 0}, 0, 1, PAR },
     { NULL },
 };
 
@@ -3763,6 +4118,7 @@ const FFCodec ff_hevc_decoder = {
     .flush                 = hevc_decode_flush,
     UPDATE_THREAD_CONTEXT(hevc_update_thread_context),
     .p.capabilities        = AV_CODEC_CAP_DR1 | AV_CODEC_CAP_DELAY |
+                             AV_CODEC_CAP_DRAW_HORIZ_BAND |
                              AV_CODEC_CAP_SLICE_THREADS | AV_CODEC_CAP_FRAME_THREADS,
     .caps_internal         = FF_CODEC_CAP_EXPORTS_CROPPING |
                              FF_CODEC_CAP_ALLOCATE_PROGRESS | FF_CODEC_CAP_INIT_CLEANUP,
@@ -500,7 +500,16 @@ typedef struct HEVCContext {
     HEVCLocalContext    *HEVClc;
 
     uint8_t             threads_type;
+    /**
+     * Number of local contexts used for the current slice segment: 1 when
+     * it is decoded sequentially, nb_local_ctx otherwise.
+     */
     uint8_t             threads_number;
+    /**
+     * Number of entries in HEVClcList, i.e. the number of slice threads or
+     * of threads decoding the WPP rows of a frame thread.
+     */
+    int                 nb_local_ctx;
 
     int                 width;
     int                 height;
@@ -583,6 +592,19 @@ typedef struct HEVCContext {
     int enable_parallel_tiles;
     atomic_int wpp_err;
 
+    /**
+     * WPP row decoding state of this frame thread when hybrid frame+WPP
+     * threading is active, NULL when WPP rows run on the libavcodec slice
+     * threads (or not at all).
+     */
+    struct HEVCWPPContext *wpp;
+    /**
+     * Worker pool shared by all the frame threads for decoding WPP rows.
+     */
+    AVBufferRef *wpp_pool;
+    int wpp_threads;        ///< number of workers in wpp_pool
+    int keyframes_only;     ///< only decode IRAP pictures, output without reordering
+
     const uint8_t *data;
 
     H2645Packet pkt;
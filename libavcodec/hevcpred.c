@@ -75,7 +75,9 @@ void ff_hevc_pred_init(HEVCPredContext *hpc, int bit_depth)
         break;
     }
 
-#if ARCH_MIPS
+#if ARCH_AARCH64
+    ff_hevc_pred_init_aarch64(hpc, bit_depth);
+#elif ARCH_MIPS
     ff_hevc_pred_init_mips(hpc, bit_depth);
 #endif
 }
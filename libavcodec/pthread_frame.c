@@ -102,6 +102,8 @@ typedef struct PerThreadContext {
 
     int die;                        ///< Set when the thread should exit.
 
+    FFThreadPoolJob job;            ///< Used instead of thread when decoding on a shared pool.
+
     int hwaccel_serializing;
     int async_serializing;
 
@@ -146,6 +148,8 @@ typedef struct FrameThreadContext {
     const AVHWAccel *stash_hwaccel;
     void            *stash_hwaccel_context;
     void            *stash_hwaccel_priv;
+
+    AVBufferRef *pool;             ///< Shared thread pool running the decode jobs, if any.
 } FrameThreadContext;
 
 static int hwaccel_serial(const AVCodecContext *avctx)
@@ -183,89 +187,110 @@ static void thread_set_name(PerThreadContext *p)
 }
 
 /**
- * Codec worker thread.
+ * Decode the packet submitted to p. Must be called with p->mutex held.
  *
  * Automatically calls ff_thread_finish_setup() if the codec does
  * not provide an update_thread_context method, or if the codec returns
  * before calling it.
  */
-static attribute_align_arg void *frame_worker_thread(void *arg)
+static void decode_packet(PerThreadContext *p)
 {
-    PerThreadContext *p = arg;
     AVCodecContext *avctx = p->avctx;
     const FFCodec *codec = ffcodec(avctx->codec);
 
-    thread_set_name(p);
+    if (!codec->update_thread_context)
+        ff_thread_finish_setup(avctx);
 
-    pthread_mutex_lock(&p->mutex);
-    while (1) {
-        while (atomic_load(&p->state) == STATE_INPUT_READY && !p->die)
-            pthread_cond_wait(&p->input_cond, &p->mutex);
+    /* If a decoder supports hwaccel, then it must call ff_get_format().
+     * Since that call must happen before ff_thread_finish_setup(), the
+     * decoder is required to implement update_thread_context() and call
+     * ff_thread_finish_setup() manually. Therefore the above
+     * ff_thread_finish_setup() call did not happen and hwaccel_serializing
+     * cannot be true here. */
+    av_assert0(!p->hwaccel_serializing);
 
-        if (p->die) break;
+    /* if the previous thread uses thread-unsafe hwaccel then we take the
+     * lock to ensure the threads don't run concurrently */
+    if (hwaccel_serial(avctx)) {
+        pthread_mutex_lock(&p->parent->hwaccel_mutex);
+        p->hwaccel_serializing = 1;
+    }
 
-        if (!codec->update_thread_context)
-            ff_thread_finish_setup(avctx);
-
-        /* If a decoder supports hwaccel, then it must call ff_get_format().
-         * Since that call must happen before ff_thread_finish_setup(), the
-         * decoder is required to implement update_thread_context() and call
-         * ff_thread_finish_setup() manually. Therefore the above
-         * ff_thread_finish_setup() call did not happen and hwaccel_serializing
-         * cannot be true here. */
-        av_assert0(!p->hwaccel_serializing);
-
-        /* if the previous thread uses thread-unsafe hwaccel then we take the
-         * lock to ensure the threads don't run concurrently */
-        if (hwaccel_serial(avctx)) {
-            pthread_mutex_lock(&p->parent->hwaccel_mutex);
-            p->hwaccel_serializing = 1;
-        }
+    av_frame_unref(p->frame);
+    p->got_frame = 0;
+    p->result = codec->cb.decode(avctx, p->frame, &p->got_frame, p->avpkt);
 
-        av_frame_unref(p->frame);
-        p->got_frame = 0;
-        p->result = codec->cb.decode(avctx, p->frame, &p->got_frame, p->avpkt);
+    if ((p->result < 0 || !p->got_frame) && p->frame->buf[0])
+        ff_thread_release_buffer(avctx, p->frame);
+
+    if (atomic_load(&p->state) == STATE_SETTING_UP)
+        ff_thread_finish_setup(avctx);
 
-        if ((p->result < 0 || !p->got_frame) && p->frame->buf[0])
-            ff_thread_release_buffer(avctx, p->frame);
+    if (p->hwaccel_serializing) {
+        /* wipe hwaccel state for thread-unsafe hwaccels to avoid stale
+         * pointers lying around;
+         * the state was transferred to FrameThreadContext in
+         * ff_thread_finish_setup(), so nothing is leaked */
+        avctx->hwaccel                     = NULL;
+        avctx->hwaccel_context             = NULL;
+        avctx->internal->hwaccel_priv_data = NULL;
 
-        if (atomic_load(&p->state) == STATE_SETTING_UP)
-            ff_thread_finish_setup(avctx);
+        p->hwaccel_serializing = 0;
+        pthread_mutex_unlock(&p->parent->hwaccel_mutex);
+    }
+    av_assert0(!avctx->hwaccel ||
+               (avctx->hwaccel->caps_internal & HWACCEL_CAP_THREAD_SAFE));
 
-        if (p->hwaccel_serializing) {
-            /* wipe hwaccel state for thread-unsafe hwaccels to avoid stale
-             * pointers lying around;
-             * the state was transferred to FrameThreadContext in
-             * ff_thread_finish_setup(), so nothing is leaked */
-            avctx->hwaccel                     = NULL;
-            avctx->hwaccel_context             = NULL;
-            avctx->internal->hwaccel_priv_data = NULL;
+    if (p->async_serializing) {
+        p->async_serializing = 0;
 
-            p->hwaccel_serializing = 0;
-            pthread_mutex_unlock(&p->parent->hwaccel_mutex);
-        }
-        av_assert0(!avctx->hwaccel ||
-                   (avctx->hwaccel->caps_internal & HWACCEL_CAP_THREAD_SAFE));
+        async_unlock(p->parent);
+    }
 
-        if (p->async_serializing) {
-            p->async_serializing = 0;
+    pthread_mutex_lock(&p->progress_mutex);
 
-            async_unlock(p->parent);
-        }
+    atomic_store(&p->state, STATE_INPUT_READY);
 
-        pthread_mutex_lock(&p->progress_mutex);
+    pthread_cond_broadcast(&p->progress_cond);
+    pthread_cond_signal(&p->output_cond);
+    pthread_mutex_unlock(&p->progress_mutex);
+}
+
+/**
+ * Codec worker thread.
+ */
+static attribute_align_arg void *frame_worker_thread(void *arg)
+{
+    PerThreadContext *p = arg;
+
+    thread_set_name(p);
+
+    pthread_mutex_lock(&p->mutex);
+    while (1) {
+        while (atomic_load(&p->state) == STATE_INPUT_READY && !p->die)
+            pthread_cond_wait(&p->input_cond, &p->mutex);
 
-        atomic_store(&p->state, STATE_INPUT_READY);
+        if (p->die) break;
 
-        pthread_cond_broadcast(&p->progress_cond);
-        pthread_cond_signal(&p->output_cond);
-        pthread_mutex_unlock(&p->progress_mutex);
+        decode_packet(p);
     }
     pthread_mutex_unlock(&p->mutex);
 
     return NULL;
 }
 
+/**
+ * Job run on the shared thread pool for each submitted packet.
+ */
+static void frame_worker_job(void *arg)
+{
+    PerThreadContext *p = arg;
+
+    pthread_mutex_lock(&p->mutex);
+    decode_packet(p);
+    pthread_mutex_unlock(&p->mutex);
+}
+
 /**
  * Update the next thread's AVCodecContext with values from the reference thread's context.
  *
@@ -513,9 +538,18 @@ static int submit_packet(PerThreadContext *p, AVCodecContext *user_avctx,
     }
 
     atomic_store(&p->state, STATE_SETTING_UP);
-    pthread_cond_signal(&p->input_cond);
+    if (!fctx->pool)
+        pthread_cond_signal(&p->input_cond);
     pthread_mutex_unlock(&p->mutex);
 
+    /* Jobs of all contexts sharing the pool are started in submission order,
+     * and a frame only ever waits on frames submitted before it, so this
+     * cannot deadlock however few threads the pool has. Decoders whose jobs
+     * could wait on the caller instead do not use the pool, see
+     * may_use_async_unsafe_hwaccel(). */
+    if (fctx->pool)
+        ff_thread_pool_submit(fctx->pool, &p->job);
+
     fctx->prev_thread = p;
     fctx->next_decoding++;
 
@@ -741,7 +775,11 @@ void ff_frame_thread_free(AVCodecContext *avctx, int thread_count)
         AVCodecContext *ctx = p->avctx;
 
         if (ctx->internal) {
-            if (p->thread_init == INITIALIZED) {
+            if (p->thread_init == INITIALIZED && fctx->pool) {
+                /* The job may still be returning after having parked. */
+                pthread_mutex_lock(&p->mutex);
+                pthread_mutex_unlock(&p->mutex);
+            } else if (p->thread_init == INITIALIZED) {
                 pthread_mutex_lock(&p->mutex);
                 p->die = 1;
                 pthread_cond_signal(&p->input_cond);
@@ -784,6 +822,7 @@ FF_ENABLE_DEPRECATION_WARNINGS
 
     av_freep(&fctx->threads);
     ff_pthread_free(fctx, thread_ctx_offsets);
+    av_buffer_unref(&fctx->pool);
 
     /* if we have stashed hwaccel state, move it to the user-facing context,
      * so it will be freed in avcodec_close() */
@@ -866,14 +905,52 @@ static av_cold int init_thread(PerThreadContext *p, int *threads_to_free,
 
     atomic_init(&p->debug_threads, (copy->debug & FF_DEBUG_THREADS) != 0);
 
-    err = AVERROR(pthread_create(&p->thread, NULL, frame_worker_thread, p));
-    if (err < 0)
-        return err;
+    if (fctx->pool) {
+        p->job.func = frame_worker_job;
+        p->job.arg  = p;
+    } else {
+        err = AVERROR(pthread_create(&p->thread, NULL, frame_worker_thread, p));
+        if (err < 0)
+            return err;
+    }
     p->thread_init = INITIALIZED;
 
     return 0;
 }
 
+/**
+ * Check whether the decoder may select a hwaccel that is not async-safe.
+ * Its frame threads then block in ff_thread_finish_setup() until the caller
+ * reenters the decoder. A job doing that on a shared pool would hold one of
+ * the pool's workers, and the other decoders sharing it could starve, e.g.
+ * when the same caller is waiting on one of them.
+ */
+static int may_use_async_unsafe_hwaccel(const AVCodecContext *avctx)
+{
+    const FFCodec *codec = ffcodec(avctx->codec);
+    int hw_setup = avctx->hw_device_ctx || avctx->hw_frames_ctx ||
+                   avctx->hwaccel_context ||
+                   avctx->get_format != avcodec_default_get_format;
+
+    if (!codec->hw_configs)
+        return 0;
+
+    for (int i = 0; codec->hw_configs[i]; i++) {
+        const AVCodecHWConfigInternal *hw_config = codec->hw_configs[i];
+
+        if (!hw_config->hwaccel ||
+            (hw_config->hwaccel->caps_internal & HWACCEL_CAP_ASYNC_SAFE))
+            continue;
+        /* without any setup, avcodec_default_get_format() only picks
+         * configurations that need none */
+        if (hw_setup ||
+            (hw_config->public.methods & AV_CODEC_HW_CONFIG_METHOD_INTERNAL))
+            return 1;
+    }
+
+    return 0;
+}
+
 int ff_frame_thread_init(AVCodecContext *avctx)
 {
     int thread_count = avctx->thread_count;
@@ -909,6 +986,17 @@ int ff_frame_thread_init(AVCodecContext *avctx)
     fctx->async_lock = 1;
     fctx->delaying = 1;
 
+    if (avctx->thread_pool && may_use_async_unsafe_hwaccel(avctx)) {
+        av_log(avctx, AV_LOG_VERBOSE, "A hwaccel that is not async-safe may "
+               "be used, not running on the shared thread pool.\n");
+    } else if (avctx->thread_pool) {
+        fctx->pool = av_buffer_ref(avctx->thread_pool);
+        if (!fctx->pool) {
+            err = AVERROR(ENOMEM);
+            goto error;
+        }
+    }
+
     if (codec->p.type == AVMEDIA_TYPE_VIDEO)
         avctx->delay = avctx->thread_count - 1;
 
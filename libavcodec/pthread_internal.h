@@ -31,6 +31,30 @@ void ff_slice_thread_free(AVCodecContext *avctx);
 int ff_frame_thread_init(AVCodecContext *avctx);
 void ff_frame_thread_free(AVCodecContext *avctx, int thread_count);
 
+/**
+ * A job run by a thread pool. It is owned by the pool from
+ * ff_thread_pool_submit() until func is called, and must not be
+ * submitted again before that.
+ */
+typedef struct FFThreadPoolJob {
+    void (*func)(void *arg);
+    void *arg;
+    struct FFThreadPoolJob *next;
+} FFThreadPoolJob;
+
+/**
+ * Create a pool of nb_threads worker threads, or one per CPU if
+ * nb_threads <= 0. The workers are joined when the last reference
+ * to the returned buffer is released.
+ */
+AVBufferRef *ff_thread_pool_alloc(int nb_threads);
+
+/**
+ * Queue a job on the pool. Jobs are started in submission order, so a job
+ * may block waiting for jobs submitted before it, but never on later ones.
+ */
+void ff_thread_pool_submit(AVBufferRef *pool, FFThreadPoolJob *job);
+
 #define THREAD_SENTINEL 0 // This forbids putting a mutex/condition variable at the front.
 /**
  * Initialize/destroy a list of mutexes/conditions contained in a structure.
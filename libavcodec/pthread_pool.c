@@ -0,0 +1,163 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file
+ * Worker thread pool shared between codec contexts
+ */
+
+#include <stdio.h>
+
+#include "libavutil/buffer.h"
+#include "libavutil/cpu.h"
+#include "libavutil/mem.h"
+#include "libavutil/thread.h"
+
+#include "pthread_internal.h"
+
+typedef struct ThreadPool {
+    pthread_t      *threads;
+    int             nb_threads;
+
+    unsigned        pthread_init_cnt;  ///< Number of successfully initialized mutexes/conditions
+    pthread_mutex_t mutex;             ///< Protects the job queue and die.
+    pthread_cond_t  cond;              ///< Signalled when a job is queued or die is set.
+
+    FFThreadPoolJob  *first;
+    FFThreadPoolJob **last;
+    int               die;
+} ThreadPool;
+
+#define OFF(member) offsetof(ThreadPool, member)
+DEFINE_OFFSET_ARRAY(ThreadPool, pool, pthread_init_cnt,
+                    (OFF(mutex)), (OFF(cond)));
+#undef OFF
+
+typedef struct WorkerArg {
+    ThreadPool *pool;
+    int         idx;
+} WorkerArg;
+
+static attribute_align_arg void *pool_worker(void *arg)
+{
+    ThreadPool *pool = ((WorkerArg *)arg)->pool;
+    char name[16];
+
+    snprintf(name, sizeof(name), "av:pool:%d", ((WorkerArg *)arg)->idx);
+    ff_thread_setname(name);
+    av_free(arg);
+
+    pthread_mutex_lock(&pool->mutex);
+    while (1) {
+        FFThreadPoolJob *job;
+
+        while (!pool->first && !pool->die)
+            pthread_cond_wait(&pool->cond, &pool->mutex);
+        if (pool->die)
+            break;
+
+        job = pool->first;
+        pool->first = job->next;
+        if (!pool->first)
+            pool->last = &pool->first;
+        pthread_mutex_unlock(&pool->mutex);
+
+        /* The job belongs to the submitter again once it has been
+         * dequeued, so it must not be touched after this call. */
+        job->func(job->arg);
+
+        pthread_mutex_lock(&pool->mutex);
+    }
+    pthread_mutex_unlock(&pool->mutex);
+
+    return NULL;
+}
+
+static void pool_free(void *opaque, uint8_t *data)
+{
+    ThreadPool *pool = (ThreadPool *)data;
+
+    if (pool->nb_threads) {
+        pthread_mutex_lock(&pool->mutex);
+        pool->die = 1;
+        pthread_cond_broadcast(&pool->cond);
+        pthread_mutex_unlock(&pool->mutex);
+
+        for (int i = 0; i < pool->nb_threads; i++)
+            pthread_join(pool->threads[i], NULL);
+    }
+
+    ff_pthread_free(pool, pool_offsets);
+    av_freep(&pool->threads);
+    av_free(pool);
+}
+
+AVBufferRef *ff_thread_pool_alloc(int nb_threads)
+{
+    ThreadPool *pool;
+    AVBufferRef *buf;
+
+    if (nb_threads <= 0)
+        nb_threads = av_cpu_count();
+
+    pool = av_mallocz(sizeof(*pool));
+    if (!pool)
+        return NULL;
+    pool->last = &pool->first;
+
+    buf = av_buffer_create((uint8_t *)pool, sizeof(*pool), pool_free, NULL, 0);
+    if (!buf) {
+        av_free(pool);
+        return NULL;
+    }
+
+    pool->threads = av_calloc(nb_threads, sizeof(*pool->threads));
+    if (!pool->threads || ff_pthread_init(pool, pool_offsets) < 0)
+        goto fail;
+
+    for (; pool->nb_threads < nb_threads; pool->nb_threads++) {
+        WorkerArg *arg = av_malloc(sizeof(*arg));
+
+        if (!arg)
+            goto fail;
+        arg->pool = pool;
+        arg->idx  = pool->nb_threads;
+        if (pthread_create(&pool->threads[pool->nb_threads], NULL, pool_worker, arg)) {
+            av_free(arg);
+            goto fail;
+        }
+    }
+
+    return buf;
+fail:
+    av_buffer_unref(&buf);
+    return NULL;
+}
+
+void ff_thread_pool_submit(AVBufferRef *buf, FFThreadPoolJob *job)
+{
+    ThreadPool *pool = (ThreadPool *)buf->data;
+
+    job->next = NULL;
+
+    pthread_mutex_lock(&pool->mutex);
+    *pool->last = job;
+    pool->last  = &job->next;
+    pthread_cond_signal(&pool->cond);
+    pthread_mutex_unlock(&pool->mutex);
+}
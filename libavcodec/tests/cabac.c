@@ -140,7 +140,7 @@ int main(void){
     CABACTestContext c;
     uint8_t b[9*SIZE];
     uint8_t r[9*SIZE];
-    int i, ret = 0;
+    int i, j, ret = 0;
     uint8_t state[10]= {0};
     AVLFG prng;
 
@@ -156,6 +156,10 @@ int main(void){
         put_cabac_bypass(&c, r[i]&1);
     }
 
+    for(i=0; i<SIZE; i++){
+        put_cabac_bypass(&c, (r[i]>>1)&1);
+    }
+
     for(i=0; i<SIZE; i++){
         put_cabac(&c, state, r[i]&1);
     }
@@ -175,6 +179,17 @@ int main(void){
         }
     }
 
+    for(i=0; i<SIZE; ){
+        int n = FFMIN(1 + i % 32, SIZE - i);
+        unsigned bits = get_cabac_bypass_bits(&c.dec, n);
+        for (j = 0; j < n; j++, i++) {
+            if (((r[i] >> 1) & 1) != ((bits >> (n - 1 - j)) & 1)) {
+                av_log(NULL, AV_LOG_ERROR, "CABAC bypass bits failure at %d\n", i);
+                ret = 1;
+            }
+        }
+    }
+
     for(i=0; i<SIZE; i++){
         if ((r[i] & 1) != get_cabac_noinline(&c.dec, state)) {
             av_log(NULL, AV_LOG_ERROR, "CABAC failure at %d\n", i);
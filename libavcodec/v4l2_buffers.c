@@ -28,9 +28,12 @@
 #include <fcntl.h>
 #include <poll.h>
 #include "libavcodec/avcodec.h"
+#include "libavutil/hwcontext.h"
+#include "libavutil/imgutils.h"
 #include "libavutil/pixdesc.h"
 #include "v4l2_context.h"
 #include "v4l2_buffers.h"
+#include "v4l2_fmt.h"
 #include "v4l2_m2m.h"
 
 #define USEC_PER_SEC 1000000
@@ -337,6 +340,183 @@ static int v4l2_buffer_buf_to_swframe(AVFrame *frame, V4L2Buffer *avbuf)
     return 0;
 }
 
+static int v4l2_buffer_buf_to_drmframe(AVFrame *frame, V4L2Buffer *avbuf)
+{
+    int ret;
+
+    frame->buf[0] = av_buffer_create((uint8_t *)&avbuf->drm_frame, sizeof(avbuf->drm_frame),
+                                     v4l2_free_buffer, avbuf, AV_BUFFER_FLAG_READONLY);
+    if (!frame->buf[0])
+        return AVERROR(ENOMEM);
+
+    ret = v4l2_buf_increase_ref(avbuf);
+    if (ret) {
+        av_buffer_unref(&frame->buf[0]);
+        return ret;
+    }
+
+    frame->data[0] = (uint8_t *)&avbuf->drm_frame;
+    frame->format  = AV_PIX_FMT_DRM_PRIME;
+
+    frame->hw_frames_ctx = av_buffer_ref(avbuf->context->frames_ref);
+    if (!frame->hw_frames_ctx)
+        return AVERROR(ENOMEM);
+
+    return 0;
+}
+
+static int v4l2_get_drm_layer(V4L2Context *ctx, int num_planes, AVDRMLayerDescriptor *layer)
+{
+    const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(ctx->av_pix_fmt);
+    int height = V4L2_TYPE_IS_MULTIPLANAR(ctx->type) ?
+                 ctx->format.fmt.pix_mp.height : ctx->format.fmt.pix.height;
+    int i;
+
+    if (!desc)
+        return AVERROR(EINVAL);
+
+    layer->format    = ff_v4l2_format_avfmt_to_drm(ctx->av_pix_fmt);
+    layer->nb_planes = av_pix_fmt_count_planes(ctx->av_pix_fmt);
+    if (layer->nb_planes > AV_DRM_MAX_PLANES)
+        return AVERROR(EINVAL);
+
+    /* image planes without a v4l2 plane of their own follow the previous one
+     * in the same buffer, as in v4l2_buffer_buf_to_swframe() */
+    for (i = 0; i < layer->nb_planes; i++) {
+        AVDRMPlaneDescriptor *plane = &layer->planes[i];
+
+        if (i < num_planes) {
+            plane->object_index = i;
+            plane->offset       = 0;
+            plane->pitch        = V4L2_TYPE_IS_MULTIPLANAR(ctx->type) ?
+                                  ctx->format.fmt.pix_mp.plane_fmt[i].bytesperline :
+                                  ctx->format.fmt.pix.bytesperline;
+        } else {
+            const AVDRMPlaneDescriptor *prev = &layer->planes[i - 1];
+            int h = i == 1 ? height : AV_CEIL_RSHIFT(height, desc->log2_chroma_h);
+
+            plane->object_index = prev->object_index;
+            plane->offset       = prev->offset + prev->pitch * h;
+            plane->pitch        = layer->nb_planes > 2 ?
+                                  layer->planes[0].pitch >> desc->log2_chroma_w :
+                                  layer->planes[0].pitch;
+        }
+    }
+
+    return 0;
+}
+
+static int v4l2_buffer_export_drm(V4L2Buffer *avbuf)
+{
+    AVDRMFrameDescriptor *desc = &avbuf->drm_frame;
+    int i, ret;
+
+    ret = v4l2_get_drm_layer(avbuf->context, avbuf->num_planes, &desc->layers[0]);
+    if (ret)
+        return ret;
+    if (!desc->layers[0].format)
+        return AVERROR(EINVAL);
+    desc->nb_layers = 1;
+
+    for (i = 0; i < avbuf->num_planes; i++) {
+        struct v4l2_exportbuffer expbuf = {
+            .type  = avbuf->context->type,
+            .index = avbuf->buf.index,
+            .plane = i,
+            .flags = O_RDWR,
+        };
+
+        ret = ioctl(buf_to_m2mctx(avbuf)->fd, VIDIOC_EXPBUF, &expbuf);
+        if (ret < 0)
+            return AVERROR(errno);
+
+        desc->objects[i].fd              = expbuf.fd;
+        desc->objects[i].size            = avbuf->plane_info[i].length;
+        desc->objects[i].format_modifier = 0; /* DRM_FORMAT_MOD_LINEAR */
+        desc->nb_objects = i + 1;
+    }
+
+    return 0;
+}
+
+static int v4l2_buffer_drmframe_to_buf(const AVFrame *frame, V4L2Buffer *out)
+{
+    const AVDRMFrameDescriptor *desc = (const AVDRMFrameDescriptor *)frame->data[0];
+    int i;
+
+    for (i = 0; i < out->num_planes; i++) {
+        if (V4L2_TYPE_IS_MULTIPLANAR(out->buf.type)) {
+            out->planes[i].m.fd        = desc->objects[i].fd;
+            out->planes[i].length      = desc->objects[i].size;
+            out->planes[i].bytesused   = desc->objects[i].size;
+            out->planes[i].data_offset = 0;
+        } else {
+            out->buf.m.fd      = desc->objects[i].fd;
+            out->buf.length    = desc->objects[i].size;
+            out->buf.bytesused = desc->objects[i].size;
+        }
+    }
+
+    /* the dmabufs must stay valid until the driver returns the buffer */
+    av_buffer_unref(&out->dmabuf_ref);
+    out->dmabuf_ref = av_buffer_ref(frame->buf[0]);
+    if (!out->dmabuf_ref)
+        return AVERROR(ENOMEM);
+
+    return 0;
+}
+
+static int v4l2_buffer_mapped_drmframe_to_buf(const AVFrame *frame, V4L2Buffer *out)
+{
+    V4L2Context *ctx = out->context;
+    AVDRMLayerDescriptor layer;
+    AVFrame *map;
+    int i, ret;
+
+    ret = v4l2_get_drm_layer(ctx, out->num_planes, &layer);
+    if (ret)
+        return ret;
+
+    map = av_frame_alloc();
+    if (!map)
+        return AVERROR(ENOMEM);
+    map->format = ctx->av_pix_fmt;
+
+    ret = av_hwframe_map(map, frame, AV_HWFRAME_MAP_READ);
+    if (ret)
+        goto fail;
+
+    for (i = 0; i < layer.nb_planes; i++) {
+        const AVDRMPlaneDescriptor *plane = &layer.planes[i];
+        struct V4L2Plane_info *info = &out->plane_info[plane->object_index];
+        int bytewidth = av_image_get_linesize(ctx->av_pix_fmt, frame->width, i);
+        int h = i ? AV_CEIL_RSHIFT(frame->height, av_pix_fmt_desc_get(ctx->av_pix_fmt)->log2_chroma_h) :
+                    frame->height;
+
+        if (bytewidth < 0 || plane->offset + plane->pitch * h > info->length) {
+            ret = AVERROR(EINVAL);
+            goto fail;
+        }
+
+        av_image_copy_plane((uint8_t *)info->mm_addr + plane->offset, plane->pitch,
+                            map->data[i], map->linesize[i], bytewidth, h);
+    }
+
+    for (i = 0; i < out->num_planes; i++) {
+        if (V4L2_TYPE_IS_MULTIPLANAR(out->buf.type)) {
+            out->planes[i].bytesused = out->plane_info[i].length;
+            out->planes[i].length    = out->plane_info[i].length;
+        } else {
+            out->buf.bytesused = out->plane_info[i].length;
+            out->buf.length    = out->plane_info[i].length;
+        }
+    }
+
+fail:
+    av_frame_free(&map);
+    return ret;
+}
+
 static int v4l2_buffer_swframe_to_buf(const AVFrame *frame, V4L2Buffer *out)
 {
     int i, ret;
@@ -412,9 +592,56 @@ int ff_v4l2_buffer_avframe_to_buf(const AVFrame *frame, V4L2Buffer *out)
 {
     v4l2_set_pts(out, frame->pts);
 
+    if (out->context->memory == V4L2_MEMORY_DMABUF)
+        return v4l2_buffer_drmframe_to_buf(frame, out);
+
+    if (frame->format == AV_PIX_FMT_DRM_PRIME)
+        return v4l2_buffer_mapped_drmframe_to_buf(frame, out);
+
     return v4l2_buffer_swframe_to_buf(frame, out);
 }
 
+int ff_v4l2_buffer_drm_importable(V4L2Buffer *avbuf, const AVFrame *frame)
+{
+    const AVDRMFrameDescriptor *desc = (const AVDRMFrameDescriptor *)frame->data[0];
+    const AVDRMLayerDescriptor *l;
+    AVDRMLayerDescriptor layer;
+    int i;
+
+    if (frame->format != AV_PIX_FMT_DRM_PRIME || !desc)
+        return 0;
+
+    if (v4l2_get_drm_layer(avbuf->context, avbuf->num_planes, &layer) < 0 || !layer.format)
+        return 0;
+
+    /* the driver expects one dmabuf per v4l2 plane, laid out as it reported */
+    if (desc->nb_objects != avbuf->num_planes)
+        return 0;
+
+    for (i = 0; i < desc->nb_objects; i++) {
+        if (desc->objects[i].size < avbuf->plane_info[i].length)
+            return 0;
+    }
+
+    /* the layer format of descriptors with one layer per plane (e.g. R8 and
+     * GR88 for NV12) can't be checked against the driver's, so copy those */
+    if (desc->nb_layers != 1)
+        return 0;
+
+    l = &desc->layers[0];
+    if (l->format != layer.format || l->nb_planes != layer.nb_planes)
+        return 0;
+
+    for (i = 0; i < l->nb_planes; i++) {
+        if (l->planes[i].object_index != layer.planes[i].object_index ||
+            l->planes[i].offset       != layer.planes[i].offset       ||
+            l->planes[i].pitch        != layer.planes[i].pitch)
+            return 0;
+    }
+
+    return 1;
+}
+
 int ff_v4l2_buffer_buf_to_avframe(AVFrame *frame, V4L2Buffer *avbuf)
 {
     int ret;
@@ -422,7 +649,10 @@ int ff_v4l2_buffer_buf_to_avframe(AVFrame *frame, V4L2Buffer *avbuf)
     av_frame_unref(frame);
 
     /* 1. get references to the actual data */
-    ret = v4l2_buffer_buf_to_swframe(frame, avbuf);
+    if (buf_to_m2mctx(avbuf)->output_drm)
+        ret = v4l2_buffer_buf_to_drmframe(frame, avbuf);
+    else
+        ret = v4l2_buffer_buf_to_swframe(frame, avbuf);
     if (ret)
         return ret;
 
@@ -494,9 +724,10 @@ int ff_v4l2_buffer_avpkt_to_buf(const AVPacket *pkt, V4L2Buffer *out)
 int ff_v4l2_buffer_initialize(V4L2Buffer* avbuf, int index)
 {
     V4L2Context *ctx = avbuf->context;
+    int export_drm = !V4L2_TYPE_IS_OUTPUT(ctx->type) && buf_to_m2mctx(avbuf)->output_drm;
     int ret, i;
 
-    avbuf->buf.memory = V4L2_MEMORY_MMAP;
+    avbuf->buf.memory = ctx->memory;
     avbuf->buf.type = ctx->type;
     avbuf->buf.index = index;
 
@@ -525,6 +756,13 @@ int ff_v4l2_buffer_initialize(V4L2Buffer* avbuf, int index)
             ctx->format.fmt.pix_mp.plane_fmt[i].bytesperline :
             ctx->format.fmt.pix.bytesperline;
 
+        if (export_drm || ctx->memory == V4L2_MEMORY_DMABUF) {
+            /* the planes are accessed through exported or imported dmabufs */
+            avbuf->plane_info[i].length = V4L2_TYPE_IS_MULTIPLANAR(ctx->type) ?
+                avbuf->buf.m.planes[i].length : avbuf->buf.length;
+            continue;
+        }
+
         if (V4L2_TYPE_IS_MULTIPLANAR(ctx->type)) {
             avbuf->plane_info[i].length = avbuf->buf.m.planes[i].length;
             avbuf->plane_info[i].mm_addr = mmap(NULL, avbuf->buf.m.planes[i].length,
@@ -541,6 +779,12 @@ int ff_v4l2_buffer_initialize(V4L2Buffer* avbuf, int index)
             return AVERROR(ENOMEM);
     }
 
+    if (export_drm) {
+        ret = v4l2_buffer_export_drm(avbuf);
+        if (ret)
+            return ret;
+    }
+
     avbuf->status = V4L2BUF_AVAILABLE;
 
     if (V4L2_TYPE_IS_OUTPUT(ctx->type))
@@ -569,6 +813,7 @@ int ff_v4l2_buffer_enqueue(V4L2Buffer* avbuf)
         return AVERROR(errno);
 
     avbuf->status = V4L2BUF_IN_DRIVER;
+    atomic_fetch_add(&avbuf->context->num_queued, 1);
 
     return 0;
 }
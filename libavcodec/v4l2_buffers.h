@@ -30,6 +30,7 @@
 
 #include "libavutil/buffer.h"
 #include "libavutil/frame.h"
+#include "libavutil/hwcontext_drm.h"
 #include "packet.h"
 
 enum V4L2Buffer_status {
@@ -59,6 +60,14 @@ typedef struct V4L2Buffer {
 
     int num_planes;
 
+    /* dmabufs exported from the capture planes, only used when the
+     * buffers are returned as AV_PIX_FMT_DRM_PRIME frames */
+    AVDRMFrameDescriptor drm_frame;
+
+    /* reference to the imported DRM_PRIME frame while the driver owns the
+     * buffer (V4L2_MEMORY_DMABUF output contexts) */
+    AVBufferRef *dmabuf_ref;
+
     /* the v4l2_buffer buf.m.planes pointer uses the planes[] mem */
     struct v4l2_buffer buf;
     struct v4l2_plane planes[VIDEO_MAX_PLANES];
@@ -66,6 +75,9 @@ typedef struct V4L2Buffer {
     int flags;
     enum V4L2Buffer_status status;
 
+    /* next buffer in the context's free list */
+    struct V4L2Buffer *next_free;
+
 } V4L2Buffer;
 
 /**
@@ -111,6 +123,18 @@ int ff_v4l2_buffer_avpkt_to_buf(const AVPacket *pkt, V4L2Buffer *out);
  */
 int ff_v4l2_buffer_avframe_to_buf(const AVFrame *frame, V4L2Buffer *out);
 
+/**
+ * Checks whether an AV_PIX_FMT_DRM_PRIME frame can be queued to a
+ * V4L2_MEMORY_DMABUF buffer as is, ie. whether its dmabufs match the plane
+ * layout the driver expects.
+ *
+ * @param[in]  avbuf V4L2Buffer the frame would be queued to
+ * @param[in]  frame AVFrame to check
+ *
+ * @returns 1 if the frame can be imported, 0 otherwise
+ */
+int ff_v4l2_buffer_drm_importable(V4L2Buffer *avbuf, const AVFrame *frame);
+
 /**
  * Initializes a V4L2Buffer
  *
@@ -182,7 +182,9 @@ static int v4l2_handle_event(V4L2Context *ctx)
 
     ret = ioctl(s->fd, VIDIOC_DQEVENT, &evt);
     if (ret < 0) {
-        av_log(logger(ctx), AV_LOG_ERROR, "%s VIDIOC_DQEVENT\n", ctx->name);
+        /* ENOENT: no event pending */
+        if (errno != ENOENT)
+            av_log(logger(ctx), AV_LOG_ERROR, "%s VIDIOC_DQEVENT\n", ctx->name);
         return 0;
     }
 
@@ -205,6 +207,14 @@ static int v4l2_handle_event(V4L2Context *ctx)
         s->capture.width = v4l2_get_width(&cap_fmt);
         s->capture.sample_aspect_ratio = v4l2_get_sar(&s->capture);
     } else {
+        /* same resolution: the stream may still need more buffers (ie, a deeper DPB) */
+        ret = ff_v4l2_m2m_get_capture_buffer_count(s);
+        if (s->capture.buffers && ret > s->capture.num_buffers) {
+            ret = ff_v4l2_context_add_buffers(&s->capture, ret - s->capture.num_buffers);
+            if (ret < 0)
+                av_log(logger(ctx), AV_LOG_WARNING, "%s can't add buffers (%s)\n",
+                       s->capture.name, av_err2str(ret));
+        }
         v4l2_start_decode(ctx);
         return 0;
     }
@@ -266,51 +276,128 @@ static int v4l2_stop_encode(V4L2Context *ctx)
     return 0;
 }
 
-static V4L2Buffer* v4l2_dequeue_v4l2buf(V4L2Context *ctx, int timeout)
+static void v4l2_putfree_v4l2buf(V4L2Context *ctx, V4L2Buffer *avbuf)
 {
+    avbuf->next_free = ctx->free_buffers;
+    ctx->free_buffers = avbuf;
+}
+
+/**
+ * dequeue a buffer without waiting for the driver
+ * returns 0 and the buffer in avbuf, AVERROR(EAGAIN) if no buffer is ready,
+ * AVERROR_EOF if the context is done
+ */
+static int v4l2_dqbuf(V4L2Context *ctx, V4L2Buffer **pavbuf)
+{
+    V4L2m2mContext *s = ctx_to_m2mctx(ctx);
     struct v4l2_plane planes[VIDEO_MAX_PLANES];
     struct v4l2_buffer buf = { 0 };
     V4L2Buffer *avbuf;
+    int ret;
+
+    buf.memory = ctx->memory;
+    buf.type = ctx->type;
+    if (V4L2_TYPE_IS_MULTIPLANAR(ctx->type)) {
+        memset(planes, 0, sizeof(planes));
+        buf.length = VIDEO_MAX_PLANES;
+        buf.m.planes = planes;
+    }
+
+    ret = ioctl(s->fd, VIDIOC_DQBUF, &buf);
+    if (ret) {
+        if (errno == EAGAIN)
+            return AVERROR(EAGAIN);
+
+        ctx->done = 1;
+        if (errno != EPIPE)
+            av_log(logger(ctx), AV_LOG_DEBUG, "%s VIDIOC_DQBUF, errno (%s)\n",
+                ctx->name, av_err2str(AVERROR(errno)));
+        return AVERROR_EOF;
+    }
+
+    avbuf = &ctx->buffers[buf.index];
+    avbuf->status = V4L2BUF_AVAILABLE;
+    avbuf->buf = buf;
+    if (V4L2_TYPE_IS_MULTIPLANAR(ctx->type)) {
+        memcpy(avbuf->planes, planes, sizeof(planes));
+        avbuf->buf.m.planes = avbuf->planes;
+    }
+    av_buffer_unref(&avbuf->dmabuf_ref);
+    atomic_fetch_sub(&ctx->num_queued, 1);
+
+    if (V4L2_TYPE_IS_OUTPUT(ctx->type)) {
+        v4l2_putfree_v4l2buf(ctx, avbuf);
+    } else if (s->draining) {
+        int bytesused = V4L2_TYPE_IS_MULTIPLANAR(buf.type) ?
+                        buf.m.planes[0].bytesused : buf.bytesused;
+        if (bytesused == 0) {
+            ctx->done = 1;
+            return AVERROR_EOF;
+        }
+#ifdef V4L2_BUF_FLAG_LAST
+        if (buf.flags & V4L2_BUF_FLAG_LAST)
+            ctx->done = 1;
+#endif
+    }
+
+    *pavbuf = avbuf;
+
+    return 0;
+}
+
+static V4L2Buffer* v4l2_dequeue_v4l2buf(V4L2Context *ctx, int timeout)
+{
+    V4L2m2mContext *s = ctx_to_m2mctx(ctx);
+    V4L2Buffer *avbuf;
     struct pollfd pfd = {
         .events =  POLLIN | POLLRDNORM | POLLPRI | POLLOUT | POLLWRNORM, /* default blocking capture */
-        .fd = ctx_to_m2mctx(ctx)->fd,
+        .fd = s->fd,
     };
-    int i, ret;
+    int ret;
+
+    if (!V4L2_TYPE_IS_OUTPUT(ctx->type)) {
+        /* capture buffer initialization happens during decode hence
+         * detection happens at runtime
+         */
+        int queued = ctx->buffers ? atomic_load(&ctx->num_queued) : 0;
 
-    if (!V4L2_TYPE_IS_OUTPUT(ctx->type) && ctx->buffers) {
-        for (i = 0; i < ctx->num_buffers; i++) {
-            if (ctx->buffers[i].status == V4L2BUF_IN_DRIVER)
-                break;
+        /* if we are draining and there are no more capture buffers queued in the driver we are done */
+        if (!queued && s->draining) {
+            ctx->done = 1;
+            return NULL;
         }
-        if (i == ctx->num_buffers)
+
+        if (!queued && ctx->buffers)
             av_log(logger(ctx), AV_LOG_WARNING, "All capture buffers returned to "
                                                 "userspace. Increase num_capture_buffers "
                                                 "to prevent device deadlock or dropped "
                                                 "packets/frames.\n");
     }
 
-    /* if we are draining and there are no more capture buffers queued in the driver we are done */
-    if (!V4L2_TYPE_IS_OUTPUT(ctx->type) && ctx_to_m2mctx(ctx)->draining) {
-        for (i = 0; i < ctx->num_buffers; i++) {
-            /* capture buffer initialization happens during decode hence
-             * detection happens at runtime
-             */
-            if (!ctx->buffers)
-                break;
+    /* 1. the buffer has usually completed already: dequeue it without waiting */
+    if (ctx->streamon) {
+        ret = v4l2_dqbuf(ctx, &avbuf);
+        if (!ret)
+            return avbuf;
+        if (ret != AVERROR(EAGAIN))
+            return NULL;
+    }
 
-            if (ctx->buffers[i].status == V4L2BUF_IN_DRIVER)
-                goto start;
-        }
-        ctx->done = 1;
+    /* nothing to wait for: pick up a pending source change or end of stream
+     * event without going through poll()
+     */
+    if (!timeout) {
+        if (!V4L2_TYPE_IS_OUTPUT(ctx->type) && v4l2_handle_event(ctx) < 0)
+            ctx->done = 1;
         return NULL;
     }
 
-start:
+    /* 2. wait for a completed buffer, room for more input or a driver event */
     if (V4L2_TYPE_IS_OUTPUT(ctx->type))
         pfd.events =  POLLOUT | POLLWRNORM;
     else {
         /* no need to listen to requests for more input while draining */
-        if (ctx_to_m2mctx(ctx)->draining)
+        if (s->draining)
             pfd.events =  POLLIN | POLLRDNORM | POLLPRI;
     }
 
@@ -318,28 +405,21 @@ start:
         ret = poll(&pfd, 1, timeout);
         if (ret > 0)
             break;
-        if (errno == EINTR)
+        if (ret < 0 && errno == EINTR)
             continue;
         return NULL;
     }
 
-    /* 0. handle errors */
+    /* 3. handle errors */
     if (pfd.revents & POLLERR) {
-        /* if we are trying to get free buffers but none have been queued yet
-           no need to raise a warning */
-        if (timeout == 0) {
-            for (i = 0; i < ctx->num_buffers; i++) {
-                if (ctx->buffers[i].status != V4L2BUF_AVAILABLE)
-                    av_log(logger(ctx), AV_LOG_WARNING, "%s POLLERR\n", ctx->name);
-            }
-        }
-        else
+        /* no need to raise a warning if no buffers have been queued yet */
+        if (ctx->buffers && atomic_load(&ctx->num_queued))
             av_log(logger(ctx), AV_LOG_WARNING, "%s POLLERR\n", ctx->name);
 
         return NULL;
     }
 
-    /* 1. handle resolution changes */
+    /* 4. handle resolution changes and end of stream */
     if (pfd.revents & POLLPRI) {
         ret = v4l2_handle_event(ctx);
         if (ret < 0) {
@@ -355,91 +435,95 @@ start:
         }
     }
 
-    /* 2. dequeue the buffer */
-    if (pfd.revents & (POLLIN | POLLRDNORM | POLLOUT | POLLWRNORM)) {
-
-        if (!V4L2_TYPE_IS_OUTPUT(ctx->type)) {
-            /* there is a capture buffer ready */
-            if (pfd.revents & (POLLIN | POLLRDNORM))
-                goto dequeue;
+    /* 5. dequeue the buffer the driver signalled; for capture, a POLLOUT alone
+     *    means the driver is ready to accept more input: instead of waiting for
+     *    the capture buffer to complete we return NULL so input can proceed
+     *    (we are single threaded)
+     */
+    if (ctx->streamon &&
+        pfd.revents & (V4L2_TYPE_IS_OUTPUT(ctx->type) ? POLLOUT | POLLWRNORM :
+                                                        POLLIN | POLLRDNORM)) {
+        ret = v4l2_dqbuf(ctx, &avbuf);
+        if (!ret)
+            return avbuf;
+    }
 
-            /* the driver is ready to accept more input; instead of waiting for the capture
-             * buffer to complete we return NULL so input can proceed (we are single threaded)
-             */
-            if (pfd.revents & (POLLOUT | POLLWRNORM))
-                return NULL;
-        }
+    return NULL;
+}
 
-dequeue:
-        memset(&buf, 0, sizeof(buf));
-        buf.memory = V4L2_MEMORY_MMAP;
-        buf.type = ctx->type;
-        if (V4L2_TYPE_IS_MULTIPLANAR(ctx->type)) {
-            memset(planes, 0, sizeof(planes));
-            buf.length = VIDEO_MAX_PLANES;
-            buf.m.planes = planes;
-        }
+/**
+ * VIDIOC_STREAMOFF returns every queued buffer to userspace without them
+ * being dequeued: update the bookkeeping accordingly
+ */
+static void v4l2_reclaim_buffers(V4L2Context *ctx)
+{
+    int i;
 
-        ret = ioctl(ctx_to_m2mctx(ctx)->fd, VIDIOC_DQBUF, &buf);
-        if (ret) {
-            if (errno != EAGAIN) {
-                ctx->done = 1;
-                if (errno != EPIPE)
-                    av_log(logger(ctx), AV_LOG_DEBUG, "%s VIDIOC_DQBUF, errno (%s)\n",
-                        ctx->name, av_err2str(AVERROR(errno)));
-            }
-            return NULL;
-        }
+    for (i = 0; i < ctx->num_buffers; i++) {
+        V4L2Buffer *avbuf = &ctx->buffers[i];
 
-        if (ctx_to_m2mctx(ctx)->draining && !V4L2_TYPE_IS_OUTPUT(ctx->type)) {
-            int bytesused = V4L2_TYPE_IS_MULTIPLANAR(buf.type) ?
-                            buf.m.planes[0].bytesused : buf.bytesused;
-            if (bytesused == 0) {
-                ctx->done = 1;
-                return NULL;
-            }
-#ifdef V4L2_BUF_FLAG_LAST
-            if (buf.flags & V4L2_BUF_FLAG_LAST)
-                ctx->done = 1;
-#endif
-        }
+        if (avbuf->status != V4L2BUF_IN_DRIVER)
+            continue;
 
-        avbuf = &ctx->buffers[buf.index];
         avbuf->status = V4L2BUF_AVAILABLE;
-        avbuf->buf = buf;
-        if (V4L2_TYPE_IS_MULTIPLANAR(ctx->type)) {
-            memcpy(avbuf->planes, planes, sizeof(planes));
-            avbuf->buf.m.planes = avbuf->planes;
+        av_buffer_unref(&avbuf->dmabuf_ref);
+    }
+
+    if (V4L2_TYPE_IS_OUTPUT(ctx->type)) {
+        ctx->free_buffers = NULL;
+        for (i = ctx->num_buffers - 1; i >= 0; i--) {
+            if (ctx->buffers[i].status == V4L2BUF_AVAILABLE)
+                v4l2_putfree_v4l2buf(ctx, &ctx->buffers[i]);
         }
-        return avbuf;
     }
 
-    return NULL;
+    atomic_store(&ctx->num_queued, 0);
+}
+
+/**
+ * give the capture buffers reclaimed on VIDIOC_STREAMOFF back to the driver;
+ * the ones still referenced by frames are queued when they are released
+ */
+static void v4l2_requeue_capture_buffers(V4L2Context *ctx)
+{
+    int i, ret;
+
+    for (i = 0; i < ctx->num_buffers; i++) {
+        V4L2Buffer *avbuf = &ctx->buffers[i];
+
+        if (avbuf->status != V4L2BUF_AVAILABLE)
+            continue;
+
+        ret = ff_v4l2_buffer_enqueue(avbuf);
+        if (ret < 0)
+            av_log(logger(ctx), AV_LOG_WARNING, "%s buffer[%d] requeue (%s)\n",
+                   ctx->name, i, av_err2str(ret));
+    }
 }
 
 static V4L2Buffer* v4l2_getfree_v4l2buf(V4L2Context *ctx)
 {
-    int timeout = 0; /* return when no more buffers to dequeue */
-    int i;
+    V4L2Buffer *avbuf;
 
     /* get back as many output buffers as possible */
-    if (V4L2_TYPE_IS_OUTPUT(ctx->type)) {
-          do {
-          } while (v4l2_dequeue_v4l2buf(ctx, timeout));
+    if (V4L2_TYPE_IS_OUTPUT(ctx->type) && ctx->streamon) {
+        while (!v4l2_dqbuf(ctx, &avbuf))
+            ;
     }
 
-    for (i = 0; i < ctx->num_buffers; i++) {
-        if (ctx->buffers[i].status == V4L2BUF_AVAILABLE)
-            return &ctx->buffers[i];
+    avbuf = ctx->free_buffers;
+    if (avbuf) {
+        ctx->free_buffers = avbuf->next_free;
+        avbuf->next_free = NULL;
     }
 
-    return NULL;
+    return avbuf;
 }
 
 static int v4l2_release_buffers(V4L2Context* ctx)
 {
     struct v4l2_requestbuffers req = {
-        .memory = V4L2_MEMORY_MMAP,
+        .memory = ctx->memory,
         .type = ctx->type,
         .count = 0, /* 0 -> unmaps buffers from the driver */
     };
@@ -454,6 +538,11 @@ static int v4l2_release_buffers(V4L2Context* ctx)
                 if (munmap(p->mm_addr, p->length) < 0)
                     av_log(logger(ctx), AV_LOG_ERROR, "%s unmap plane (%s))\n", ctx->name, av_err2str(AVERROR(errno)));
         }
+
+        for (j = 0; j < buffer->drm_frame.nb_objects; j++)
+            close(buffer->drm_frame.objects[j].fd);
+
+        av_buffer_unref(&buffer->dmabuf_ref);
     }
 
     return ioctl(ctx_to_m2mctx(ctx)->fd, VIDIOC_REQBUFS, &req);
@@ -566,6 +655,14 @@ int ff_v4l2_context_set_status(V4L2Context* ctx, uint32_t cmd)
 
     ctx->streamon = (cmd == VIDIOC_STREAMON);
 
+    if (!ctx->buffers)
+        return 0;
+
+    if (cmd == VIDIOC_STREAMOFF)
+        v4l2_reclaim_buffers(ctx);
+    else if (!V4L2_TYPE_IS_OUTPUT(ctx->type))
+        v4l2_requeue_capture_buffers(ctx);
+
     return 0;
 }
 
@@ -587,11 +684,33 @@ int ff_v4l2_context_enqueue_frame(V4L2Context* ctx, const AVFrame* frame)
     if (!avbuf)
         return AVERROR(EAGAIN);
 
+    if (ctx->memory == V4L2_MEMORY_DMABUF && !ff_v4l2_buffer_drm_importable(avbuf, frame)) {
+        /* the queue type can only be changed before streaming starts */
+        if (ctx->streamon) {
+            av_log(logger(ctx), AV_LOG_ERROR, "%s: DRM frame layout changed while streaming\n", ctx->name);
+            return AVERROR(EINVAL);
+        }
+
+        av_log(logger(ctx), AV_LOG_VERBOSE, "%s: DRM frame layout does not match the driver's, "
+                                            "falling back to copying frames\n", ctx->name);
+        ff_v4l2_context_release(ctx);
+        ctx->memory = V4L2_MEMORY_MMAP;
+        ret = ff_v4l2_context_init(ctx);
+        if (ret)
+            return ret;
+
+        avbuf = v4l2_getfree_v4l2buf(ctx);
+        if (!avbuf)
+            return AVERROR(EAGAIN);
+    }
+
     ret = ff_v4l2_buffer_avframe_to_buf(frame, avbuf);
+    if (!ret)
+        ret = ff_v4l2_buffer_enqueue(avbuf);
     if (ret)
-        return ret;
+        v4l2_putfree_v4l2buf(ctx, avbuf);
 
-    return ff_v4l2_buffer_enqueue(avbuf);
+    return ret;
 }
 
 int ff_v4l2_context_enqueue_packet(V4L2Context* ctx, const AVPacket* pkt)
@@ -613,10 +732,12 @@ int ff_v4l2_context_enqueue_packet(V4L2Context* ctx, const AVPacket* pkt)
         return AVERROR(EAGAIN);
 
     ret = ff_v4l2_buffer_avpkt_to_buf(pkt, avbuf);
+    if (!ret)
+        ret = ff_v4l2_buffer_enqueue(avbuf);
     if (ret)
-        return ret;
+        v4l2_putfree_v4l2buf(ctx, avbuf);
 
-    return ff_v4l2_buffer_enqueue(avbuf);
+    return ret;
 }
 
 int ff_v4l2_context_dequeue_frame(V4L2Context* ctx, AVFrame* frame, int timeout)
@@ -695,6 +816,8 @@ void ff_v4l2_context_release(V4L2Context* ctx)
 {
     int ret;
 
+    av_buffer_unref(&ctx->frames_ref);
+
     if (!ctx->buffers)
         return;
 
@@ -703,6 +826,50 @@ void ff_v4l2_context_release(V4L2Context* ctx)
         av_log(logger(ctx), AV_LOG_WARNING, "V4L2 failed to unmap the %s buffers\n", ctx->name);
 
     av_freep(&ctx->buffers);
+    ctx->free_buffers = NULL;
+}
+
+int ff_v4l2_context_add_buffers(V4L2Context* ctx, int count)
+{
+    struct v4l2_create_buffers create = {
+        .memory = ctx->memory,
+        .format = ctx->format,
+    };
+    int ret, i;
+
+    /* the buffers array can't be reallocated: frames reference its entries */
+    create.count = FFMIN(count, VIDEO_MAX_FRAME - ctx->num_buffers);
+    if (V4L2_TYPE_IS_OUTPUT(ctx->type) || !ctx->buffers || create.count <= 0)
+        return AVERROR(EINVAL);
+
+    ret = ioctl(ctx_to_m2mctx(ctx)->fd, VIDIOC_CREATE_BUFS, &create);
+    if (ret < 0)
+        return AVERROR(errno);
+
+    if (create.index != ctx->num_buffers || create.index + create.count > VIDEO_MAX_FRAME) {
+        av_log(logger(ctx), AV_LOG_ERROR, "%s unexpected buffer indices %u-%u\n",
+               ctx->name, create.index, create.index + create.count);
+        return AVERROR(EINVAL);
+    }
+
+    for (i = 0; i < create.count; i++) {
+        V4L2Buffer *avbuf = &ctx->buffers[create.index + i];
+
+        avbuf->context = ctx;
+        ret = ff_v4l2_buffer_initialize(avbuf, create.index + i);
+        /* keep count of the buffers the driver created, so they are released */
+        ctx->num_buffers++;
+        if (ret < 0) {
+            av_log(logger(ctx), AV_LOG_ERROR, "%s buffer[%d] initialization (%s)\n",
+                   ctx->name, create.index + i, av_err2str(ret));
+            return ret;
+        }
+    }
+
+    av_log(logger(ctx), AV_LOG_DEBUG, "%s: %d buffers added, %d total\n",
+           ctx->name, create.count, ctx->num_buffers);
+
+    return 0;
 }
 
 int ff_v4l2_context_init(V4L2Context* ctx)
@@ -722,7 +889,7 @@ int ff_v4l2_context_init(V4L2Context* ctx)
 
     memset(&req, 0, sizeof(req));
     req.count = ctx->num_buffers;
-    req.memory = V4L2_MEMORY_MMAP;
+    req.memory = ctx->memory;
     req.type = ctx->type;
     ret = ioctl(s->fd, VIDIOC_REQBUFS, &req);
     if (ret < 0) {
@@ -730,13 +897,18 @@ int ff_v4l2_context_init(V4L2Context* ctx)
         return AVERROR(errno);
     }
 
+    /* capture pools may grow later on: room for as many buffers as a queue can hold */
     ctx->num_buffers = req.count;
-    ctx->buffers = av_mallocz(ctx->num_buffers * sizeof(V4L2Buffer));
+    ctx->buffers = av_calloc(V4L2_TYPE_IS_OUTPUT(ctx->type) ? req.count : FFMAX(req.count, VIDEO_MAX_FRAME),
+                             sizeof(V4L2Buffer));
     if (!ctx->buffers) {
         av_log(logger(ctx), AV_LOG_ERROR, "%s malloc enomem\n", ctx->name);
         return AVERROR(ENOMEM);
     }
 
+    ctx->free_buffers = NULL;
+    atomic_init(&ctx->num_queued, 0);
+
     for (i = 0; i < req.count; i++) {
         ctx->buffers[i].context = ctx;
         ret = ff_v4l2_buffer_initialize(&ctx->buffers[i], i);
@@ -746,6 +918,12 @@ int ff_v4l2_context_init(V4L2Context* ctx)
         }
     }
 
+    /* output buffers start in userspace, ready to be filled */
+    if (V4L2_TYPE_IS_OUTPUT(ctx->type)) {
+        for (i = req.count - 1; i >= 0; i--)
+            v4l2_putfree_v4l2buf(ctx, &ctx->buffers[i]);
+    }
+
     av_log(logger(ctx), AV_LOG_DEBUG, "%s: %s %02d buffers initialized: %04ux%04u, sizeimage %08u, bytesperline %08u\n", ctx->name,
         V4L2_TYPE_IS_MULTIPLANAR(ctx->type) ? av_fourcc2str(ctx->format.fmt.pix_mp.pixelformat) : av_fourcc2str(ctx->format.fmt.pix.pixelformat),
         req.count,
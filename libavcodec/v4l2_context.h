@@ -24,9 +24,11 @@
 #ifndef AVCODEC_V4L2_CONTEXT_H
 #define AVCODEC_V4L2_CONTEXT_H
 
+#include <stdatomic.h>
 #include <stdint.h>
 #include <linux/videodev2.h>
 
+#include "libavutil/buffer.h"
 #include "libavutil/pixfmt.h"
 #include "libavutil/frame.h"
 #include "libavutil/rational.h"
@@ -82,6 +84,31 @@ typedef struct V4L2Context {
      */
     int num_buffers;
 
+    /**
+     * Output buffers owned by userspace and ready to be filled, linked
+     * through V4L2Buffer.next_free.
+     */
+    V4L2Buffer *free_buffers;
+
+    /**
+     * Number of buffers currently queued in the driver.
+     * Capture buffers are requeued when the user releases them, possibly
+     * from another thread.
+     */
+    atomic_int num_queued;
+
+    /**
+     * Memory type of the buffers: V4L2_MEMORY_MMAP, or V4L2_MEMORY_DMABUF
+     * when an output context imports DRM_PRIME frames.
+     */
+    enum v4l2_memory memory;
+
+    /**
+     * Hardware frames context the capture buffers belong to.
+     * Only set when the buffers are exported as AV_PIX_FMT_DRM_PRIME frames.
+     */
+    AVBufferRef *frames_ref;
+
     /**
      * Whether the stream has been started (VIDIOC_STREAMON has been sent).
      */
@@ -103,6 +130,15 @@ typedef struct V4L2Context {
  */
 int ff_v4l2_context_init(V4L2Context* ctx);
 
+/**
+ * Adds buffers to an initialized capture V4L2Context without stopping it.
+ *
+ * @param[in] ctx A pointer to a V4L2Context.
+ * @param[in] count The number of buffers to add.
+ * @return 0 in case of success, a negative value representing the error otherwise.
+ */
+int ff_v4l2_context_add_buffers(V4L2Context* ctx, int count);
+
 /**
  * Sets the V4L2Context format in the v4l2 driver.
  *
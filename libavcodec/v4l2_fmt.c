@@ -21,8 +21,13 @@
  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
  */
 
+#include "config.h"
+
 #include <linux/videodev2.h>
 #include <search.h>
+#if CONFIG_LIBDRM
+#include <drm_fourcc.h>
+#endif
 #include "v4l2_fmt.h"
 
 #define V4L2_FMT(x) V4L2_PIX_FMT_##x
@@ -139,3 +144,18 @@ enum AVPixelFormat ff_v4l2_format_v4l2_to_avfmt(uint32_t v4l2_fmt, enum AVCodecI
     }
     return AV_PIX_FMT_NONE;
 }
+
+uint32_t ff_v4l2_format_avfmt_to_drm(enum AVPixelFormat avfmt)
+{
+    switch (avfmt) {
+#if CONFIG_LIBDRM
+    case AV_PIX_FMT_NV12:    return DRM_FORMAT_NV12;
+    case AV_PIX_FMT_NV21:    return DRM_FORMAT_NV21;
+    case AV_PIX_FMT_NV16:    return DRM_FORMAT_NV16;
+    case AV_PIX_FMT_YUV420P: return DRM_FORMAT_YUV420;
+    case AV_PIX_FMT_YUV422P: return DRM_FORMAT_YUV422;
+#endif
+    default:
+        return 0;
+    }
+}
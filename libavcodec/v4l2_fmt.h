@@ -32,4 +32,10 @@ enum AVPixelFormat ff_v4l2_format_v4l2_to_avfmt(uint32_t v4l2_fmt, enum AVCodecI
 uint32_t ff_v4l2_format_avcodec_to_v4l2(enum AVCodecID avcodec);
 uint32_t ff_v4l2_format_avfmt_to_v4l2(enum AVPixelFormat avfmt);
 
+/**
+ * Returns the DRM fourcc matching a capture pixel format, or 0 if frames of
+ * this format can not be exported as AV_PIX_FMT_DRM_PRIME.
+ */
+uint32_t ff_v4l2_format_avfmt_to_drm(enum AVPixelFormat avfmt);
+
 #endif /* AVCODEC_V4L2_FMT_H*/
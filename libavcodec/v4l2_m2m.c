@@ -246,11 +246,35 @@ int ff_v4l2_m2m_codec_reinit(V4L2m2mContext *s)
     return 0;
 }
 
+int ff_v4l2_m2m_get_capture_buffer_count(V4L2m2mContext *s)
+{
+    V4L2m2mPriv *priv = s->priv;
+    struct v4l2_control ctrl = { .id = V4L2_CID_MIN_BUFFERS_FOR_CAPTURE };
+    int extra;
+
+    if (priv->num_capture_buffers)
+        return priv->num_capture_buffers;
+
+    if (ioctl(s->fd, VIDIOC_G_CTRL, &ctrl) < 0 || ctrl.value <= 0) {
+        av_log(s->avctx, AV_LOG_DEBUG, "V4L2_CID_MIN_BUFFERS_FOR_CAPTURE not available\n");
+        return V4L2_M2M_DEFAULT_CAPTURE_BUFFERS;
+    }
+
+    extra = s->avctx->extra_hw_frames >= 0 ? s->avctx->extra_hw_frames :
+                                              V4L2_M2M_DEFAULT_EXTRA_CAPTURE_BUFFERS;
+
+    av_log(s->avctx, AV_LOG_DEBUG, "capture buffers: %d required by the driver, %d extra\n",
+           ctrl.value, extra);
+
+    return ctrl.value + extra;
+}
+
 static void v4l2_m2m_destroy_context(void *opaque, uint8_t *context)
 {
     V4L2m2mContext *s = (V4L2m2mContext*)context;
 
     ff_v4l2_context_release(&s->capture);
+    av_buffer_unref(&s->device_ref);
     sem_destroy(&s->refsync);
 
     if (s->fd >= 0)
@@ -346,6 +370,8 @@ int ff_v4l2_m2m_create_context(V4L2m2mPriv *priv, V4L2m2mContext **s)
     /* populate it */
     priv->context->capture.num_buffers = priv->num_capture_buffers;
     priv->context->output.num_buffers  = priv->num_output_buffers;
+    priv->context->capture.memory = V4L2_MEMORY_MMAP;
+    priv->context->output.memory  = V4L2_MEMORY_MMAP;
     priv->context->self_ref = priv->context_ref;
     priv->context->fd = -1;
 
@@ -36,6 +36,13 @@
         const __typeof__(((type *)0)->member ) *__mptr = (ptr); \
         (type *)((char *)__mptr - offsetof(type,member) );})
 
+/* capture buffers requested when the driver does not report its minimum */
+#define V4L2_M2M_DEFAULT_CAPTURE_BUFFERS 20
+
+/* capture buffers kept for frames held downstream of the decoder when the
+ * pool is sized from the driver's minimum and extra_hw_frames is not set */
+#define V4L2_M2M_DEFAULT_EXTRA_CAPTURE_BUFFERS 4
+
 #define V4L_M2M_DEFAULT_OPTS \
     { "num_output_buffers", "Number of buffers in the output context",\
         OFFSET(num_output_buffers), AV_OPT_TYPE_INT, { .i64 = 16 }, 2, INT_MAX, FLAGS }
@@ -54,6 +61,10 @@ typedef struct V4L2m2mContext {
     atomic_uint refcount;
     int reinit;
 
+    /* export capture buffers as DRM_PRIME frames */
+    int output_drm;
+    AVBufferRef *device_ref;
+
     /* null frame/packet received */
     int draining;
     AVPacket buf_pkt;
@@ -109,6 +120,18 @@ int ff_v4l2_m2m_codec_init(V4L2m2mPriv *priv);
  */
 int ff_v4l2_m2m_codec_end(V4L2m2mPriv *priv);
 
+/**
+ * Returns the number of capture buffers to request: the user supplied
+ * num_capture_buffers if set, otherwise the minimum the driver needs to
+ * decode the stream (V4L2_CID_MIN_BUFFERS_FOR_CAPTURE) plus the frames
+ * expected to be held downstream.
+ *
+ * @param[in] ctx The V4L2m2mContext instantiated by the encoder/decoder.
+ *
+ * @returns the number of capture buffers
+ */
+int ff_v4l2_m2m_get_capture_buffer_count(V4L2m2mContext *ctx);
+
 /**
  * Reinitializes the V4L2m2mContext when the driver cannot continue processing
  * with the capture parameters.
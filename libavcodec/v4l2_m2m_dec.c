@@ -23,17 +23,97 @@
 
 #include <linux/videodev2.h>
 #include <sys/ioctl.h>
+#include "config.h"
+#include "libavutil/hwcontext.h"
+#include "libavutil/hwcontext_drm.h"
 #include "libavutil/pixfmt.h"
 #include "libavutil/pixdesc.h"
 #include "libavutil/opt.h"
 #include "libavcodec/avcodec.h"
 #include "codec_internal.h"
 #include "libavcodec/decode.h"
+#include "hwconfig.h"
 
 #include "v4l2_context.h"
 #include "v4l2_m2m.h"
 #include "v4l2_fmt.h"
 
+static int v4l2_init_drm_frames(AVCodecContext *avctx)
+{
+    V4L2m2mContext *s = ((V4L2m2mPriv*)avctx->priv_data)->context;
+    V4L2Context *const capture = &s->capture;
+    AVHWFramesContext *hwfc;
+    int ret;
+
+    if (!s->device_ref) {
+        if (avctx->hw_device_ctx) {
+            s->device_ref = av_buffer_ref(avctx->hw_device_ctx);
+            if (!s->device_ref)
+                return AVERROR(ENOMEM);
+        } else {
+            AVHWDeviceContext *hwdev;
+
+            s->device_ref = av_hwdevice_ctx_alloc(AV_HWDEVICE_TYPE_DRM);
+            if (!s->device_ref)
+                return AVERROR(ENOMEM);
+
+            /* the frames only wrap exported buffers, no DRM device is needed */
+            hwdev = (AVHWDeviceContext*)s->device_ref->data;
+            ((AVDRMDeviceContext*)hwdev->hwctx)->fd = -1;
+
+            ret = av_hwdevice_ctx_init(s->device_ref);
+            if (ret < 0)
+                return ret;
+        }
+    }
+
+    av_buffer_unref(&capture->frames_ref);
+    capture->frames_ref = av_hwframe_ctx_alloc(s->device_ref);
+    if (!capture->frames_ref)
+        return AVERROR(ENOMEM);
+
+    hwfc = (AVHWFramesContext*)capture->frames_ref->data;
+    hwfc->format    = AV_PIX_FMT_DRM_PRIME;
+    hwfc->sw_format = capture->av_pix_fmt;
+    hwfc->width     = capture->width;
+    hwfc->height    = capture->height;
+
+    return av_hwframe_ctx_init(capture->frames_ref);
+}
+
+static int v4l2_get_format(AVCodecContext *avctx)
+{
+    V4L2m2mContext *s = ((V4L2m2mPriv*)avctx->priv_data)->context;
+    V4L2Context *const capture = &s->capture;
+    enum AVPixelFormat pix_fmts[3];
+    int nb_fmts = 0, ret;
+
+    s->output_drm = 0;
+
+    if (capture->av_pix_fmt == AV_PIX_FMT_NONE) {
+        avctx->pix_fmt = AV_PIX_FMT_NONE;
+        return 0;
+    }
+
+    /* capture buffers which can be described as DRM frames may be exported */
+    if (CONFIG_LIBDRM && ff_v4l2_format_avfmt_to_drm(capture->av_pix_fmt))
+        pix_fmts[nb_fmts++] = AV_PIX_FMT_DRM_PRIME;
+    pix_fmts[nb_fmts++] = capture->av_pix_fmt;
+    pix_fmts[nb_fmts]   = AV_PIX_FMT_NONE;
+
+    ret = ff_get_format(avctx, pix_fmts);
+    if (ret < 0)
+        return AVERROR(EINVAL);
+    avctx->pix_fmt = ret;
+
+    if (avctx->pix_fmt != AV_PIX_FMT_DRM_PRIME)
+        return 0;
+
+    s->output_drm = 1;
+
+    return v4l2_init_drm_frames(avctx);
+}
+
 static int v4l2_try_start(AVCodecContext *avctx)
 {
     V4L2m2mContext *s = ((V4L2m2mPriv*)avctx->priv_data)->context;
@@ -62,9 +142,8 @@ static int v4l2_try_start(AVCodecContext *avctx)
         return ret;
     }
 
-    /* 2.1 update the AVCodecContext */
-    avctx->pix_fmt = ff_v4l2_format_v4l2_to_avfmt(capture->format.fmt.pix_mp.pixelformat, AV_CODEC_ID_RAWVIDEO);
-    capture->av_pix_fmt = avctx->pix_fmt;
+    /* 2.1 update the capture pixel format */
+    capture->av_pix_fmt = ff_v4l2_format_v4l2_to_avfmt(capture->format.fmt.pix_mp.pixelformat, AV_CODEC_ID_RAWVIDEO);
 
     /* 3. set the crop parameters */
     selection.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
@@ -83,8 +162,16 @@ static int v4l2_try_start(AVCodecContext *avctx)
         }
     }
 
+    /* 3.1 negotiate the output format with the user (software or DRM_PRIME frames) */
+    ret = v4l2_get_format(avctx);
+    if (ret) {
+        av_log(avctx, AV_LOG_ERROR, "can't negotiate the output pixel format\n");
+        return ret;
+    }
+
     /* 4. init the capture context now that we have the capture format */
     if (!capture->buffers) {
+        capture->num_buffers = ff_v4l2_m2m_get_capture_buffer_count(s);
         ret = ff_v4l2_context_init(capture);
         if (ret) {
             av_log(avctx, AV_LOG_ERROR, "can't request capture buffers\n");
@@ -225,11 +312,24 @@ static av_cold int v4l2_decode_close(AVCodecContext *avctx)
 
 static const AVOption options[] = {
     V4L_M2M_DEFAULT_OPTS,
-    { "num_capture_buffers", "Number of buffers in the capture context",
-        OFFSET(num_capture_buffers), AV_OPT_TYPE_INT, {.i64 = 20}, 2, INT_MAX, FLAGS },
+    { "num_capture_buffers", "Number of buffers in the capture context (0 to size it from the driver's requirements)",
+        OFFSET(num_capture_buffers), AV_OPT_TYPE_INT, {.i64 = 0}, 0, INT_MAX, FLAGS },
     { NULL},
 };
 
+static const AVCodecHWConfigInternal *const v4l2_m2m_hw_configs[] = {
+    &(const AVCodecHWConfigInternal) {
+        .public = {
+            .pix_fmt     = AV_PIX_FMT_DRM_PRIME,
+            .methods     = AV_CODEC_HW_CONFIG_METHOD_HW_DEVICE_CTX |
+                           AV_CODEC_HW_CONFIG_METHOD_INTERNAL,
+            .device_type = AV_HWDEVICE_TYPE_DRM
+        },
+        .hwaccel = NULL,
+    },
+    NULL
+};
+
 #define M2MDEC_CLASS(NAME) \
     static const AVClass v4l2_m2m_ ## NAME ## _dec_class = { \
         .class_name = #NAME "_v4l2m2m_decoder", \
@@ -251,6 +351,7 @@ static const AVOption options[] = {
         FF_CODEC_RECEIVE_FRAME_CB(v4l2_receive_frame), \
         .close          = v4l2_decode_close, \
         .bsfs           = bsf_name, \
+        .hw_configs     = CONFIG_LIBDRM ? v4l2_m2m_hw_configs : NULL, \
         .p.capabilities = AV_CODEC_CAP_HARDWARE | AV_CODEC_CAP_DELAY | AV_CODEC_CAP_AVOID_PROBING, \
         .caps_internal  = FF_CODEC_CAP_NOT_INIT_THREADSAFE | \
                           FF_CODEC_CAP_INIT_CLEANUP, \
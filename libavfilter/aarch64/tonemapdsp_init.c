@@ -0,0 +1,47 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "libavutil/attributes.h"
+#include "libavutil/aarch64/cpu.h"
+#include "libavfilter/tonemapdsp.h"
+
+#define DECL_TONEMAP_ROW(name) \
+void ff_tonemap_row_##name##_neon(float *dst[3], const float *src[3], \
+                                  int w, const TonemapParams *p)
+
+DECL_TONEMAP_ROW(none);
+DECL_TONEMAP_ROW(linear);
+DECL_TONEMAP_ROW(clip);
+DECL_TONEMAP_ROW(reinhard);
+DECL_TONEMAP_ROW(hable);
+DECL_TONEMAP_ROW(mobius);
+
+av_cold void ff_tonemapdsp_aarch64_init(TonemapDSPContext *dsp)
+{
+    int cpu_flags = av_get_cpu_flags();
+
+    if (!have_neon(cpu_flags))
+        return;
+
+    dsp->tonemap_row[TONEMAP_NONE]     = ff_tonemap_row_none_neon;
+    dsp->tonemap_row[TONEMAP_LINEAR]   = ff_tonemap_row_linear_neon;
+    dsp->tonemap_row[TONEMAP_CLIP]     = ff_tonemap_row_clip_neon;
+    dsp->tonemap_row[TONEMAP_REINHARD] = ff_tonemap_row_reinhard_neon;
+    dsp->tonemap_row[TONEMAP_HABLE]    = ff_tonemap_row_hable_neon;
+    dsp->tonemap_row[TONEMAP_MOBIUS]   = ff_tonemap_row_mobius_neon;
+}
@@ -0,0 +1,83 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <string.h>
+
+#include "libavutil/attributes.h"
+#include "libavutil/aarch64/cpu.h"
+#include "libavfilter/lut3d.h"
+
+#define DEFINE_INTERP_FUNC(name, fmt, type)                                                    \
+void ff_lut3d_##name##_##fmt##_neon(type *dst[3], const type *src[3], int w,                   \
+                                    const struct rgbvec *lut, int lutsize,                     \
+                                    const float scale[3], int depth);                          \
+static int interp_##name##_##fmt##_neon(AVFilterContext *ctx, void *arg,                       \
+                                        int jobnr, int nb_jobs)                                \
+{                                                                                              \
+    const LUT3DContext *lut3d = ctx->priv;                                                     \
+    const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(ctx->inputs[0]->format);              \
+    const ThreadData *td = arg;                                                                \
+    const AVFrame *in  = td->in;                                                               \
+    AVFrame *out = td->out;                                                                    \
+    const int copy_alpha = in->linesize[3] && out != in;                                       \
+    const int slice_start = (in->height *  jobnr   ) / nb_jobs;                                \
+    const int slice_end   = (in->height * (jobnr+1)) / nb_jobs;                                \
+    const float lut_max = lut3d->lutsize - 1;                                                  \
+    const float scale[3] = { lut3d->scale.r * lut_max,                                         \
+                             lut3d->scale.g * lut_max,                                         \
+                             lut3d->scale.b * lut_max };                                       \
+    int y;                                                                                     \
+                                                                                               \
+    for (y = slice_start; y < slice_end; y++) {                                                \
+        type *dst[3] = { (type *)(out->data[2] + y * out->linesize[2]),                        \
+                         (type *)(out->data[0] + y * out->linesize[0]),                        \
+                         (type *)(out->data[1] + y * out->linesize[1]) };                      \
+        const type *src[3] = { (const type *)(in->data[2] + y * in->linesize[2]),              \
+                               (const type *)(in->data[0] + y * in->linesize[0]),              \
+                               (const type *)(in->data[1] + y * in->linesize[1]) };            \
+        ff_lut3d_##name##_##fmt##_neon(dst, src, in->width, lut3d->lut, lut3d->lutsize,        \
+                                       scale, desc->comp[0].depth);                            \
+        if (copy_alpha)                                                                        \
+            memcpy(out->data[3] + y * out->linesize[3],                                        \
+                   in->data[3] + y * in->linesize[3], in->width * sizeof(type));               \
+    }                                                                                          \
+    return 0;                                                                                  \
+}
+
+DEFINE_INTERP_FUNC(tetrahedral, p8,   uint8_t)
+DEFINE_INTERP_FUNC(tetrahedral, p16,  uint16_t)
+DEFINE_INTERP_FUNC(tetrahedral, pf32, float)
+
+av_cold void ff_lut3d_init_aarch64(LUT3DContext *s, const AVPixFmtDescriptor *desc)
+{
+    int cpu_flags = av_get_cpu_flags();
+    int planar = desc->flags & AV_PIX_FMT_FLAG_PLANAR;
+    int isfloat = desc->flags & AV_PIX_FMT_FLAG_FLOAT;
+    int depth = desc->comp[0].depth;
+
+    if (!have_neon(cpu_flags) || !planar || s->prelut.size ||
+        s->interpolation != INTERPOLATE_TETRAHEDRAL)
+        return;
+
+    if (isfloat)
+        s->interp = interp_tetrahedral_pf32_neon;
+    else if (depth == 8)
+        s->interp = interp_tetrahedral_p8_neon;
+    else
+        s->interp = interp_tetrahedral_p16_neon;
+}
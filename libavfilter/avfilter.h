@@ -390,6 +390,10 @@ unsigned avfilter_filter_pad_count(const AVFilter *filter, int is_output);
  * Process multiple parts of the frame concurrently.
  */
 #define AVFILTER_THREAD_SLICE (1 << 0)
+/**
+ * Activate filters which are not linked to each other concurrently.
+ */
+#define AVFILTER_THREAD_GRAPH (1 << 1)
 
 typedef struct AVFilterInternal AVFilterInternal;
 
@@ -873,12 +877,17 @@ typedef struct AVFilterGraph {
      * of AVFILTER_THREAD_* flags.
      *
      * May be set by the caller at any point, the setting will apply to all
-     * filters initialized after that. The default is allowing everything.
+     * filters initialized after that. The default is AVFILTER_THREAD_SLICE.
      *
      * When a filter in this graph is initialized, this field is combined using
      * bit AND with AVFilterContext.thread_type to get the final mask used for
      * determining allowed threading types. I.e. a threading type needs to be
      * set in both to be allowed.
+     *
+     * AVFILTER_THREAD_GRAPH must be set before adding any filters to the
+     * filtergraph, and has no effect when a custom execute callback is used.
+     * Filters for which it is not allowed are always activated alone, as are
+     * filters that send commands to other filters, such as sendcmd and zmq.
      */
     int thread_type;
 
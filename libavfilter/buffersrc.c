@@ -173,7 +173,9 @@ static int push_frame(AVFilterGraph *graph)
     return 0;
 }
 
-int attribute_align_arg av_buffersrc_add_frame_flags(AVFilterContext *ctx, AVFrame *frame, int flags)
+static int add_frame(AVFilterContext *ctx, AVFrame *frame, int flags,
+                     int (*await_rows)(AVBufferRef *progress, int rows),
+                     AVBufferRef *progress, int row_offset)
 {
     BufferSourceContext *s = ctx->priv;
     AVFrame *copy;
@@ -266,6 +268,18 @@ FF_DISABLE_DEPRECATION_WARNINGS
 FF_ENABLE_DEPRECATION_WARNINGS
 #endif
 
+    if (await_rows) {
+        if (ctx->outputs[0]->dst->filter->flags_internal & FF_FILTER_FLAG_ROW_PROGRESS) {
+            ret = ff_frame_row_progress_attach(copy, await_rows, progress, row_offset);
+            if (ret < 0) {
+                av_frame_free(&copy);
+                return ret;
+            }
+        } else {
+            await_rows(progress, INT_MAX);
+        }
+    }
+
     ret = ff_filter_frame(ctx->outputs[0], copy);
     if (ret < 0)
         return ret;
@@ -279,6 +293,50 @@ FF_ENABLE_DEPRECATION_WARNINGS
     return 0;
 }
 
+int attribute_align_arg av_buffersrc_add_frame_flags(AVFilterContext *ctx, AVFrame *frame, int flags)
+{
+    return add_frame(ctx, frame, flags, NULL, NULL, 0);
+}
+
+int av_buffersrc_add_frame_row_progress(AVFilterContext *ctx, AVFrame *frame, int flags,
+                                        int (*await_rows)(AVBufferRef *progress, int rows),
+                                        AVBufferRef *progress)
+{
+    AVFrame *copy;
+    int row_offset, ret;
+
+    if (!frame || !frame->buf[0] || ctx->outputs[0]->type != AVMEDIA_TYPE_VIDEO ||
+        !await_rows || !progress)
+        return AVERROR(EINVAL);
+
+    copy = av_frame_alloc();
+    if (!copy)
+        return AVERROR(ENOMEM);
+    ret = av_frame_ref(copy, frame);
+    if (ret < 0)
+        goto fail;
+
+    /* drop what the library which allocated the frame may have left there */
+    av_buffer_unref(&copy->private_ref);
+
+    /* crop like the decoder does before outputting a frame */
+    row_offset = copy->crop_top;
+    ret = av_frame_apply_cropping(copy, 0);
+    if (ret < 0)
+        goto fail;
+
+    ret = add_frame(ctx, copy, flags & ~AV_BUFFERSRC_FLAG_KEEP_REF,
+                    await_rows, progress, row_offset);
+    if (ret < 0)
+        goto fail;
+
+    if (!(flags & AV_BUFFERSRC_FLAG_KEEP_REF))
+        av_frame_unref(frame);
+fail:
+    av_frame_free(&copy);
+    return ret;
+}
+
 int av_buffersrc_close(AVFilterContext *ctx, int64_t pts, unsigned flags)
 {
     BufferSourceContext *s = ctx->priv;
@@ -202,6 +202,41 @@ av_warn_unused_result
 int av_buffersrc_add_frame_flags(AVFilterContext *buffer_src,
                                  AVFrame *frame, int flags);
 
+/**
+ * Add a video frame whose rows may still be being written to the buffer
+ * source, e.g. a frame obtained from draw_horiz_band() with
+ * AV_CODEC_EXPORT_DATA_ROW_PROGRESS, together with its progress.
+ *
+ * Filters able to process such frames partially, such as scale, wait for
+ * the rows they need; for other filters, this function waits for the
+ * complete frame. Either way, the frame must not be added from the thread
+ * writing it.
+ *
+ * The frame is cropped according to its crop_* fields, as decoders do for
+ * the frames they output, while await_rows() counts rows of the uncropped
+ * frame.
+ *
+ * Otherwise, this function behaves like av_buffersrc_add_frame_flags().
+ *
+ * @param buffer_src  pointer to a buffer source context
+ * @param frame       a reference counted video frame
+ * @param flags       a combination of AV_BUFFERSRC_FLAG_*
+ * @param await_rows  callback waiting until at least the first rows rows of
+ *                    the frame are written and returning the number of rows
+ *                    written so far, e.g. avcodec_row_progress_await(); it is
+ *                    called from the filtering threads
+ * @param progress    opaque progress passed to await_rows(), e.g. obtained
+ *                    from avcodec_get_row_progress(); the filter graph takes
+ *                    its own reference to it
+ * @return            >= 0 in case of success, a negative AVERROR code
+ *                    in case of failure
+ */
+av_warn_unused_result
+int av_buffersrc_add_frame_row_progress(AVFilterContext *buffer_src,
+                                        AVFrame *frame, int flags,
+                                        int (*await_rows)(AVBufferRef *progress, int rows),
+                                        AVBufferRef *progress);
+
 /**
  * Close the buffer source after EOF.
  *
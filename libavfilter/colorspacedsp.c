@@ -145,5 +145,7 @@ void ff_colorspacedsp_init(ColorSpaceDSPContext *dsp)
 
 #if ARCH_X86
     ff_colorspacedsp_x86_init(dsp);
+#elif ARCH_AARCH64
+    ff_colorspacedsp_aarch64_init(dsp);
 #endif
 }
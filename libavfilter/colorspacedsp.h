@@ -79,5 +79,6 @@ void ff_colorspacedsp_init(ColorSpaceDSPContext *dsp);
 
 /* internal */
 void ff_colorspacedsp_x86_init(ColorSpaceDSPContext *dsp);
+void ff_colorspacedsp_aarch64_init(ColorSpaceDSPContext *dsp);
 
 #endif /* AVFILTER_COLORSPACEDSP_H */
@@ -589,6 +589,7 @@ const AVFilter ff_vf_graphmonitor = {
     .description   = NULL_IF_CONFIG_SMALL("Show various filtergraph stats."),
     .priv_size     = sizeof(GraphMonitorContext),
     .priv_class    = &graphmonitor_class,
+    .flags_internal = FF_FILTER_FLAG_ACTIVATE_ALONE,
     .init          = init,
     .uninit        = uninit,
     .activate      = activate,
@@ -622,6 +623,7 @@ const AVFilter ff_avf_agraphmonitor = {
     .description   = NULL_IF_CONFIG_SMALL("Show various filtergraph stats."),
     .priv_class    = &graphmonitor_class,
     .priv_size     = sizeof(GraphMonitorContext),
+    .flags_internal = FF_FILTER_FLAG_ACTIVATE_ALONE,
     .init          = init,
     .uninit        = uninit,
     .activate      = activate,
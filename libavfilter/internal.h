@@ -133,6 +133,8 @@ struct AVFilterGraphInternal {
     void *thread;
     avfilter_execute_func *thread_execute;
     FFFrameQueueGlobal frame_queues;
+    /* set when filters may be activated concurrently, see AVFILTER_THREAD_GRAPH */
+    void *graph_thread;
 };
 
 struct AVFilterInternal {
@@ -373,6 +375,22 @@ void ff_filter_graph_remove_filter(AVFilterGraph *graph, AVFilterContext *filter
  */
 #define FF_FILTER_FLAG_HWFRAME_AWARE (1 << 0)
 
+/**
+ * The filter accepts video frames added with
+ * av_buffersrc_add_frame_row_progress(), whose rows may still be being
+ * written, and waits for the rows it reads with ff_frame_row_progress_await().
+ * It must not output such frames. Frames sent by buffersrc to other filters
+ * are completed first.
+ */
+#define FF_FILTER_FLAG_ROW_PROGRESS (1 << 1)
+
+/**
+ * The filter reaches into other filters of its graph while it runs, e.g.
+ * by sending them commands or reading their links, and must never be activated concurrently with
+ * other filters, see AVFILTER_THREAD_GRAPH.
+ */
+#define FF_FILTER_FLAG_ACTIVATE_ALONE (1 << 2)
+
 /**
  * Run one round of processing on a filter graph.
  */
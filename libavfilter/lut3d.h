@@ -82,6 +82,11 @@ typedef struct ThreadData {
     AVFrame *in, *out;
 } ThreadData;
 
+/**
+ * Set lut3d->interp for the input format, interpolation mode and pre-LUT.
+ */
+void ff_lut3d_init(LUT3DContext *lut3d, const AVPixFmtDescriptor *desc);
 void ff_lut3d_init_x86(LUT3DContext *s, const AVPixFmtDescriptor *desc);
+void ff_lut3d_init_aarch64(LUT3DContext *s, const AVPixFmtDescriptor *desc);
 
 #endif /* AVFILTER_LUT3D_H */
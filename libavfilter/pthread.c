@@ -27,6 +27,7 @@
 #include "libavutil/macros.h"
 #include "libavutil/mem.h"
 #include "libavutil/slicethread.h"
+#include "libavutil/thread.h"
 
 #include "avfilter.h"
 #include "internal.h"
@@ -41,8 +42,24 @@ typedef struct ThreadContext {
     AVFilterContext *ctx;
     void *arg;
     int   *rets;
+
+    /* held while the slice threads are in use, when several filters
+     * may be executing at once */
+    pthread_mutex_t execute_lock;
 } ThreadContext;
 
+typedef struct GraphThreadContext {
+    AVSliceThread *thread;
+
+    /* protects the state shared between concurrently activated filters:
+     * AVFilterContext.ready, frame_blocked_in and the sink links heap */
+    pthread_mutex_t lock;
+
+    AVFilterContext **filters;
+    int              *rets;
+    int               max_filters;
+} GraphThreadContext;
+
 static void worker_func(void *priv, int jobnr, int threadnr, int nb_jobs, int nb_threads)
 {
     ThreadContext *c = priv;
@@ -54,6 +71,18 @@ static void worker_func(void *priv, int jobnr, int threadnr, int nb_jobs, int nb
 static void slice_thread_uninit(ThreadContext *c)
 {
     avpriv_slicethread_free(&c->thread);
+    pthread_mutex_destroy(&c->execute_lock);
+}
+
+static int run_jobs_inline(AVFilterContext *ctx, avfilter_action_func *func,
+                           void *arg, int *ret, int nb_jobs)
+{
+    for (int i = 0; i < nb_jobs; i++) {
+        int r = func(ctx, arg, i, nb_jobs);
+        if (ret)
+            ret[i] = r;
+    }
+    return 0;
 }
 
 static int thread_execute(AVFilterContext *ctx, avfilter_action_func *func,
@@ -63,20 +92,144 @@ static int thread_execute(AVFilterContext *ctx, avfilter_action_func *func,
 
     if (nb_jobs <= 0)
         return 0;
+
+    /* The slice threads can only serve one filter at a time; the other
+     * filters activated concurrently run their jobs on their own thread. */
+    if (ctx->graph->internal->graph_thread &&
+        pthread_mutex_trylock(&c->execute_lock))
+        return run_jobs_inline(ctx, func, arg, ret, nb_jobs);
+
     c->ctx         = ctx;
     c->arg         = arg;
     c->func        = func;
     c->rets        = ret;
 
     avpriv_slicethread_execute(c->thread, nb_jobs, 0);
+
+    if (ctx->graph->internal->graph_thread)
+        pthread_mutex_unlock(&c->execute_lock);
+    return 0;
+}
+
+static void graph_worker_func(void *priv, int jobnr, int threadnr, int nb_jobs, int nb_threads)
+{
+    GraphThreadContext *c = priv;
+    c->rets[jobnr] = ff_filter_activate(c->filters[jobnr]);
+}
+
+static void graph_thread_free(GraphThreadContext **pc)
+{
+    GraphThreadContext *c = *pc;
+
+    if (!c)
+        return;
+    avpriv_slicethread_free(&c->thread);
+    pthread_mutex_destroy(&c->lock);
+    av_freep(&c->filters);
+    av_freep(&c->rets);
+    av_freep(pc);
+}
+
+static int graph_thread_init(AVFilterGraph *graph)
+{
+    GraphThreadContext *c;
+    int ret;
+
+    c = av_mallocz(sizeof(*c));
+    if (!c)
+        return AVERROR(ENOMEM);
+    ret = pthread_mutex_init(&c->lock, NULL);
+    if (ret) {
+        av_free(c);
+        return AVERROR(ret);
+    }
+
+    ret = avpriv_slicethread_create(&c->thread, c, graph_worker_func, NULL,
+                                    graph->nb_threads);
+    if (ret < 0)
+        goto fail;
+    c->max_filters = ret;
+    c->filters     = av_calloc(c->max_filters, sizeof(*c->filters));
+    c->rets        = av_calloc(c->max_filters, sizeof(*c->rets));
+    if (!c->filters || !c->rets) {
+        ret = AVERROR(ENOMEM);
+        goto fail;
+    }
+
+    graph->internal->graph_thread = c;
+    return 0;
+fail:
+    graph_thread_free(&c);
+    return ret;
+}
+
+static int filters_adjacent(const AVFilterContext *a, const AVFilterContext *b)
+{
+    for (unsigned i = 0; i < a->nb_inputs; i++)
+        if (a->inputs[i] && a->inputs[i]->src == b)
+            return 1;
+    for (unsigned i = 0; i < a->nb_outputs; i++)
+        if (a->outputs[i] && a->outputs[i]->dst == b)
+            return 1;
+    return 0;
+}
+
+int ff_graph_activate_concurrently(AVFilterGraph *graph, AVFilterContext *first)
+{
+    GraphThreadContext *c = graph->internal->graph_thread;
+    int nb_filters = 1;
+
+    /* Filters which share no link only touch each other's state through
+     * the fields protected by c->lock, so they can be activated at once. */
+    c->filters[0] = first;
+    for (unsigned i = 0; i < graph->nb_filters && nb_filters < c->max_filters; i++) {
+        AVFilterContext *filter = graph->filters[i];
+        int j;
+
+        if (!filter->ready || filter == first ||
+            !(filter->thread_type & AVFILTER_THREAD_GRAPH))
+            continue;
+        for (j = 0; j < nb_filters; j++)
+            if (filters_adjacent(filter, c->filters[j]))
+                break;
+        if (j == nb_filters)
+            c->filters[nb_filters++] = filter;
+    }
+
+    if (nb_filters == 1)
+        return ff_filter_activate(first);
+
+    avpriv_slicethread_execute(c->thread, nb_filters, 0);
+
+    for (int i = 0; i < nb_filters; i++)
+        if (c->rets[i] < 0)
+            return c->rets[i];
     return 0;
 }
 
+void ff_graph_lock(AVFilterGraph *graph)
+{
+    if (graph && graph->internal->graph_thread)
+        pthread_mutex_lock(&((GraphThreadContext *)graph->internal->graph_thread)->lock);
+}
+
+void ff_graph_unlock(AVFilterGraph *graph)
+{
+    if (graph && graph->internal->graph_thread)
+        pthread_mutex_unlock(&((GraphThreadContext *)graph->internal->graph_thread)->lock);
+}
+
 static int thread_init_internal(ThreadContext *c, int nb_threads)
 {
+    int ret = pthread_mutex_init(&c->execute_lock, NULL);
+    if (ret)
+        return AVERROR(ret);
+
     nb_threads = avpriv_slicethread_create(&c->thread, c, worker_func, NULL, nb_threads);
-    if (nb_threads <= 1)
+    if (nb_threads <= 1) {
         avpriv_slicethread_free(&c->thread);
+        pthread_mutex_destroy(&c->execute_lock);
+    }
     return FFMAX(nb_threads, 1);
 }
 
@@ -104,11 +257,18 @@ int ff_graph_thread_init(AVFilterGraph *graph)
 
     graph->internal->thread_execute = thread_execute;
 
+    if (graph->thread_type & AVFILTER_THREAD_GRAPH) {
+        ret = graph_thread_init(graph);
+        if (ret < 0)
+            return ret;
+    }
+
     return 0;
 }
 
 void ff_graph_thread_free(AVFilterGraph *graph)
 {
+    graph_thread_free((GraphThreadContext **)&graph->internal->graph_thread);
     if (graph->internal->thread)
         slice_thread_uninit(graph->internal->thread);
     av_freep(&graph->internal->thread);
@@ -110,7 +110,7 @@ fail:
     return ret;
 }
 
-int ff_scale_adjust_dimensions(AVFilterLink *inlink,
+int ff_scale_adjust_dimensions_wh(int in_w, int in_h,
     int *ret_w, int *ret_h,
     int force_original_aspect_ratio, int force_divisible_by)
 {
@@ -132,26 +132,26 @@ int ff_scale_adjust_dimensions(AVFilterLink *inlink,
     }
 
     if (w < 0 && h < 0) {
-        w = inlink->w;
-        h = inlink->h;
+        w = in_w;
+        h = in_h;
     }
 
     /* Make sure that the result is divisible by the factor we determined
      * earlier. If no factor was set, nothing will happen as the default
      * factor is 1 */
     if (w < 0)
-        w = av_rescale(h, inlink->w, inlink->h * factor_w) * factor_w;
+        w = av_rescale(h, in_w, in_h * factor_w) * factor_w;
     if (h < 0)
-        h = av_rescale(w, inlink->h, inlink->w * factor_h) * factor_h;
+        h = av_rescale(w, in_h, in_w * factor_h) * factor_h;
 
     /* Note that force_original_aspect_ratio may overwrite the previous set
      * dimensions so that it is not divisible by the set factors anymore
      * unless force_divisible_by is defined as well */
     if (force_original_aspect_ratio) {
         // Including force_divisible_by here rounds to the nearest multiple of it.
-        int tmp_w = av_rescale(h, inlink->w, inlink->h * (int64_t)force_divisible_by)
+        int tmp_w = av_rescale(h, in_w, in_h * (int64_t)force_divisible_by)
                     * force_divisible_by;
-        int tmp_h = av_rescale(w, inlink->h, inlink->w * (int64_t)force_divisible_by)
+        int tmp_h = av_rescale(w, in_h, in_w * (int64_t)force_divisible_by)
                     * force_divisible_by;
 
         if (force_original_aspect_ratio == 1) {
@@ -178,3 +178,12 @@ int ff_scale_adjust_dimensions(AVFilterLink *inlink,
 
     return 0;
 }
+
+int ff_scale_adjust_dimensions(AVFilterLink *inlink,
+    int *ret_w, int *ret_h,
+    int force_original_aspect_ratio, int force_divisible_by)
+{
+    return ff_scale_adjust_dimensions_wh(inlink->w, inlink->h, ret_w, ret_h,
+                                         force_original_aspect_ratio,
+                                         force_divisible_by);
+}
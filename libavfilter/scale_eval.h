@@ -46,4 +46,12 @@ int ff_scale_eval_dimensions(void *ctx,
 int ff_scale_adjust_dimensions(AVFilterLink *inlink,
     int *ret_w, int *ret_h,
     int force_original_aspect_ratio, int force_divisible_by);
+
+/**
+ * Same as ff_scale_adjust_dimensions(), with the input dimensions given
+ * explicitly, e.g. those of a source rectangle smaller than the input.
+ */
+int ff_scale_adjust_dimensions_wh(int in_w, int in_h,
+    int *ret_w, int *ret_h,
+    int force_original_aspect_ratio, int force_divisible_by);
 #endif
@@ -39,6 +39,8 @@ void ff_scene_sad16_c(SCENE_SAD_PARAMS);
 
 ff_scene_sad_fn ff_scene_sad_get_fn_x86(int depth);
 
+ff_scene_sad_fn ff_scene_sad_get_fn_aarch64(int depth);
+
 ff_scene_sad_fn ff_scene_sad_get_fn(int depth);
 
 #endif /* AVFILTER_SCENE_SAD_H */
@@ -25,4 +25,20 @@ int ff_graph_thread_init(AVFilterGraph *graph);
 
 void ff_graph_thread_free(AVFilterGraph *graph);
 
+/**
+ * Activate first together with as many other ready filters as there are
+ * threads, provided none of them are linked to each other, and wait for
+ * all of them to return.
+ *
+ * @return the first error returned by one of the filters, or 0
+ */
+int ff_graph_activate_concurrently(AVFilterGraph *graph, AVFilterContext *first);
+
+/**
+ * Lock/unlock the state that filters activated concurrently may share.
+ * No-op unless AVFILTER_THREAD_GRAPH is in use.
+ */
+void ff_graph_lock(AVFilterGraph *graph);
+void ff_graph_unlock(AVFilterGraph *graph);
+
 #endif /* AVFILTER_THREAD_H */
@@ -0,0 +1,158 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <math.h>
+
+#include "config.h"
+#include "libavutil/attributes.h"
+#include "libavutil/common.h"
+#include "tonemapdsp.h"
+
+static float hable(float in)
+{
+    float a = 0.15f, b = 0.50f, c = 0.10f, d = 0.20f, e = 0.02f, f = 0.30f;
+    return (in * (in * a + b * c) + d * e) / (in * (in * a + b) + d * f) - e / f;
+}
+
+void ff_tonemap_init_params(TonemapParams *p, enum TonemapAlgorithm algo,
+                            float param, float peak, float desat,
+                            const float coeffs[3])
+{
+    float j = param;
+
+    p->coeffs[0] = coeffs[0];
+    p->coeffs[1] = coeffs[1];
+    p->coeffs[2] = coeffs[2];
+    p->desat     = desat;
+    p->param     = param;
+    p->peak      = peak;
+    p->scale     = 1.0f;
+    p->a = p->b  = 0.0f;
+
+    switch (algo) {
+    case TONEMAP_LINEAR:
+        p->scale = param / peak;
+        break;
+    case TONEMAP_GAMMA:
+        /* exponent, and slope of the linear segment below 0.05 */
+        p->scale = 1.0f / param;
+        p->a     = powf(0.05f / peak, p->scale) / 0.05f;
+        break;
+    case TONEMAP_CLIP:
+        p->scale = param;
+        break;
+    case TONEMAP_REINHARD:
+        p->scale = (peak + param) / peak;
+        break;
+    case TONEMAP_HABLE:
+        p->scale = 1.0f / hable(peak);
+        break;
+    case TONEMAP_MOBIUS:
+        p->a     = -j * j * (peak - 1.0f) / (j * j - 2.0f * j + peak);
+        p->b     = (j * j - 2.0f * j * peak + peak) / FFMAX(peak - 1.0f, 1e-6f);
+        p->scale = (p->b * p->b + 2.0f * p->b * j + j * j) / (p->b - p->a);
+        break;
+    }
+}
+
+#define MIX(x,y,a) (x) * (1 - (a)) + (y) * (a)
+static av_always_inline void tonemap_row(float *dst[3], const float *src[3],
+                                         int w, const TonemapParams *p,
+                                         enum TonemapAlgorithm algo)
+{
+    for (int x = 0; x < w; x++) {
+        float r = src[0][x], g = src[1][x], b = src[2][x];
+        float sig, ratio;
+
+        /* desaturate to prevent unnatural colors */
+        if (p->desat > 0) {
+            float luma = p->coeffs[0] * r + p->coeffs[1] * g + p->coeffs[2] * b;
+            float overbright = FFMAX(luma - p->desat, 1e-6f) / FFMAX(luma, 1e-6f);
+            r = MIX(r, luma, overbright);
+            g = MIX(g, luma, overbright);
+            b = MIX(b, luma, overbright);
+        }
+
+        /* pick the brightest component, reducing the value range as necessary
+         * to keep the entire signal in range and preventing discoloration due to
+         * out-of-bounds clipping */
+        sig = FFMAX(FFMAX3(r, g, b), 1e-6f);
+
+        /* ratio between the mapped and the original signal, applied
+         * linearly to the color to prevent discoloration */
+        switch (algo) {
+        default:
+        case TONEMAP_NONE:
+            ratio = 1.0f;
+            break;
+        case TONEMAP_LINEAR:
+            ratio = p->scale;
+            break;
+        case TONEMAP_GAMMA:
+            ratio = sig > 0.05f ? powf(sig / p->peak, p->scale) / sig : p->a;
+            break;
+        case TONEMAP_CLIP:
+            ratio = av_clipf(sig * p->scale, 0, 1.0f) / sig;
+            break;
+        case TONEMAP_REINHARD:
+            ratio = p->scale / (sig + p->param);
+            break;
+        case TONEMAP_HABLE:
+            ratio = hable(sig) * p->scale / sig;
+            break;
+        case TONEMAP_MOBIUS:
+            ratio = sig <= p->param ? 1.0f :
+                    p->scale * (sig + p->a) / (sig + p->b) / sig;
+            break;
+        }
+
+        dst[0][x] = r * ratio;
+        dst[1][x] = g * ratio;
+        dst[2][x] = b * ratio;
+    }
+}
+
+#define DEFINE_TONEMAP_ROW(name, algo)                                      \
+static void tonemap_row_##name##_c(float *dst[3], const float *src[3],     \
+                                   int w, const TonemapParams *p)          \
+{                                                                           \
+    tonemap_row(dst, src, w, p, algo);                                      \
+}
+
+DEFINE_TONEMAP_ROW(none,     TONEMAP_NONE)
+DEFINE_TONEMAP_ROW(linear,   TONEMAP_LINEAR)
+DEFINE_TONEMAP_ROW(gamma,    TONEMAP_GAMMA)
+DEFINE_TONEMAP_ROW(clip,     TONEMAP_CLIP)
+DEFINE_TONEMAP_ROW(reinhard, TONEMAP_REINHARD)
+DEFINE_TONEMAP_ROW(hable,    TONEMAP_HABLE)
+DEFINE_TONEMAP_ROW(mobius,   TONEMAP_MOBIUS)
+
+av_cold void ff_tonemapdsp_init(TonemapDSPContext *dsp)
+{
+    dsp->tonemap_row[TONEMAP_NONE]     = tonemap_row_none_c;
+    dsp->tonemap_row[TONEMAP_LINEAR]   = tonemap_row_linear_c;
+    dsp->tonemap_row[TONEMAP_GAMMA]    = tonemap_row_gamma_c;
+    dsp->tonemap_row[TONEMAP_CLIP]     = tonemap_row_clip_c;
+    dsp->tonemap_row[TONEMAP_REINHARD] = tonemap_row_reinhard_c;
+    dsp->tonemap_row[TONEMAP_HABLE]    = tonemap_row_hable_c;
+    dsp->tonemap_row[TONEMAP_MOBIUS]   = tonemap_row_mobius_c;
+
+#if ARCH_AARCH64
+    ff_tonemapdsp_aarch64_init(dsp);
+#endif
+}
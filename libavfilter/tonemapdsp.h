@@ -0,0 +1,60 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef AVFILTER_TONEMAPDSP_H
+#define AVFILTER_TONEMAPDSP_H
+
+enum TonemapAlgorithm {
+    TONEMAP_NONE,
+    TONEMAP_LINEAR,
+    TONEMAP_GAMMA,
+    TONEMAP_CLIP,
+    TONEMAP_REINHARD,
+    TONEMAP_HABLE,
+    TONEMAP_MOBIUS,
+    TONEMAP_MAX,
+};
+
+/* Per-frame parameters of a tonemap_row function. The layout is relied
+ * upon by the assembly versions. */
+typedef struct TonemapParams {
+    float coeffs[3];    ///< luma coefficients of r, g and b
+    float desat;        ///< desaturation strength, 0 to disable desaturation
+    float param;        ///< algorithm parameter
+    float peak;         ///< signal peak
+    float scale;        ///< algorithm dependent scale, see ff_tonemap_init_params()
+    float a, b;         ///< algorithm dependent constants
+} TonemapParams;
+
+typedef struct TonemapDSPContext {
+    /* Tonemap a line of w float pixels; the planes are in r, g, b order and
+     * dst may be equal to src. */
+    void (*tonemap_row[TONEMAP_MAX])(float *dst[3], const float *src[3],
+                                     int w, const TonemapParams *p);
+} TonemapDSPContext;
+
+void ff_tonemap_init_params(TonemapParams *p, enum TonemapAlgorithm algo,
+                            float param, float peak, float desat,
+                            const float coeffs[3]);
+
+void ff_tonemapdsp_init(TonemapDSPContext *dsp);
+
+/* internal */
+void ff_tonemapdsp_aarch64_init(TonemapDSPContext *dsp);
+
+#endif /* AVFILTER_TONEMAPDSP_H */
@@ -45,6 +45,8 @@ typedef struct TransVtable {
                             int w, int h);
 } TransVtable;
 
+void ff_transpose_init(TransVtable *v, int pixstep);
 void ff_transpose_init_x86(TransVtable *v, int pixstep);
+void ff_transpose_init_aarch64(TransVtable *v, int pixstep);
 
 #endif
@@ -611,7 +611,8 @@ static int allocate_3dlut(AVFilterContext *ctx, int lutsize, int prelut)
     }
 
     av_freep(&lut3d->lut);
-    lut3d->lut = av_malloc_array(lutsize * lutsize * lutsize, sizeof(*lut3d->lut));
+    /* one spare entry for the SIMD versions, which load 16 bytes per entry */
+    lut3d->lut = av_malloc_array(lutsize * lutsize * lutsize + 1, sizeof(*lut3d->lut));
     if (!lut3d->lut)
         return AVERROR(ENOMEM);
 
@@ -1110,18 +1111,12 @@ static const enum AVPixelFormat pix_fmts[] = {
     AV_PIX_FMT_NONE
 };
 
-static int config_input(AVFilterLink *inlink)
+av_cold void ff_lut3d_init(LUT3DContext *lut3d, const AVPixFmtDescriptor *desc)
 {
-    int depth, is16bit, isfloat, planar;
-    LUT3DContext *lut3d = inlink->dst->priv;
-    const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(inlink->format);
-
-    depth = desc->comp[0].depth;
-    is16bit = desc->comp[0].depth > 8;
-    planar = desc->flags & AV_PIX_FMT_FLAG_PLANAR;
-    isfloat = desc->flags & AV_PIX_FMT_FLAG_FLOAT;
-    ff_fill_rgba_map(lut3d->rgba_map, inlink->format);
-    lut3d->step = av_get_padded_bits_per_pixel(desc) >> (3 + is16bit);
+    const int depth = desc->comp[0].depth;
+    const int is16bit = desc->comp[0].depth > 8;
+    const int planar = desc->flags & AV_PIX_FMT_FLAG_PLANAR;
+    const int isfloat = desc->flags & AV_PIX_FMT_FLAG_FLOAT;
 
 #define SET_FUNC(name) do {                                     \
     if (planar && !isfloat) {                                   \
@@ -1150,7 +1145,19 @@ static int config_input(AVFilterLink *inlink)
 
 #if ARCH_X86
     ff_lut3d_init_x86(lut3d, desc);
+#elif ARCH_AARCH64
+    ff_lut3d_init_aarch64(lut3d, desc);
 #endif
+}
+
+static int config_input(AVFilterLink *inlink)
+{
+    LUT3DContext *lut3d = inlink->dst->priv;
+    const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(inlink->format);
+
+    ff_fill_rgba_map(lut3d->rgba_map, inlink->format);
+    lut3d->step = av_get_padded_bits_per_pixel(desc) >> (3 + (desc->comp[0].depth > 8));
+    ff_lut3d_init(lut3d, desc);
 
     return 0;
 }
@@ -0,0 +1,592 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file
+ * scale the input to several sizes at once
+ *
+ * Each output is scaled from the smallest larger output of the same pixel
+ * format, or from the input if there is none. The input is then only read
+ * by the largest renditions, and the smaller ones are scaled down from much
+ * smaller pictures than the input.
+ *
+ * The scalers are single-threaded. Every output is instead cut into
+ * horizontal slices, each with a scaler of its own, which run as jobs of
+ * the filtergraph threads, so all outputs share one thread pool.
+ */
+
+#include <stdio.h>
+
+#include "libavutil/avstring.h"
+#include "libavutil/imgutils.h"
+#include "libavutil/internal.h"
+#include "libavutil/mem.h"
+#include "libavutil/opt.h"
+#include "libavutil/parseutils.h"
+#include "libavutil/pixdesc.h"
+#include "libswscale/swscale.h"
+
+#include "avfilter.h"
+#include "filters.h"
+#include "formats.h"
+#include "internal.h"
+#include "scale_eval.h"
+#include "video.h"
+
+typedef struct MultiScaleOutput {
+    int w, h;                   ///< requested size, negative to keep the aspect ratio
+    int src;                    ///< output this one is scaled from, -1 for the input
+    int needed;                 ///< output or the source of one that is still open
+    int full_range;             ///< whether the output is scaled to full range
+    struct SwsContext **sws;    ///< one scaler per slice
+    int *slice_ret;
+    int nb_slices;
+    AVFrame *frame;
+} MultiScaleOutput;
+
+typedef struct ThreadData {
+    const MultiScaleOutput *o;
+    const AVFrame *in;
+    AVFrame *out;
+} ThreadData;
+
+typedef struct MultiScaleContext {
+    const AVClass *class;
+
+    char *sizes_str;
+    char *flags_str;
+    int cascade;
+
+    int nb_outputs;
+    MultiScaleOutput *outputs;
+    int *order;                 ///< output indices by decreasing area
+
+    /* input the scalers are configured for */
+    int src_w, src_h;
+    int src_format;
+} MultiScaleContext;
+
+static int parse_size(void *log_ctx, const char *str, int *w, int *h)
+{
+    char c;
+
+    if (sscanf(str, "%dx%d%c", w, h, &c) == 2)
+        return 0;
+    if (av_parse_video_size(w, h, str) >= 0)
+        return 0;
+
+    av_log(log_ctx, AV_LOG_ERROR, "Invalid size '%s'\n", str);
+    return AVERROR(EINVAL);
+}
+
+static int config_output(AVFilterLink *outlink)
+{
+    AVFilterContext *ctx = outlink->src;
+    MultiScaleContext *s = ctx->priv;
+    AVFilterLink *inlink = ctx->inputs[0];
+    const MultiScaleOutput *o = &s->outputs[FF_OUTLINK_IDX(outlink)];
+    int w = o->w ? o->w : inlink->w;
+    int h = o->h ? o->h : inlink->h;
+    int ret;
+
+    ret = ff_scale_adjust_dimensions(inlink, &w, &h, 0, 1);
+    if (ret < 0)
+        return ret;
+    if (w <= 0 || h <= 0 || av_image_check_size(w, h, 0, ctx) < 0) {
+        av_log(ctx, AV_LOG_ERROR, "Invalid output size %dx%d\n", w, h);
+        return AVERROR(EINVAL);
+    }
+
+    outlink->w = w;
+    outlink->h = h;
+    if (inlink->sample_aspect_ratio.num)
+        outlink->sample_aspect_ratio = av_mul_q((AVRational){ h * inlink->w, w * inlink->h },
+                                                inlink->sample_aspect_ratio);
+    else
+        outlink->sample_aspect_ratio = inlink->sample_aspect_ratio;
+
+    /* the scalers are set up with the first frame, once all outputs are
+     * configured */
+    s->src_format = AV_PIX_FMT_NONE;
+
+    return 0;
+}
+
+static av_cold int init(AVFilterContext *ctx)
+{
+    MultiScaleContext *s = ctx->priv;
+    char *sizes, *size, *saveptr = NULL;
+    int ret = 0;
+
+    if (!s->sizes_str) {
+        av_log(ctx, AV_LOG_ERROR, "No output sizes given.\n");
+        return AVERROR(EINVAL);
+    }
+
+    s->nb_outputs = 1;
+    for (const char *p = s->sizes_str; *p; p++)
+        s->nb_outputs += *p == '|';
+
+    s->outputs = av_calloc(s->nb_outputs, sizeof(*s->outputs));
+    s->order   = av_calloc(s->nb_outputs, sizeof(*s->order));
+    sizes      = av_strdup(s->sizes_str);
+    if (!s->outputs || !s->order || !sizes) {
+        av_free(sizes);
+        return AVERROR(ENOMEM);
+    }
+
+    size = av_strtok(sizes, "|", &saveptr);
+    for (int i = 0; i < s->nb_outputs; i++) {
+        AVFilterPad pad = { 0 };
+
+        if (!size) {
+            av_log(ctx, AV_LOG_ERROR, "Empty size in '%s'\n", s->sizes_str);
+            ret = AVERROR(EINVAL);
+            break;
+        }
+        if ((ret = parse_size(ctx, size, &s->outputs[i].w, &s->outputs[i].h)) < 0)
+            break;
+        size = av_strtok(NULL, "|", &saveptr);
+
+        pad.type         = AVMEDIA_TYPE_VIDEO;
+        pad.config_props = config_output;
+        pad.name         = av_asprintf("output%d", i);
+        if (!pad.name) {
+            ret = AVERROR(ENOMEM);
+            break;
+        }
+        if ((ret = ff_append_outpad_free_name(ctx, &pad)) < 0)
+            break;
+    }
+    av_free(sizes);
+
+    s->src_format = AV_PIX_FMT_NONE;
+
+    return ret;
+}
+
+static void free_scalers(MultiScaleOutput *o)
+{
+    for (int j = 0; j < o->nb_slices; j++)
+        sws_freeContext(o->sws[j]);
+    av_freep(&o->sws);
+    av_freep(&o->slice_ret);
+    o->nb_slices = 0;
+}
+
+static av_cold void uninit(AVFilterContext *ctx)
+{
+    MultiScaleContext *s = ctx->priv;
+
+    for (int i = 0; i < s->nb_outputs && s->outputs; i++) {
+        free_scalers(&s->outputs[i]);
+        av_frame_free(&s->outputs[i].frame);
+    }
+    av_freep(&s->outputs);
+    av_freep(&s->order);
+}
+
+static int query_formats(AVFilterContext *ctx)
+{
+    AVFilterFormats *formats = NULL;
+    const AVPixFmtDescriptor *desc = NULL;
+    int ret;
+
+    while ((desc = av_pix_fmt_desc_next(desc))) {
+        enum AVPixelFormat pix_fmt = av_pix_fmt_desc_get_id(desc);
+        if ((sws_isSupportedInput(pix_fmt) ||
+             sws_isSupportedEndiannessConversion(pix_fmt)) &&
+            (ret = ff_add_format(&formats, pix_fmt)) < 0)
+            return ret;
+    }
+    if ((ret = ff_formats_ref(formats, &ctx->inputs[0]->outcfg.formats)) < 0)
+        return ret;
+
+    /* a separate list for every output, so that they are negotiated
+     * independently */
+    for (int i = 0; i < ctx->nb_outputs; i++) {
+        formats = NULL;
+        desc    = NULL;
+        while ((desc = av_pix_fmt_desc_next(desc))) {
+            enum AVPixelFormat pix_fmt = av_pix_fmt_desc_get_id(desc);
+            if ((sws_isSupportedOutput(pix_fmt) ||
+                 sws_isSupportedEndiannessConversion(pix_fmt)) &&
+                (ret = ff_add_format(&formats, pix_fmt)) < 0)
+                return ret;
+        }
+        if ((ret = ff_formats_ref(formats, &ctx->outputs[i]->incfg.formats)) < 0)
+            return ret;
+    }
+
+    return 0;
+}
+
+static int uses_error_diffusion(struct SwsContext *sws)
+{
+    const AVOption *opt = av_opt_find(sws, "sws_dither", NULL, 0, 0);
+    int64_t dither;
+    int ed;
+
+    return opt && av_opt_get_int(sws, "sws_dither", 0, &dither) >= 0 &&
+           av_opt_eval_int(sws, opt, "ed", &ed) >= 0 && dither == ed;
+}
+
+static int init_scaler(AVFilterContext *ctx, struct SwsContext **psws,
+                       int src_w, int src_h, int src_format,
+                       const AVFilterLink *outlink)
+{
+    MultiScaleContext *s = ctx->priv;
+    struct SwsContext *sws;
+    int ret;
+
+    *psws = sws = sws_alloc_context();
+    if (!sws)
+        return AVERROR(ENOMEM);
+
+    if (s->flags_str && *s->flags_str) {
+        ret = av_opt_set(sws, "sws_flags", s->flags_str, 0);
+        if (ret < 0)
+            return ret;
+    }
+    av_opt_set_int(sws, "threads",    1,               0);
+    av_opt_set_int(sws, "srcw",       src_w,           0);
+    av_opt_set_int(sws, "srch",       src_h,           0);
+    av_opt_set_int(sws, "src_format", src_format,      0);
+    av_opt_set_int(sws, "dstw",       outlink->w,      0);
+    av_opt_set_int(sws, "dsth",       outlink->h,      0);
+    av_opt_set_int(sws, "dst_format", outlink->format, 0);
+
+    /* MPEG-2 chroma positions, as in the scale filter */
+    if (src_format == AV_PIX_FMT_YUV420P)
+        av_opt_set_int(sws, "src_v_chr_pos", 128, 0);
+    if (outlink->format == AV_PIX_FMT_YUV420P)
+        av_opt_set_int(sws, "dst_v_chr_pos", 128, 0);
+
+    return sws_init_context(sws, NULL, NULL);
+}
+
+/* Pick the source of every output and set up its scalers. */
+static int config_scalers(AVFilterContext *ctx, const AVFrame *in)
+{
+    MultiScaleContext *s = ctx->priv;
+    const int threads = ff_filter_get_nb_threads(ctx);
+    int ret;
+
+    s->src_w      = in->width;
+    s->src_h      = in->height;
+    s->src_format = in->format;
+
+    for (int k = 0; k < s->nb_outputs; k++) {
+        const AVFilterLink *outlink = ctx->outputs[k];
+        int64_t area = (int64_t)outlink->w * outlink->h;
+        int m = k;
+
+        /* stable insertion sort, larger outputs first */
+        for (; m > 0; m--) {
+            const AVFilterLink *prev = ctx->outputs[s->order[m - 1]];
+            if ((int64_t)prev->w * prev->h >= area)
+                break;
+            s->order[m] = s->order[m - 1];
+        }
+        s->order[m] = k;
+    }
+
+    for (int k = 0; k < s->nb_outputs; k++) {
+        MultiScaleOutput *o = &s->outputs[s->order[k]];
+        const AVFilterLink *outlink = ctx->outputs[s->order[k]];
+        int64_t src_area = INT64_MAX;
+        int src_w = in->width, src_h = in->height, src_format = in->format;
+        int nb_slices = FFMIN(threads, outlink->h);
+
+        o->src = -1;
+        for (int m = 0; s->cascade && m < k; m++) {
+            const AVFilterLink *l = ctx->outputs[s->order[m]];
+
+            /* only downscaled outputs of the same format, anything else
+             * would lose detail or precision the input has */
+            if (l->format == outlink->format && sws_isSupportedInput(l->format) &&
+                l->w >= outlink->w && l->h >= outlink->h &&
+                l->w <= in->width  && l->h <= in->height &&
+                (int64_t)l->w * l->h < (int64_t)in->width * in->height &&
+                (int64_t)l->w * l->h < src_area) {
+                o->src   = s->order[m];
+                src_area = (int64_t)l->w * l->h;
+            }
+        }
+        if (o->src >= 0) {
+            const AVFilterLink *l = ctx->outputs[o->src];
+            src_w      = l->w;
+            src_h      = l->h;
+            src_format = l->format;
+        }
+
+        free_scalers(o);
+        o->sws       = av_calloc(nb_slices, sizeof(*o->sws));
+        o->slice_ret = av_calloc(nb_slices, sizeof(*o->slice_ret));
+        if (!o->sws || !o->slice_ret)
+            return AVERROR(ENOMEM);
+
+        for (int j = 0; j < nb_slices; j++) {
+            o->nb_slices++;
+            ret = init_scaler(ctx, &o->sws[j], src_w, src_h, src_format, outlink);
+            if (ret < 0)
+                return ret;
+            /* error diffusion carries over from one row to the next */
+            if (!j && uses_error_diffusion(o->sws[j]))
+                break;
+        }
+
+        av_log(ctx, AV_LOG_VERBOSE, "output%d: %dx%d %s -> %dx%d %s, %d slices\n",
+               s->order[k], src_w, src_h, av_get_pix_fmt_name(src_format),
+               outlink->w, outlink->h, av_get_pix_fmt_name(outlink->format),
+               o->nb_slices);
+    }
+
+    return 0;
+}
+
+static int scale_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    ThreadData *td = arg;
+    struct SwsContext *sws = td->o->sws[jobnr];
+    const int align = sws_receive_slice_alignment(sws);
+    const int dst_h = td->out->height;
+    const int slice_h = FFALIGN(FFMAX((dst_h + nb_jobs - 1) / nb_jobs, 1), align);
+    const int start = FFMIN(jobnr * slice_h, dst_h);
+    const int end   = FFMIN(start + slice_h, dst_h);
+    int ret;
+
+    if (end <= start)
+        return 0;
+
+    ret = sws_frame_start(sws, td->out, td->in);
+    if (ret < 0)
+        return ret;
+
+    ret = sws_send_slice(sws, 0, td->in->height);
+    if (ret >= 0)
+        ret = sws_receive_slice(sws, start, end - start);
+
+    sws_frame_end(sws);
+
+    return ret;
+}
+
+/* Set the matrix and ranges of the frame about to be scaled, as the scale
+ * filter does. Outputs scaled from another one take its range. */
+static void set_colorspace_details(MultiScaleContext *s, MultiScaleOutput *o,
+                                   const AVFrame *in)
+{
+    const int *coeffs = sws_getCoefficients(in->colorspace);
+
+    for (int j = 0; j < o->nb_slices; j++) {
+        int in_full, out_full, brightness, contrast, saturation;
+        const int *inv_table, *table;
+
+        sws_getColorspaceDetails(o->sws[j], (int **)&inv_table, &in_full,
+                                 (int **)&table, &out_full,
+                                 &brightness, &contrast, &saturation);
+
+        if (o->src >= 0)
+            in_full = s->outputs[o->src].full_range;
+        else if (in->color_range != AVCOL_RANGE_UNSPECIFIED)
+            in_full = in->color_range == AVCOL_RANGE_JPEG;
+
+        sws_setColorspaceDetails(o->sws[j], coeffs, in_full,
+                                 coeffs, out_full,
+                                 brightness, contrast, saturation);
+        o->full_range = out_full;
+    }
+}
+
+static int scale_frame(AVFilterContext *ctx, AVFrame *in)
+{
+    MultiScaleContext *s = ctx->priv;
+    AVFilterLink *inlink = ctx->inputs[0];
+    int ret = 0;
+
+    if (in->width  != inlink->w || in->height != inlink->h ||
+        in->format != inlink->format ||
+        av_cmp_q(in->sample_aspect_ratio, inlink->sample_aspect_ratio)) {
+        inlink->format              = in->format;
+        inlink->w                   = in->width;
+        inlink->h                   = in->height;
+        inlink->sample_aspect_ratio = in->sample_aspect_ratio;
+
+        for (int i = 0; i < ctx->nb_outputs; i++) {
+            ret = config_output(ctx->outputs[i]);
+            if (ret < 0)
+                goto fail;
+        }
+    }
+
+    if (in->width  != s->src_w || in->height != s->src_h ||
+        in->format != s->src_format) {
+        ret = config_scalers(ctx, in);
+        if (ret < 0)
+            goto fail;
+    }
+
+    /* closed outputs are still scaled if an open one is scaled from them */
+    for (int i = 0; i < s->nb_outputs; i++)
+        s->outputs[i].needed = !ff_outlink_get_status(ctx->outputs[i]);
+    for (int k = s->nb_outputs - 1; k >= 0; k--) {
+        const MultiScaleOutput *o = &s->outputs[s->order[k]];
+        if (o->needed && o->src >= 0)
+            s->outputs[o->src].needed = 1;
+    }
+
+    for (int k = 0; k < s->nb_outputs; k++) {
+        MultiScaleOutput *o = &s->outputs[s->order[k]];
+        AVFilterLink *outlink = ctx->outputs[s->order[k]];
+        ThreadData td;
+        AVFrame *out;
+
+        if (!o->needed)
+            continue;
+
+        out = o->frame = ff_get_video_buffer(outlink, outlink->w, outlink->h);
+        if (!out) {
+            ret = AVERROR(ENOMEM);
+            goto fail;
+        }
+        av_frame_copy_props(out, in);
+        out->width  = outlink->w;
+        out->height = outlink->h;
+
+        if (av_pix_fmt_desc_get(out->format)->flags & AV_PIX_FMT_FLAG_RGB)
+            out->colorspace = AVCOL_SPC_RGB;
+        else if (out->colorspace == AVCOL_SPC_RGB)
+            out->colorspace = AVCOL_SPC_UNSPECIFIED;
+
+        set_colorspace_details(s, o, in);
+        out->color_range = o->full_range ? AVCOL_RANGE_JPEG : AVCOL_RANGE_MPEG;
+
+        av_reduce(&out->sample_aspect_ratio.num, &out->sample_aspect_ratio.den,
+                  (int64_t)in->sample_aspect_ratio.num * outlink->h * in->width,
+                  (int64_t)in->sample_aspect_ratio.den * outlink->w * in->height,
+                  INT_MAX);
+
+        td.o   = o;
+        td.in  = o->src >= 0 ? s->outputs[o->src].frame : in;
+        td.out = out;
+        ff_filter_execute(ctx, scale_slice, &td, o->slice_ret, o->nb_slices);
+        for (int j = 0; j < o->nb_slices; j++) {
+            if (o->slice_ret[j] < 0) {
+                ret = o->slice_ret[j];
+                goto fail;
+            }
+        }
+    }
+
+    for (int i = 0; i < s->nb_outputs; i++) {
+        AVFrame *out = s->outputs[i].frame;
+
+        s->outputs[i].frame = NULL;
+        if (!out)
+            continue;
+        if (ff_outlink_get_status(ctx->outputs[i])) {
+            av_frame_free(&out);
+            continue;
+        }
+        ret = ff_filter_frame(ctx->outputs[i], out);
+        if (ret < 0)
+            goto fail;
+    }
+
+fail:
+    for (int i = 0; i < s->nb_outputs; i++)
+        av_frame_free(&s->outputs[i].frame);
+    av_frame_free(&in);
+    return ret;
+}
+
+static int activate(AVFilterContext *ctx)
+{
+    AVFilterLink *inlink = ctx->inputs[0];
+    AVFrame *in;
+    int status, ret, nb_eofs = 0;
+    int64_t pts;
+
+    for (int i = 0; i < ctx->nb_outputs; i++)
+        nb_eofs += ff_outlink_get_status(ctx->outputs[i]) == AVERROR_EOF;
+
+    if (nb_eofs == ctx->nb_outputs) {
+        ff_inlink_set_status(inlink, AVERROR_EOF);
+        return 0;
+    }
+
+    ret = ff_inlink_consume_frame(inlink, &in);
+    if (ret < 0)
+        return ret;
+    if (ret > 0)
+        return scale_frame(ctx, in);
+
+    if (ff_inlink_acknowledge_status(inlink, &status, &pts)) {
+        for (int i = 0; i < ctx->nb_outputs; i++) {
+            if (ff_outlink_get_status(ctx->outputs[i]))
+                continue;
+            ff_outlink_set_status(ctx->outputs[i], status, pts);
+        }
+        return 0;
+    }
+
+    for (int i = 0; i < ctx->nb_outputs; i++) {
+        if (ff_outlink_get_status(ctx->outputs[i]))
+            continue;
+
+        if (ff_outlink_frame_wanted(ctx->outputs[i])) {
+            ff_inlink_request_frame(inlink);
+            return 0;
+        }
+    }
+
+    return FFERROR_NOT_READY;
+}
+
+#define OFFSET(x) offsetof(MultiScaleContext, x)
+#define FLAGS AV_OPT_FLAG_VIDEO_PARAM | AV_OPT_FLAG_FILTERING_PARAM
+static const AVOption multiscale_options[] = {
+    { "sizes",   "'|'-separated list of output sizes", OFFSET(sizes_str), AV_OPT_TYPE_STRING, { .str = NULL }, .flags = FLAGS },
+    { "flags",   "Flags to pass to libswscale",        OFFSET(flags_str), AV_OPT_TYPE_STRING, { .str = "" },   .flags = FLAGS },
+    { "cascade", "scale outputs from the nearest larger output", OFFSET(cascade), AV_OPT_TYPE_BOOL, { .i64 = 1 }, 0, 1, FLAGS },
+    { NULL }
+};
+
+AVFILTER_DEFINE_CLASS(multiscale);
+
+static const AVFilterPad multiscale_inputs[] = {
+    {
+        .name = "default",
+        .type = AVMEDIA_TYPE_VIDEO,
+    },
+};
+
+const AVFilter ff_vf_multiscale = {
+    .name          = "multiscale",
+    .description   = NULL_IF_CONFIG_SMALL("Scale the input video to several sizes."),
+    .priv_size     = sizeof(MultiScaleContext),
+    .priv_class    = &multiscale_class,
+    .init          = init,
+    .uninit        = uninit,
+    .activate      = activate,
+    FILTER_INPUTS(multiscale_inputs),
+    .outputs       = NULL,
+    FILTER_QUERY_FUNC(query_formats),
+    .flags         = AVFILTER_FLAG_DYNAMIC_OUTPUTS | AVFILTER_FLAG_SLICE_THREADS,
+};
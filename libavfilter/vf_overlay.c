@@ -871,6 +871,18 @@ static int blend_slice_rgba_pm(AVFilterContext *ctx, void *arg, int jobnr, int n
     return 0;
 }
 
+av_cold void ff_overlay_init_blend_row(OverlayContext *s, int format, int pix_format,
+                                       int alpha_format, int main_has_alpha)
+{
+    memset(s->blend_row, 0, sizeof(s->blend_row));
+
+#if ARCH_X86
+    ff_overlay_init_x86(s, format, pix_format, alpha_format, main_has_alpha);
+#elif ARCH_AARCH64
+    ff_overlay_init_aarch64(s, format, pix_format, alpha_format, main_has_alpha);
+#endif
+}
+
 static int config_input_main(AVFilterLink *inlink)
 {
     OverlayContext *s = inlink->dst->priv;
@@ -988,10 +1000,8 @@ static int config_input_main(AVFilterLink *inlink)
     }
 
 end:
-#if ARCH_X86
-    ff_overlay_init_x86(s, s->format, inlink->format,
-                        s->alpha_format, s->main_has_alpha);
-#endif
+    ff_overlay_init_blend_row(s, s->format, inlink->format,
+                              s->alpha_format, s->main_has_alpha);
 
     return 0;
 }
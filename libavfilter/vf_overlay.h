@@ -84,7 +84,16 @@ typedef struct OverlayContext {
     int (*blend_slice)(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs);
 } OverlayContext;
 
+/**
+ * Set the optimized blend_row functions for the given formats, or clear
+ * them if there are none.
+ */
+void ff_overlay_init_blend_row(OverlayContext *s, int format, int pix_format,
+                               int alpha_format, int main_has_alpha);
+
 void ff_overlay_init_x86(OverlayContext *s, int format, int pix_format,
                          int alpha_format, int main_has_alpha);
+void ff_overlay_init_aarch64(OverlayContext *s, int format, int pix_format,
+                             int alpha_format, int main_has_alpha);
 
 #endif /* AVFILTER_OVERLAY_H */
@@ -28,6 +28,7 @@
 #include <string.h>
 
 #include "avfilter.h"
+#include "drawutils.h"
 #include "formats.h"
 #include "internal.h"
 #include "scale_eval.h"
@@ -156,6 +157,17 @@ typedef struct ScaleContext {
 
     int eval_mode;              ///< expression evaluation mode
 
+    int crop_x, crop_y, crop_w, crop_h; ///< source rectangle options
+    int pad_x, pad_y, pad_w, pad_h;     ///< output placement options
+    uint8_t pad_rgba[4];
+
+    /* source rectangle actually scaled, and rectangle of the output frame
+     * the scaled picture is written to */
+    int src_x, src_y, src_w, src_h;
+    int dst_x, dst_y, dst_w, dst_h;
+    int cropped, padded;
+    FFDrawContext draw;
+    FFDrawColor pad_color;
 } ScaleContext;
 
 const AVFilter ff_vf_scale2ref;
@@ -448,17 +460,19 @@ static int scale_eval_dimensions(AVFilterContext *ctx)
     double res;
     const AVPixFmtDescriptor *main_desc;
     const AVFilterLink *main_link;
+    const int in_w = scale2ref ? inlink->w : scale->src_w;
+    const int in_h = scale2ref ? inlink->h : scale->src_h;
 
     if (scale2ref) {
         main_link = ctx->inputs[0];
         main_desc = av_pix_fmt_desc_get(main_link->format);
     }
 
-    scale->var_values[VAR_IN_W]  = scale->var_values[VAR_IW] = inlink->w;
-    scale->var_values[VAR_IN_H]  = scale->var_values[VAR_IH] = inlink->h;
+    scale->var_values[VAR_IN_W]  = scale->var_values[VAR_IW] = in_w;
+    scale->var_values[VAR_IN_H]  = scale->var_values[VAR_IH] = in_h;
     scale->var_values[VAR_OUT_W] = scale->var_values[VAR_OW] = NAN;
     scale->var_values[VAR_OUT_H] = scale->var_values[VAR_OH] = NAN;
-    scale->var_values[VAR_A]     = (double) inlink->w / inlink->h;
+    scale->var_values[VAR_A]     = (double) in_w / in_h;
     scale->var_values[VAR_SAR]   = inlink->sample_aspect_ratio.num ?
         (double) inlink->sample_aspect_ratio.num / inlink->sample_aspect_ratio.den : 1;
     scale->var_values[VAR_DAR]   = scale->var_values[VAR_A] * scale->var_values[VAR_SAR];
@@ -468,9 +482,9 @@ static int scale_eval_dimensions(AVFilterContext *ctx)
     scale->var_values[VAR_OVSUB] = 1 << out_desc->log2_chroma_h;
 
     if (scale2ref) {
-        scale->var_values[VAR_S2R_MAIN_W] = main_link->w;
-        scale->var_values[VAR_S2R_MAIN_H] = main_link->h;
-        scale->var_values[VAR_S2R_MAIN_A] = (double) main_link->w / main_link->h;
+        scale->var_values[VAR_S2R_MAIN_W] = scale->src_w;
+        scale->var_values[VAR_S2R_MAIN_H] = scale->src_h;
+        scale->var_values[VAR_S2R_MAIN_A] = (double) scale->src_w / scale->src_h;
         scale->var_values[VAR_S2R_MAIN_SAR] = main_link->sample_aspect_ratio.num ?
             (double) main_link->sample_aspect_ratio.num / main_link->sample_aspect_ratio.den : 1;
         scale->var_values[VAR_S2R_MAIN_DAR] = scale->var_values[VAR_S2R_MDAR] =
@@ -480,7 +494,7 @@ static int scale_eval_dimensions(AVFilterContext *ctx)
     }
 
     res = av_expr_eval(scale->w_pexpr, scale->var_values, NULL);
-    eval_w = scale->var_values[VAR_OUT_W] = scale->var_values[VAR_OW] = (int) res == 0 ? inlink->w : (int) res;
+    eval_w = scale->var_values[VAR_OUT_W] = scale->var_values[VAR_OW] = (int) res == 0 ? in_w : (int) res;
 
     res = av_expr_eval(scale->h_pexpr, scale->var_values, NULL);
     if (isnan(res)) {
@@ -488,7 +502,7 @@ static int scale_eval_dimensions(AVFilterContext *ctx)
         ret = AVERROR(EINVAL);
         goto fail;
     }
-    eval_h = scale->var_values[VAR_OUT_H] = scale->var_values[VAR_OH] = (int) res == 0 ? inlink->h : (int) res;
+    eval_h = scale->var_values[VAR_OUT_H] = scale->var_values[VAR_OH] = (int) res == 0 ? in_h : (int) res;
 
     res = av_expr_eval(scale->w_pexpr, scale->var_values, NULL);
     if (isnan(res)) {
@@ -496,7 +510,7 @@ static int scale_eval_dimensions(AVFilterContext *ctx)
         ret = AVERROR(EINVAL);
         goto fail;
     }
-    eval_w = scale->var_values[VAR_OUT_W] = scale->var_values[VAR_OW] = (int) res == 0 ? inlink->w : (int) res;
+    eval_w = scale->var_values[VAR_OUT_W] = scale->var_values[VAR_OW] = (int) res == 0 ? in_w : (int) res;
 
     scale->w = eval_w;
     scale->h = eval_h;
@@ -509,6 +523,84 @@ fail:
     return ret;
 }
 
+static int config_src_rect(AVFilterContext *ctx, const AVFilterLink *inlink)
+{
+    ScaleContext *scale = ctx->priv;
+    const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(inlink->format);
+    /* whole chroma samples, and whole lines of each field */
+    const int x_align = 1 << desc->log2_chroma_w;
+    const int y_align = (1 << desc->log2_chroma_h) << !!scale->interlaced;
+
+    scale->src_x = scale->crop_x / x_align * x_align;
+    scale->src_y = scale->crop_y / y_align * y_align;
+    scale->src_w = scale->crop_w ? scale->crop_w : inlink->w - scale->src_x;
+    scale->src_h = scale->crop_h ? scale->crop_h : inlink->h - scale->src_y;
+
+    if (scale->src_w <= 0 || scale->src_x + scale->src_w > inlink->w ||
+        scale->src_h <= 0 || scale->src_y + scale->src_h > inlink->h) {
+        av_log(ctx, AV_LOG_ERROR,
+               "Source rectangle %dx%d at %d,%d does not fit in the %dx%d input.\n",
+               scale->src_w, scale->src_h, scale->src_x, scale->src_y,
+               inlink->w, inlink->h);
+        return AVERROR(EINVAL);
+    }
+
+    scale->cropped = scale->src_w != inlink->w || scale->src_h != inlink->h;
+
+    /* av_frame_apply_cropping() cannot move the data pointers of these */
+    if (scale->cropped && (desc->flags & AV_PIX_FMT_FLAG_BITSTREAM)) {
+        av_log(ctx, AV_LOG_ERROR, "Cropping is not supported for the %s input format.\n",
+               desc->name);
+        return AVERROR(ENOSYS);
+    }
+
+    return 0;
+}
+
+/* Size the output frame, and place the scaled picture of size outlink->w x
+ * outlink->h in it. */
+static int config_dst_rect(AVFilterContext *ctx, AVFilterLink *outlink)
+{
+    ScaleContext *scale = ctx->priv;
+    int ret;
+
+    scale->dst_w = outlink->w;
+    scale->dst_h = outlink->h;
+    scale->dst_x = scale->dst_y = 0;
+    scale->padded = 0;
+
+    if (!scale->pad_w && !scale->pad_h && scale->pad_x <= 0 && scale->pad_y <= 0)
+        return 0;
+
+    ret = ff_draw_init(&scale->draw, outlink->format, 0);
+    if (ret < 0) {
+        av_log(ctx, AV_LOG_ERROR, "Padding is not supported for the %s output format.\n",
+               av_get_pix_fmt_name(outlink->format));
+        return ret;
+    }
+    ff_draw_color(&scale->draw, &scale->pad_color, scale->pad_rgba);
+
+    outlink->w = scale->pad_w ? scale->pad_w : scale->dst_w;
+    outlink->h = scale->pad_h ? scale->pad_h : scale->dst_h;
+    scale->dst_x = scale->pad_x < 0 ? (outlink->w - scale->dst_w) / 2 : scale->pad_x;
+    scale->dst_y = scale->pad_y < 0 ? (outlink->h - scale->dst_h) / 2 : scale->pad_y;
+    scale->dst_x = ff_draw_round_to_sub(&scale->draw, 0, -1, scale->dst_x);
+    scale->dst_y = ff_draw_round_to_sub(&scale->draw, 1, -1, scale->dst_y);
+
+    if (scale->dst_x < 0 || scale->dst_x + scale->dst_w > outlink->w ||
+        scale->dst_y < 0 || scale->dst_y + scale->dst_h > outlink->h) {
+        av_log(ctx, AV_LOG_ERROR,
+               "Scaled picture %dx%d at %d,%d does not fit in the %dx%d output.\n",
+               scale->dst_w, scale->dst_h, scale->dst_x, scale->dst_y,
+               outlink->w, outlink->h);
+        return AVERROR(EINVAL);
+    }
+
+    scale->padded = outlink->w != scale->dst_w || outlink->h != scale->dst_h;
+
+    return 0;
+}
+
 static int config_props(AVFilterLink *outlink)
 {
     AVFilterContext *ctx = outlink->src;
@@ -522,15 +614,24 @@ static int config_props(AVFilterLink *outlink)
     uint8_t *flags_val = NULL;
     int ret;
 
+    if ((ret = config_src_rect(ctx, inlink0)) < 0)
+        goto fail;
+
     if ((ret = scale_eval_dimensions(ctx)) < 0)
         goto fail;
 
     outlink->w = scale->w;
     outlink->h = scale->h;
 
-    ff_scale_adjust_dimensions(inlink, &outlink->w, &outlink->h,
-                               scale->force_original_aspect_ratio,
-                               scale->force_divisible_by);
+    if (inlink == inlink0)
+        ff_scale_adjust_dimensions_wh(scale->src_w, scale->src_h,
+                                      &outlink->w, &outlink->h,
+                                      scale->force_original_aspect_ratio,
+                                      scale->force_divisible_by);
+    else
+        ff_scale_adjust_dimensions(inlink, &outlink->w, &outlink->h,
+                                   scale->force_original_aspect_ratio,
+                                   scale->force_divisible_by);
 
     if (outlink->w > INT_MAX ||
         outlink->h > INT_MAX ||
@@ -538,6 +639,9 @@ static int config_props(AVFilterLink *outlink)
         (outlink->w * inlink->h) > INT_MAX)
         av_log(ctx, AV_LOG_ERROR, "Rescaled value for width or height is too big.\n");
 
+    if ((ret = config_dst_rect(ctx, outlink)) < 0)
+        goto fail;
+
     /* TODO: make algorithm configurable */
 
     scale->input_is_pal = desc->flags & AV_PIX_FMT_FLAG_PAL;
@@ -553,6 +657,7 @@ static int config_props(AVFilterLink *outlink)
     scale->isws[0] = scale->isws[1] = scale->sws = NULL;
     if (inlink0->w == outlink->w &&
         inlink0->h == outlink->h &&
+        !scale->cropped && !scale->padded &&
         !scale->out_color_matrix &&
         scale->in_range == scale->out_range &&
         inlink0->format == outlink->format)
@@ -572,11 +677,11 @@ static int config_props(AVFilterLink *outlink)
             if (ret < 0)
                 return ret;
 
-            av_opt_set_int(s, "srcw", inlink0 ->w, 0);
-            av_opt_set_int(s, "srch", inlink0 ->h >> !!i, 0);
+            av_opt_set_int(s, "srcw", scale->src_w, 0);
+            av_opt_set_int(s, "srch", scale->src_h >> !!i, 0);
             av_opt_set_int(s, "src_format", inlink0->format, 0);
-            av_opt_set_int(s, "dstw", outlink->w, 0);
-            av_opt_set_int(s, "dsth", outlink->h >> !!i, 0);
+            av_opt_set_int(s, "dstw", scale->dst_w, 0);
+            av_opt_set_int(s, "dsth", scale->dst_h >> !!i, 0);
             av_opt_set_int(s, "dst_format", outfmt, 0);
             if (scale->in_range != AVCOL_RANGE_UNSPECIFIED)
                 av_opt_set_int(s, "src_range",
@@ -612,7 +717,7 @@ static int config_props(AVFilterLink *outlink)
     }
 
     if (inlink0->sample_aspect_ratio.num){
-        outlink->sample_aspect_ratio = av_mul_q((AVRational){outlink->h * inlink0->w, outlink->w * inlink0->h}, inlink0->sample_aspect_ratio);
+        outlink->sample_aspect_ratio = av_mul_q((AVRational){scale->dst_h * scale->src_w, scale->dst_w * scale->src_h}, inlink0->sample_aspect_ratio);
     } else
         outlink->sample_aspect_ratio = inlink0->sample_aspect_ratio;
 
@@ -706,6 +811,76 @@ static int scale_field(ScaleContext *scale, AVFrame *dst, AVFrame *src,
     return 0;
 }
 
+/* Scale a frame whose rows are still being written in stripes, each one as
+ * soon as the input rows it depends on are available. */
+static int scale_rows(ScaleContext *scale, AVFrame *dst, AVFrame *src)
+{
+    const int align     = sws_receive_slice_alignment(scale->sws);
+    const int src_align = 1 << scale->vsub;
+    const int stripe    = FFALIGN(FFMAX(dst->height / 16, 1), align);
+    int sent = 0, ret;
+
+    ret = sws_frame_start(scale->sws, dst, src);
+    if (ret < 0)
+        return ret;
+
+    for (int y = 0; y < dst->height;) {
+        const int h = FFMIN(stripe, dst->height - y);
+
+        ret = sws_receive_slice(scale->sws, y, h);
+        if (ret == AVERROR(EAGAIN) && sent < src->height) {
+            int rows = ff_frame_row_progress_await(src, scale->src_y +
+                                                   FFMIN(sent + src_align, src->height));
+
+            rows = FFMIN(rows - scale->src_y, src->height);
+            if (rows < src->height)
+                rows &= ~(src_align - 1);
+            ret = sws_send_slice(scale->sws, sent, rows - sent);
+            sent = rows;
+        } else if (ret >= 0) {
+            y += h;
+        }
+        if (ret < 0)
+            break;
+    }
+
+    sws_frame_end(scale->sws);
+
+    return ret;
+}
+
+/* Restrict dst to the rectangle the scaled picture is written to, after
+ * filling the rest of the frame with the padding color. */
+static void frame_set_dst_rect(ScaleContext *scale, AVFrame *dst)
+{
+    ff_fill_rectangle(&scale->draw, &scale->pad_color, dst->data, dst->linesize,
+                      0, 0, dst->width, scale->dst_y);
+    ff_fill_rectangle(&scale->draw, &scale->pad_color, dst->data, dst->linesize,
+                      0, scale->dst_y + scale->dst_h, dst->width,
+                      dst->height - scale->dst_y - scale->dst_h);
+    ff_fill_rectangle(&scale->draw, &scale->pad_color, dst->data, dst->linesize,
+                      0, scale->dst_y, scale->dst_x, scale->dst_h);
+    ff_fill_rectangle(&scale->draw, &scale->pad_color, dst->data, dst->linesize,
+                      scale->dst_x + scale->dst_w, scale->dst_y,
+                      dst->width - scale->dst_x - scale->dst_w, scale->dst_h);
+
+    for (int i = 0; i < scale->draw.nb_planes; i++)
+        dst->data[i] += (scale->dst_y >> scale->draw.vsub[i]) * dst->linesize[i] +
+                        (scale->dst_x >> scale->draw.hsub[i]) * scale->draw.pixelstep[i];
+    dst->width  = scale->dst_w;
+    dst->height = scale->dst_h;
+}
+
+static void frame_reset_dst_rect(ScaleContext *scale, AVFrame *dst,
+                                 AVFilterLink *outlink)
+{
+    for (int i = 0; i < scale->draw.nb_planes; i++)
+        dst->data[i] -= (scale->dst_y >> scale->draw.vsub[i]) * dst->linesize[i] +
+                        (scale->dst_x >> scale->draw.hsub[i]) * scale->draw.pixelstep[i];
+    dst->width  = outlink->w;
+    dst->height = outlink->h;
+}
+
 static int scale_frame(AVFilterLink *link, AVFrame *in, AVFrame **frame_out)
 {
     AVFilterContext *ctx = link->dst;
@@ -803,6 +978,8 @@ FF_ENABLE_DEPRECATION_WARNINGS
 
 scale:
     if (!scale->sws) {
+        /* the next filter only takes complete frames */
+        ff_frame_row_progress_complete(in);
         *frame_out = in;
         return 0;
     }
@@ -810,6 +987,18 @@ scale:
     scale->hsub = desc->log2_chroma_w;
     scale->vsub = desc->log2_chroma_h;
 
+    if (scale->cropped) {
+        in->crop_left   = scale->src_x;
+        in->crop_top    = scale->src_y;
+        in->crop_right  = in->width  - scale->src_x - scale->src_w;
+        in->crop_bottom = in->height - scale->src_y - scale->src_h;
+        ret = av_frame_apply_cropping(in, AV_FRAME_CROP_UNALIGNED);
+        if (ret < 0) {
+            av_frame_free(&in);
+            return ret;
+        }
+    }
+
     out = ff_get_video_buffer(outlink, outlink->w, outlink->h);
     if (!out) {
         av_frame_free(&in);
@@ -818,6 +1007,8 @@ scale:
     *frame_out = out;
 
     av_frame_copy_props(out, in);
+    /* the output is complete, unlike the input */
+    av_buffer_unref(&out->private_ref);
     out->width  = outlink->w;
     out->height = outlink->h;
 
@@ -880,19 +1071,28 @@ scale:
     }
 
     av_reduce(&out->sample_aspect_ratio.num, &out->sample_aspect_ratio.den,
-              (int64_t)in->sample_aspect_ratio.num * outlink->h * link->w,
-              (int64_t)in->sample_aspect_ratio.den * outlink->w * link->h,
+              (int64_t)in->sample_aspect_ratio.num * scale->dst_h * scale->src_w,
+              (int64_t)in->sample_aspect_ratio.den * scale->dst_w * scale->src_h,
               INT_MAX);
 
+    if (scale->padded)
+        frame_set_dst_rect(scale, out);
+
     if (scale->interlaced>0 || (scale->interlaced<0 &&
         (in->flags & AV_FRAME_FLAG_INTERLACED))) {
+        ff_frame_row_progress_await(in, INT_MAX);
         ret = scale_field(scale, out, in, 0);
         if (ret >= 0)
             ret = scale_field(scale, out, in, 1);
+    } else if (ff_frame_row_progress_has(in)) {
+        ret = scale_rows(scale, out, in);
     } else {
         ret = sws_scale_frame(scale->sws, out, in);
     }
 
+    if (scale->padded)
+        frame_reset_dst_rect(scale, out, outlink);
+
     av_frame_free(&in);
     if (ret < 0)
         av_frame_free(frame_out);
@@ -1030,6 +1230,15 @@ static const AVOption scale_options[] = {
     { "decrease", NULL, 0, AV_OPT_TYPE_CONST, {.i64 = 1 }, 0, 0, FLAGS, "force_oar" },
     { "increase", NULL, 0, AV_OPT_TYPE_CONST, {.i64 = 2 }, 0, 0, FLAGS, "force_oar" },
     { "force_divisible_by", "enforce that the output resolution is divisible by a defined integer when force_original_aspect_ratio is used", OFFSET(force_divisible_by), AV_OPT_TYPE_INT, { .i64 = 1}, 1, 256, FLAGS },
+    { "crop_x", "left edge of the source rectangle",  OFFSET(crop_x), AV_OPT_TYPE_INT, { .i64 = 0 }, 0, INT_MAX, FLAGS },
+    { "crop_y", "top edge of the source rectangle",   OFFSET(crop_y), AV_OPT_TYPE_INT, { .i64 = 0 }, 0, INT_MAX, FLAGS },
+    { "crop_w", "width of the source rectangle",      OFFSET(crop_w), AV_OPT_TYPE_INT, { .i64 = 0 }, 0, INT_MAX, FLAGS },
+    { "crop_h", "height of the source rectangle",     OFFSET(crop_h), AV_OPT_TYPE_INT, { .i64 = 0 }, 0, INT_MAX, FLAGS },
+    { "pad_w",  "width of the padded output frame",   OFFSET(pad_w),  AV_OPT_TYPE_INT, { .i64 = 0 }, 0, INT_MAX, FLAGS },
+    { "pad_h",  "height of the padded output frame",  OFFSET(pad_h),  AV_OPT_TYPE_INT, { .i64 = 0 }, 0, INT_MAX, FLAGS },
+    { "pad_x",  "left edge of the scaled picture in the padded frame, -1 to center", OFFSET(pad_x), AV_OPT_TYPE_INT, { .i64 = -1 }, -1, INT_MAX, FLAGS },
+    { "pad_y",  "top edge of the scaled picture in the padded frame, -1 to center",  OFFSET(pad_y), AV_OPT_TYPE_INT, { .i64 = -1 }, -1, INT_MAX, FLAGS },
+    { "pad_color", "color of the padded area",        OFFSET(pad_rgba), AV_OPT_TYPE_COLOR, { .str = "black" }, .flags = FLAGS },
     { "param0", "Scaler param 0",             OFFSET(param[0]),  AV_OPT_TYPE_DOUBLE, { .dbl = DBL_MAX  }, -DBL_MAX, DBL_MAX, FLAGS },
     { "param1", "Scaler param 1",             OFFSET(param[1]),  AV_OPT_TYPE_DOUBLE, { .dbl = DBL_MAX  }, -DBL_MAX, DBL_MAX, FLAGS },
     { "eval", "specify when to evaluate expressions", OFFSET(eval_mode), AV_OPT_TYPE_INT, {.i64 = EVAL_MODE_INIT}, 0, EVAL_MODE_NB-1, FLAGS, "eval" },
@@ -1076,6 +1285,7 @@ const AVFilter ff_vf_scale = {
     FILTER_OUTPUTS(avfilter_vf_scale_outputs),
     FILTER_QUERY_FUNC(query_formats),
     .process_command = process_command,
+    .flags_internal  = FF_FILTER_FLAG_ROW_PROGRESS,
 };
 
 static const AVFilterPad avfilter_vf_scale2ref_inputs[] = {
@@ -311,7 +311,14 @@ static int config_output(AVFilterLink *outlink)
 
     s->csp = av_pix_fmt_desc_get(outlink->format);
     s->filter = filter;
-    if (s->csp->comp[0].depth > 8) {
+    ff_yadif_init_filter_line(s, s->csp->comp[0].depth);
+
+    return 0;
+}
+
+av_cold void ff_yadif_init_filter_line(YADIFContext *s, int bit_depth)
+{
+    if (bit_depth > 8) {
         s->filter_line  = filter_line_c_16bit;
         s->filter_edges = filter_edges_16bit;
     } else {
@@ -320,10 +327,10 @@ static int config_output(AVFilterLink *outlink)
     }
 
 #if ARCH_X86
-    ff_yadif_init_x86(s);
+    ff_yadif_init_x86(s, bit_depth);
+#elif ARCH_AARCH64
+    ff_yadif_init_aarch64(s, bit_depth);
 #endif
-
-    return 0;
 }
 
 
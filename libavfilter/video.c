@@ -112,3 +112,71 @@ AVFrame *ff_get_video_buffer(AVFilterLink *link, int w, int h)
 
     return ret;
 }
+
+static void row_progress_free(void *opaque, uint8_t *data)
+{
+    FFFrameRowProgress *rp = (FFFrameRowProgress *)data;
+
+    av_buffer_unref(&rp->progress);
+    av_free(rp);
+}
+
+int ff_frame_row_progress_attach(AVFrame *frame,
+                                 int (*await_rows)(AVBufferRef *progress, int rows),
+                                 AVBufferRef *progress, int row_offset)
+{
+    FFFrameRowProgress *rp = av_mallocz(sizeof(*rp));
+    AVBufferRef *buf;
+
+    if (!rp)
+        return AVERROR(ENOMEM);
+    rp->magic      = FF_FRAME_ROW_PROGRESS_MAGIC;
+    rp->await_rows = await_rows;
+    rp->row_offset = row_offset;
+    rp->progress   = av_buffer_ref(progress);
+    if (!rp->progress) {
+        av_free(rp);
+        return AVERROR(ENOMEM);
+    }
+
+    buf = av_buffer_create((uint8_t *)rp, sizeof(*rp), row_progress_free,
+                           NULL, AV_BUFFER_FLAG_READONLY);
+    if (!buf) {
+        row_progress_free(NULL, (uint8_t *)rp);
+        return AVERROR(ENOMEM);
+    }
+
+    av_buffer_unref(&frame->private_ref);
+    frame->private_ref = buf;
+    return 0;
+}
+
+int ff_frame_row_progress_has(const AVFrame *frame)
+{
+    return frame->private_ref &&
+           frame->private_ref->size == sizeof(FFFrameRowProgress) &&
+           ((const FFFrameRowProgress *)frame->private_ref->data)->magic ==
+           FF_FRAME_ROW_PROGRESS_MAGIC;
+}
+
+int ff_frame_row_progress_await(const AVFrame *frame, int rows)
+{
+    const FFFrameRowProgress *rp;
+    int ret;
+
+    if (!ff_frame_row_progress_has(frame))
+        return INT_MAX;
+    rp = (const FFFrameRowProgress *)frame->private_ref->data;
+
+    ret = rp->await_rows(rp->progress, rows > INT_MAX - rp->row_offset ?
+                                       INT_MAX : rows + rp->row_offset);
+    return ret == INT_MAX ? INT_MAX : FFMAX(ret - rp->row_offset, 0);
+}
+
+void ff_frame_row_progress_complete(AVFrame *frame)
+{
+    if (!ff_frame_row_progress_has(frame))
+        return;
+    ff_frame_row_progress_await(frame, INT_MAX);
+    av_buffer_unref(&frame->private_ref);
+}
@@ -38,4 +38,51 @@ AVFrame *ff_null_get_video_buffer(AVFilterLink *link, int w, int h);
  */
 AVFrame *ff_get_video_buffer(AVFilterLink *link, int w, int h);
 
+#define FF_FRAME_ROW_PROGRESS_MAGIC MKTAG('R', 'O', 'W', 'P')
+
+/**
+ * Progress of a frame added with av_buffersrc_add_frame_row_progress(),
+ * attached to it through AVFrame.private_ref.
+ */
+typedef struct FFFrameRowProgress {
+    /**
+     * FF_FRAME_ROW_PROGRESS_MAGIC, telling it from other private_ref data
+     * of the same size.
+     */
+    uint32_t     magic;
+    int        (*await_rows)(AVBufferRef *progress, int rows);
+    AVBufferRef *progress;
+    /**
+     * Rows of the progress above the first row of the frame, i.e. the rows
+     * cropped from its top.
+     */
+    int          row_offset;
+} FFFrameRowProgress;
+
+/**
+ * Attach row progress to a frame, replacing its private_ref.
+ */
+int ff_frame_row_progress_attach(AVFrame *frame,
+                                 int (*await_rows)(AVBufferRef *progress, int rows),
+                                 AVBufferRef *progress, int row_offset);
+
+/**
+ * @return whether the frame has row progress attached
+ */
+int ff_frame_row_progress_has(const AVFrame *frame);
+
+/**
+ * Wait until at least the first rows rows of the frame are written.
+ *
+ * @return the number of rows written so far, which may be more than rows,
+ *         or INT_MAX if the frame is complete or has no row progress
+ */
+int ff_frame_row_progress_await(const AVFrame *frame, int rows);
+
+/**
+ * Wait until the frame is complete and detach its row progress, so that it
+ * can be passed on to the next filter.
+ */
+void ff_frame_row_progress_complete(AVFrame *frame);
+
 #endif /* AVFILTER_VIDEO_H */
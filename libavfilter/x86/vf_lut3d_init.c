@@ -57,12 +57,12 @@ static int interp_##name##_##format##_##opt(AVFilterContext *ctx, void *arg, int
 
 av_cold void ff_lut3d_init_x86(LUT3DContext *s, const AVPixFmtDescriptor *desc)
 {
+#if ARCH_X86_64
     int cpu_flags = av_get_cpu_flags();
     int planar = desc->flags & AV_PIX_FMT_FLAG_PLANAR;
-    int isfloat = desc->flags & AV_PIX_FMT_FLAG_FLOAT;
-    int depth = desc->comp[0].depth;
+    av_unused int isfloat = desc->flags & AV_PIX_FMT_FLAG_FLOAT;
+    av_unused int depth = desc->comp[0].depth;
 
-#if ARCH_X86_64
     if (EXTERNAL_AVX2_FAST(cpu_flags) && EXTERNAL_FMA3(cpu_flags) && s->interpolation == INTERPOLATE_TETRAHEDRAL && planar) {
 #if HAVE_AVX2_EXTERNAL
         if (isfloat && planar) {
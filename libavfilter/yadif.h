@@ -88,7 +88,9 @@ typedef struct YADIFContext {
     int current_field;  ///< YADIFCurrentField
 } YADIFContext;
 
-void ff_yadif_init_x86(YADIFContext *yadif);
+void ff_yadif_init_filter_line(YADIFContext *yadif, int bit_depth);
+void ff_yadif_init_x86(YADIFContext *yadif, int bit_depth);
+void ff_yadif_init_aarch64(YADIFContext *yadif, int bit_depth);
 
 int ff_yadif_filter_frame(AVFilterLink *link, AVFrame *frame);
 
@@ -86,8 +86,20 @@ typedef struct BufferPoolEntry {
 } BufferPoolEntry;
 
 struct AVBufferPool {
+    /*
+     * Serializes removal of entries from the free list. Returning buffers
+     * to the pool does not take it, so buffers released from other threads
+     * never contend with each other or with av_buffer_pool_get().
+     */
     AVMutex mutex;
-    BufferPoolEntry *pool;
+
+    /*
+     * Lock-free LIFO of available BufferPoolEntry, stored as an uintptr_t.
+     * Entries are pushed with a compare-and-swap; they are only ever popped
+     * with the mutex held, which rules out the ABA problem without needing
+     * tagged pointers.
+     */
+    atomic_uintptr_t pool;
 
     /*
      * This is used to track when the pool is to be freed.
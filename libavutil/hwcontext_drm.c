@@ -30,7 +30,14 @@
 #include <sys/ioctl.h>
 #endif
 
+/* The dma-heap interface was introduced in Linux 5.6; without it frames
+ * are only allocated as dumb buffers on the DRM device. */
+#if HAVE_LINUX_DMA_HEAP_H
+#include <linux/dma-heap.h>
+#endif
+
 #include <drm.h>
+#include <drm_fourcc.h>
 #include <xf86drm.h>
 
 #include "avassert.h"
@@ -38,6 +45,76 @@
 #include "hwcontext_drm.h"
 #include "hwcontext_internal.h"
 #include "imgutils.h"
+#include "mem.h"
+#include "thread.h"
+
+/**
+ * Buffer of the internal pool.
+ *
+ * The CPU mapping of its object is created on first use and kept until
+ * the buffer itself is freed, so it never outlives the dmabuf it maps.
+ */
+typedef struct DRMPoolBuffer {
+    // Must be first: this is the data of the pool buffer.
+    AVDRMFrameDescriptor desc;
+    // Next live buffer of the frames context.
+    struct DRMPoolBuffer *next;
+    void *address;
+    int   prot;
+    // Number of frame mappings currently using the mapping.
+    int   refcount;
+} DRMPoolBuffer;
+
+typedef struct DRMFramesContext {
+    /**
+     * dma-heap used to allocate frames, or -1 to allocate dumb buffers
+     * on the device instead.
+     */
+    int heap_fd;
+    /**
+     * Layout shared by all frames allocated from the internal pool.
+     */
+    AVDRMLayerDescriptor layer;
+    size_t size;
+
+    /**
+     * Live buffers of the internal pool, only available once frames_init()
+     * has been called (i.e. not on derived frames contexts).
+     */
+    int cache_ready;
+    AVMutex cache_lock;
+    DRMPoolBuffer *pool_buffers;
+} DRMFramesContext;
+
+static const struct {
+    enum AVPixelFormat pix_fmt;
+    uint32_t drm_format;
+} supported_formats[] = {
+    { AV_PIX_FMT_NV12,    DRM_FORMAT_NV12     },
+    { AV_PIX_FMT_NV21,    DRM_FORMAT_NV21     },
+    { AV_PIX_FMT_NV16,    DRM_FORMAT_NV16     },
+    { AV_PIX_FMT_YUV420P, DRM_FORMAT_YUV420   },
+    { AV_PIX_FMT_YUV422P, DRM_FORMAT_YUV422   },
+    { AV_PIX_FMT_YUV444P, DRM_FORMAT_YUV444   },
+#ifdef DRM_FORMAT_P010
+    { AV_PIX_FMT_P010,    DRM_FORMAT_P010     },
+#endif
+    { AV_PIX_FMT_YUYV422, DRM_FORMAT_YUYV     },
+    { AV_PIX_FMT_UYVY422, DRM_FORMAT_UYVY     },
+    { AV_PIX_FMT_GRAY8,   DRM_FORMAT_R8       },
+    { AV_PIX_FMT_BGRA,    DRM_FORMAT_ARGB8888 },
+    { AV_PIX_FMT_RGBA,    DRM_FORMAT_ABGR8888 },
+    { AV_PIX_FMT_BGR0,    DRM_FORMAT_XRGB8888 },
+    { AV_PIX_FMT_RGB0,    DRM_FORMAT_XBGR8888 },
+};
+
+#if HAVE_LINUX_DMA_HEAP_H
+static const char *const dma_heaps[] = {
+    "/dev/dma_heap/linux,cma",
+    "/dev/dma_heap/reserved",
+    "/dev/dma_heap/system",
+};
+#endif
 
 
 static void drm_device_free(AVHWDeviceContext *hwdev)
@@ -92,6 +169,248 @@ static int drm_get_buffer(AVHWFramesContext *hwfc, AVFrame *frame)
     return 0;
 }
 
+static int drm_alloc_dumb(AVHWFramesContext *hwfc, size_t *size)
+{
+    AVDRMDeviceContext *hwctx = hwfc->device_ctx->hwctx;
+    DRMFramesContext      *ctx = hwfc->internal->priv;
+    struct drm_mode_create_dumb   create  = { 0 };
+    struct drm_mode_destroy_dumb  destroy = { 0 };
+    int fd, err;
+
+    if (hwctx->fd < 0) {
+        av_log(hwfc, AV_LOG_ERROR, "No dma-heap is available and the "
+               "device has no DRM fd to allocate dumb buffers on.\n");
+        return AVERROR(ENODEV);
+    }
+
+    // Dumb buffers are two-dimensional: allocate the whole frame as a
+    // single 8-bit plane with the pitch of the first plane.
+    create.bpp    = 8;
+    create.width  = ctx->layer.planes[0].pitch;
+    create.height = (ctx->size + create.width - 1) / create.width;
+
+    if (drmIoctl(hwctx->fd, DRM_IOCTL_MODE_CREATE_DUMB, &create) < 0) {
+        err = errno;
+        av_log(hwfc, AV_LOG_ERROR, "Failed to create dumb buffer of "
+               "size %zu: %d.\n", ctx->size, err);
+        return AVERROR(err);
+    }
+
+    err = drmPrimeHandleToFD(hwctx->fd, create.handle, O_RDWR, &fd);
+    if (err < 0) {
+        av_log(hwfc, AV_LOG_ERROR, "Failed to export dumb buffer: %d.\n",
+               err);
+        err = AVERROR(EIO);
+    }
+
+    // The exported dmabuf keeps the underlying object alive.
+    destroy.handle = create.handle;
+    drmIoctl(hwctx->fd, DRM_IOCTL_MODE_DESTROY_DUMB, &destroy);
+
+    if (err < 0)
+        return err;
+
+    *size = create.size;
+    return fd;
+}
+
+static int drm_alloc_dmabuf(AVHWFramesContext *hwfc, size_t *size)
+{
+#if HAVE_LINUX_DMA_HEAP_H
+    DRMFramesContext *ctx = hwfc->internal->priv;
+
+    if (ctx->heap_fd >= 0) {
+        struct dma_heap_allocation_data alloc = {
+            .len      = ctx->size,
+            .fd_flags = O_RDWR,
+        };
+
+        if (ioctl(ctx->heap_fd, DMA_HEAP_IOCTL_ALLOC, &alloc) < 0) {
+            int err = errno;
+            av_log(hwfc, AV_LOG_ERROR, "Failed to allocate %zu bytes "
+                   "from dma-heap: %d.\n", ctx->size, err);
+            return AVERROR(err);
+        }
+
+        *size = ctx->size;
+        return alloc.fd;
+    }
+#endif
+
+    return drm_alloc_dumb(hwfc, size);
+}
+
+static void drm_pool_free(void *opaque, uint8_t *data)
+{
+    AVHWFramesContext *hwfc = opaque;
+    DRMFramesContext   *ctx = hwfc->internal->priv;
+    DRMPoolBuffer      *buf = (DRMPoolBuffer*)data;
+    DRMPoolBuffer     **cur;
+
+    ff_mutex_lock(&ctx->cache_lock);
+    for (cur = &ctx->pool_buffers; *cur; cur = &(*cur)->next) {
+        if (*cur == buf) {
+            *cur = buf->next;
+            break;
+        }
+    }
+    ff_mutex_unlock(&ctx->cache_lock);
+
+    // Frames mapped from the buffer hold a reference to it.
+    av_assert0(!buf->refcount);
+    if (buf->address)
+        munmap(buf->address, buf->desc.objects[0].size);
+
+    close(buf->desc.objects[0].fd);
+    av_free(buf);
+}
+
+static AVBufferRef *drm_pool_alloc(void *opaque, size_t size)
+{
+    AVHWFramesContext *hwfc = opaque;
+    DRMFramesContext   *ctx = hwfc->internal->priv;
+    AVDRMFrameDescriptor *desc;
+    DRMPoolBuffer *buf;
+    AVBufferRef *ref;
+    size_t obj_size;
+    int fd;
+
+    buf = av_mallocz(sizeof(*buf));
+    if (!buf)
+        return NULL;
+    desc = &buf->desc;
+
+    fd = drm_alloc_dmabuf(hwfc, &obj_size);
+    if (fd < 0) {
+        av_free(buf);
+        return NULL;
+    }
+
+    desc->nb_objects = 1;
+    desc->objects[0].fd              = fd;
+    desc->objects[0].size            = obj_size;
+    desc->objects[0].format_modifier = DRM_FORMAT_MOD_LINEAR;
+
+    desc->nb_layers = 1;
+    desc->layers[0] = ctx->layer;
+
+    ref = av_buffer_create((uint8_t*)buf, sizeof(*desc),
+                           &drm_pool_free, hwfc, 0);
+    if (!ref) {
+        close(fd);
+        av_free(buf);
+        return NULL;
+    }
+
+    ff_mutex_lock(&ctx->cache_lock);
+    buf->next = ctx->pool_buffers;
+    ctx->pool_buffers = buf;
+    ff_mutex_unlock(&ctx->cache_lock);
+
+    return ref;
+}
+
+static int drm_frames_init(AVHWFramesContext *hwfc)
+{
+    DRMFramesContext *ctx = hwfc->internal->priv;
+    uint32_t drm_format = 0;
+    ptrdiff_t linesizes[4];
+    size_t plane_sizes[4];
+    int linesize[4];
+    int i, err, nb_planes;
+    size_t offset;
+
+    ctx->heap_fd = -1;
+
+    err = ff_mutex_init(&ctx->cache_lock, NULL);
+    if (err)
+        return AVERROR(err);
+    ctx->cache_ready = 1;
+
+    if (hwfc->pool)
+        return 0;
+
+    for (i = 0; i < FF_ARRAY_ELEMS(supported_formats); i++) {
+        if (supported_formats[i].pix_fmt == hwfc->sw_format) {
+            drm_format = supported_formats[i].drm_format;
+            break;
+        }
+    }
+    if (!drm_format) {
+        // Frames with other formats are allocated externally (for
+        // example, by a decoder exporting its own buffers).
+        av_log(hwfc, AV_LOG_DEBUG, "No internal allocation support for "
+               "%s frames.\n", av_get_pix_fmt_name(hwfc->sw_format));
+        return 0;
+    }
+
+    // Align the width so that every plane has a 64-byte aligned pitch,
+    // and the height to a whole number of macroblocks, as required by
+    // most display, codec and GPU hardware importing the frames.
+    err = av_image_fill_linesizes(linesize, hwfc->sw_format,
+                                  FFALIGN(hwfc->width, 128));
+    if (err < 0)
+        return err;
+
+    for (i = 0; i < 4; i++)
+        linesizes[i] = linesize[i];
+
+    err = av_image_fill_plane_sizes(plane_sizes, hwfc->sw_format,
+                                    FFALIGN(hwfc->height, 16), linesizes);
+    if (err < 0)
+        return err;
+
+    nb_planes = av_pix_fmt_count_planes(hwfc->sw_format);
+
+    ctx->layer.format    = drm_format;
+    ctx->layer.nb_planes = nb_planes;
+    for (i = offset = 0; i < nb_planes; i++) {
+        ctx->layer.planes[i].object_index = 0;
+        ctx->layer.planes[i].offset       = offset;
+        ctx->layer.planes[i].pitch        = linesizes[i];
+        offset += plane_sizes[i];
+    }
+    ctx->size = FFALIGN(offset, 4096);
+
+#if HAVE_LINUX_DMA_HEAP_H
+    for (i = 0; i < FF_ARRAY_ELEMS(dma_heaps); i++) {
+        ctx->heap_fd = open(dma_heaps[i], O_RDWR);
+        if (ctx->heap_fd >= 0) {
+            av_log(hwfc, AV_LOG_VERBOSE, "Allocating frames from "
+                   "dma-heap %s.\n", dma_heaps[i]);
+            break;
+        }
+    }
+#endif
+    if (ctx->heap_fd < 0)
+        av_log(hwfc, AV_LOG_VERBOSE, "Allocating frames as dumb buffers.\n");
+
+    hwfc->internal->pool_internal =
+        av_buffer_pool_init2(sizeof(AVDRMFrameDescriptor), hwfc,
+                             &drm_pool_alloc, NULL);
+    if (!hwfc->internal->pool_internal)
+        return AVERROR(ENOMEM);
+
+    return 0;
+}
+
+static void drm_frames_uninit(AVHWFramesContext *hwfc)
+{
+    DRMFramesContext *ctx = hwfc->internal->priv;
+
+    // The heap is only opened once a frame layout has been chosen.
+    if (ctx->size && ctx->heap_fd >= 0)
+        close(ctx->heap_fd);
+    ctx->heap_fd = -1;
+
+    if (ctx->cache_ready) {
+        // The internal pool has been freed before.
+        av_assert0(!ctx->pool_buffers);
+        ff_mutex_destroy(&ctx->cache_lock);
+        ctx->cache_ready = 0;
+    }
+}
+
 typedef struct DRMMapping {
     // Address and length of each mmap()ed region.
     int nb_regions;
@@ -99,8 +418,83 @@ typedef struct DRMMapping {
     int object[AV_DRM_MAX_PLANES];
     void *address[AV_DRM_MAX_PLANES];
     size_t length[AV_DRM_MAX_PLANES];
+    // Pool buffer whose mapping backs each region, NULL if mapped for
+    // this frame only.
+    DRMPoolBuffer *cached[AV_DRM_MAX_PLANES];
 } DRMMapping;
 
+static void *drm_map_object(AVHWFramesContext *hwfc,
+                            const AVDRMFrameDescriptor *desc, int i,
+                            int prot, DRMPoolBuffer **cached)
+{
+    DRMFramesContext *ctx = hwfc->internal->priv;
+    const AVDRMObjectDescriptor *object = &desc->objects[i];
+    DRMPoolBuffer *buf;
+    void *addr;
+
+    *cached = NULL;
+    if (!ctx->cache_ready)
+        return mmap(NULL, object->size, prot, MAP_SHARED, object->fd, 0);
+
+    // Only buffers of the internal pool keep their mapping: their
+    // lifetime is known, so a mapping can't be found again once the
+    // dmabuf it maps has been released.
+    ff_mutex_lock(&ctx->cache_lock);
+    for (buf = ctx->pool_buffers; buf; buf = buf->next) {
+        if (&buf->desc == desc)
+            break;
+    }
+
+    if (!buf || i) {
+        ff_mutex_unlock(&ctx->cache_lock);
+        return mmap(NULL, object->size, prot, MAP_SHARED, object->fd, 0);
+    }
+
+    if (!buf->address || (buf->prot & prot) != prot) {
+        if (buf->refcount) {
+            // Still in use with different access: map this frame on its
+            // own rather than pulling the mapping from under the user.
+            ff_mutex_unlock(&ctx->cache_lock);
+            return mmap(NULL, object->size, prot, MAP_SHARED, object->fd, 0);
+        }
+
+        if (buf->address)
+            munmap(buf->address, object->size);
+
+        prot |= buf->prot;
+        addr = mmap(NULL, object->size, prot, MAP_SHARED, object->fd, 0);
+        if (addr == MAP_FAILED) {
+            buf->address = NULL;
+            buf->prot    = 0;
+            ff_mutex_unlock(&ctx->cache_lock);
+            return MAP_FAILED;
+        }
+        buf->address = addr;
+        buf->prot    = prot;
+    }
+
+    buf->refcount++;
+    addr = buf->address;
+    *cached = buf;
+
+    ff_mutex_unlock(&ctx->cache_lock);
+    return addr;
+}
+
+static void drm_unmap_object(AVHWFramesContext *hwfc, DRMPoolBuffer *cached,
+                             void *address, size_t length)
+{
+    DRMFramesContext *ctx = hwfc->internal->priv;
+
+    if (cached) {
+        ff_mutex_lock(&ctx->cache_lock);
+        cached->refcount--;
+        ff_mutex_unlock(&ctx->cache_lock);
+    } else {
+        munmap(address, length);
+    }
+}
+
 static void drm_unmap_frame(AVHWFramesContext *hwfc,
                             HWMapDescriptor *hwmap)
 {
@@ -111,7 +505,8 @@ static void drm_unmap_frame(AVHWFramesContext *hwfc,
         struct dma_buf_sync sync = { .flags = DMA_BUF_SYNC_END | map->sync_flags };
         ioctl(map->object[i], DMA_BUF_IOCTL_SYNC, &sync);
 #endif
-        munmap(map->address[i], map->length[i]);
+        drm_unmap_object(hwfc, map->cached[i],
+                         map->address[i], map->length[i]);
     }
 
     av_free(map);
@@ -149,8 +544,7 @@ static int drm_map_frame(AVHWFramesContext *hwfc,
 
     av_assert0(desc->nb_objects <= AV_DRM_MAX_PLANES);
     for (i = 0; i < desc->nb_objects; i++) {
-        addr = mmap(NULL, desc->objects[i].size, mmap_prot, MAP_SHARED,
-                    desc->objects[i].fd, 0);
+        addr = drm_map_object(hwfc, desc, i, mmap_prot, &map->cached[i]);
         if (addr == MAP_FAILED) {
             err = AVERROR(errno);
             av_log(hwfc, AV_LOG_ERROR, "Failed to map DRM object %d to "
@@ -196,7 +590,8 @@ static int drm_map_frame(AVHWFramesContext *hwfc,
 fail:
     for (i = 0; i < desc->nb_objects; i++) {
         if (map->address[i])
-            munmap(map->address[i], map->length[i]);
+            drm_unmap_object(hwfc, map->cached[i],
+                             map->address[i], map->length[i]);
     }
     av_free(map);
     return err;
@@ -219,9 +614,48 @@ static int drm_transfer_get_formats(AVHWFramesContext *ctx,
     return 0;
 }
 
+#if defined(DRM_FORMAT_MOD_BROADCOM_SAND128) && defined(fourcc_mod_broadcom_mod)
+static int drm_is_sand128(const AVDRMFrameDescriptor *desc)
+{
+    return desc->nb_objects == 1 && desc->nb_layers == 1 &&
+           desc->layers[0].format == DRM_FORMAT_NV12 &&
+           fourcc_mod_broadcom_mod(desc->objects[0].format_modifier) ==
+           DRM_FORMAT_MOD_BROADCOM_SAND128;
+}
+
+static int drm_detile_sand128(AVHWFramesContext *hwfc, AVFrame *dst,
+                              const AVFrame *map, uint64_t modifier)
+{
+    // The frame is stored as columns 128 bytes wide, each one holding
+    // the rows of both planes; the column height is the modifier
+    // parameter.
+    ptrdiff_t col_stride = fourcc_mod_broadcom_param(modifier) * 128;
+
+    if (!col_stride || dst->format != AV_PIX_FMT_NV12) {
+        av_log(hwfc, AV_LOG_ERROR, "Unsupported SAND128 frame layout.\n");
+        return AVERROR(ENOSYS);
+    }
+
+    for (int p = 0; p < 2; p++) {
+        ptrdiff_t bytewidth = p ? FFALIGN(dst->width, 2) : dst->width;
+        int height          = p ? (dst->height + 1) >> 1 : dst->height;
+
+        for (ptrdiff_t x = 0; x < bytewidth; x += 128)
+            av_image_copy_plane_uc_from(dst->data[p] + x, dst->linesize[p],
+                                        map->data[p] + x / 128 * col_stride,
+                                        128, FFMIN(bytewidth - x, 128),
+                                        height);
+    }
+
+    return 0;
+}
+#endif
+
 static int drm_transfer_data_from(AVHWFramesContext *hwfc,
                                   AVFrame *dst, const AVFrame *src)
 {
+    const AVDRMFrameDescriptor *desc = (AVDRMFrameDescriptor*)src->data[0];
+    ptrdiff_t dst_linesize[4], map_linesize[4];
     AVFrame *map;
     int err;
 
@@ -240,9 +674,23 @@ static int drm_transfer_data_from(AVHWFramesContext *hwfc,
     map->width  = dst->width;
     map->height = dst->height;
 
-    err = av_frame_copy(dst, map);
-    if (err)
+#if defined(DRM_FORMAT_MOD_BROADCOM_SAND128) && defined(fourcc_mod_broadcom_mod)
+    if (drm_is_sand128(desc)) {
+        err = drm_detile_sand128(hwfc, dst, map,
+                                 desc->objects[0].format_modifier);
         goto fail;
+    }
+#endif
+
+    // Mapped frames are usually uncached or write-combined, so use the
+    // copy which is optimised for reading from such memory.
+    for (int i = 0; i < 4; i++) {
+        dst_linesize[i] = dst->linesize[i];
+        map_linesize[i] = map->linesize[i];
+    }
+    av_image_copy_uc_from(dst->data, dst_linesize,
+                          (const uint8_t **)map->data, map_linesize,
+                          dst->format, dst->width, dst->height);
 
     err = 0;
 fail:
@@ -306,9 +754,12 @@ const HWContextType ff_hwcontext_type_drm = {
     .name                   = "DRM",
 
     .device_hwctx_size      = sizeof(AVDRMDeviceContext),
+    .frames_priv_size       = sizeof(DRMFramesContext),
 
     .device_create          = &drm_device_create,
 
+    .frames_init            = &drm_frames_init,
+    .frames_uninit          = &drm_frames_uninit,
     .frames_get_buffer      = &drm_get_buffer,
 
     .transfer_get_formats   = &drm_transfer_get_formats,
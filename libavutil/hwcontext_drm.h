@@ -26,10 +26,19 @@
  * @file
  * API-specific header for AV_HWDEVICE_TYPE_DRM.
  *
- * Internal frame allocation is not currently supported - all frames
- * must be allocated by the user.  Thus AVHWFramesContext is always
- * NULL, though this may change if support for frame allocation is
- * added in future.
+ * If no pool is supplied by the user, frames are allocated internally
+ * for a subset of software formats.  Each frame is then a single
+ * linear dmabuf object holding all planes, allocated from a dma-heap
+ * if one is available and from dumb buffers on the device otherwise.
+ * For other formats all frames must be allocated by the user.
+ * AVHWFramesContext.hwctx is always NULL.
+ *
+ * Mapping a frame of the internal pool to memory keeps the CPU mapping of
+ * its buffer until the buffer is freed, so mapping it again is cheap.
+ * Frames allocated by the user, such as the DRM_PRIME frames output by
+ * decoders, are mapped and unmapped on every av_hwframe_map() call, as
+ * their buffers may be released at any time without the frames context
+ * knowing.
  */
 
 enum {
@@ -365,6 +365,9 @@ void av_image_copy_plane_uc_from(uint8_t *dst, ptrdiff_t dst_linesize,
 #if ARCH_X86
     ret = ff_image_copy_plane_uc_from_x86(dst, dst_linesize, src, src_linesize,
                                           bytewidth, height);
+#elif ARCH_AARCH64
+    ret = ff_image_copy_plane_uc_from_aarch64(dst, dst_linesize, src, src_linesize,
+                                              bytewidth, height);
 #endif
 
     if (ret < 0)
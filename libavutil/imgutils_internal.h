@@ -26,5 +26,12 @@ int ff_image_copy_plane_uc_from_x86(uint8_t       *dst, ptrdiff_t dst_linesize,
                                     const uint8_t *src, ptrdiff_t src_linesize,
                                     ptrdiff_t bytewidth, int height);
 
+int ff_image_copy_plane_uc_from_aarch64(uint8_t       *dst, ptrdiff_t dst_linesize,
+                                        const uint8_t *src, ptrdiff_t src_linesize,
+                                        ptrdiff_t bytewidth, int height);
+
+void ff_image_copy_plane_uc_from_neon(uint8_t       *dst, ptrdiff_t dst_linesize,
+                                      const uint8_t *src, ptrdiff_t src_linesize,
+                                      ptrdiff_t bytewidth, int height);
 
 #endif /* AVUTIL_IMGUTILS_INTERNAL_H */
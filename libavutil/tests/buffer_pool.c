@@ -0,0 +1,157 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/*
+ * This test program hammers a single AVBufferPool from several threads,
+ * checking that no buffer is ever handed out twice and that the pool does
+ * not grow beyond the number of buffers actually in use. The time taken for
+ * each thread count is printed to stderr, so that the scaling of
+ * av_buffer_pool_get()/av_buffer_unref() can be compared between builds.
+ */
+
+#include <inttypes.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "libavutil/buffer.h"
+#include "libavutil/thread.h"
+#include "libavutil/time.h"
+
+#define MAX_THREADS  16
+#define BUFS_HELD     4
+#define BUF_SIZE     64
+
+typedef struct TestContext {
+    AVBufferPool *pool;
+    atomic_uint   nb_allocated;
+    int           iterations;
+} TestContext;
+
+typedef struct ThreadContext {
+    TestContext *test;
+    unsigned     id;
+    int          errors;
+} ThreadContext;
+
+static AVBufferRef *test_alloc(void *opaque, size_t size)
+{
+    TestContext *test = opaque;
+
+    atomic_fetch_add(&test->nb_allocated, 1);
+    return av_buffer_alloc(size);
+}
+
+static void *thread_main(void *arg)
+{
+    ThreadContext *t = arg;
+    AVBufferRef *bufs[BUFS_HELD];
+
+    for (int i = 0; i < t->test->iterations; i++) {
+        for (int j = 0; j < BUFS_HELD; j++) {
+            bufs[j] = av_buffer_pool_get(t->test->pool);
+            if (!bufs[j]) {
+                t->errors++;
+                while (j--)
+                    av_buffer_unref(&bufs[j]);
+                return NULL;
+            }
+            memset(bufs[j]->data, t->id, BUF_SIZE);
+        }
+
+        /* another thread owning one of our buffers would have overwritten it */
+        for (int j = 0; j < BUFS_HELD; j++) {
+            for (int k = 0; k < BUF_SIZE; k++)
+                if (bufs[j]->data[k] != (uint8_t)t->id) {
+                    t->errors++;
+                    break;
+                }
+            av_buffer_unref(&bufs[j]);
+        }
+    }
+
+    return NULL;
+}
+
+static int run_test(int nb_threads, int iterations)
+{
+    TestContext test = { .iterations = iterations };
+    ThreadContext threads[MAX_THREADS] = { { 0 } };
+    pthread_t tids[MAX_THREADS];
+    unsigned nb_allocated;
+    int64_t start, elapsed;
+    int errors = 0, ret;
+
+    atomic_init(&test.nb_allocated, 0);
+
+    test.pool = av_buffer_pool_init2(BUF_SIZE, &test, test_alloc, NULL);
+    if (!test.pool)
+        return 1;
+
+    start = av_gettime_relative();
+    for (int i = 0; i < nb_threads; i++) {
+        threads[i].test = &test;
+        threads[i].id   = i + 1;
+        if ((ret = pthread_create(&tids[i], NULL, thread_main, &threads[i]))) {
+            fprintf(stderr, "pthread_create failed: %s.\n", strerror(ret));
+            nb_threads = i;
+            errors++;
+            break;
+        }
+    }
+    for (int i = 0; i < nb_threads; i++) {
+        pthread_join(tids[i], NULL);
+        errors += threads[i].errors;
+    }
+    elapsed = av_gettime_relative() - start;
+
+    av_buffer_pool_uninit(&test.pool);
+
+    nb_allocated = atomic_load(&test.nb_allocated);
+    if (nb_allocated > nb_threads * BUFS_HELD) {
+        fprintf(stderr, "%u buffers allocated for %d in use\n",
+                nb_allocated, nb_threads * BUFS_HELD);
+        errors++;
+    }
+
+    fprintf(stderr, "%2d threads: %8"PRId64" us, %6.1f ns per get/unref\n",
+            nb_threads, elapsed,
+            elapsed * 1000.0 / ((double)nb_threads * iterations * BUFS_HELD));
+    printf("%d threads: %s\n", nb_threads, errors ? "FAILED" : "OK");
+
+    return !!errors;
+}
+
+int main(int argc, char **argv)
+{
+    int iterations = 100000;
+    int ret = 0;
+
+    if (argc > 1)
+        iterations = atoi(argv[1]);
+    if (iterations <= 0) {
+        fprintf(stderr, "Usage: %s [iterations]\n", argv[0]);
+        return 1;
+    }
+
+    for (int nb_threads = 1; nb_threads <= MAX_THREADS; nb_threads *= 2)
+        ret |= run_test(nb_threads, iterations);
+
+    return ret;
+}
@@ -1120,6 +1120,36 @@ int sws_send_slice(struct SwsContext *c, unsigned int slice_start,
     return 0;
 }
 
+/* Number of leading input rows needed to produce the output rows
+ * [dst_start, dst_end), rounded up to the input subsampling. */
+static int src_rows_needed(const SwsContext *c, int dst_start, int dst_end)
+{
+    int macro_height, last, last2, chr_last, rows;
+
+    if (c->slice_ctx)
+        c = c->slice_ctx[0];
+
+    if (dst_start == 0 && dst_end == c->dstH)
+        return c->srcH;
+    /* the cascaded steps run on complete frames */
+    if (c->cascaded_context[0])
+        return c->srcH;
+
+    macro_height = isBayer(c->srcFormat) ? 2 : (1 << c->chrSrcVSubSample);
+
+    if (c->convert_unscaled) {
+        rows = dst_end;
+    } else {
+        last     = dst_end - 1;
+        last2    = FFMIN(last | ((1 << c->chrDstVSubSample) - 1), c->dstH - 1);
+        chr_last = last >> c->chrDstVSubSample;
+        rows     = FFMAX(c->vLumFilterPos[last2] + c->vLumFilterSize,
+                         (c->vChrFilterPos[chr_last] + c->vChrFilterSize) << c->chrSrcVSubSample);
+    }
+
+    return FFMIN(FFALIGN(rows, macro_height), c->srcH);
+}
+
 unsigned int sws_receive_slice_alignment(const struct SwsContext *c)
 {
     if (c->slice_ctx)
@@ -1131,17 +1161,25 @@ unsigned int sws_receive_slice_alignment(const struct SwsContext *c)
 int sws_receive_slice(struct SwsContext *c, unsigned int slice_start,
                       unsigned int slice_height)
 {
+    const SwsContext *c0 = c->slice_ctx ? c->slice_ctx[0] : c;
     unsigned int align = sws_receive_slice_alignment(c);
+    int macro_height = isBayer(c0->srcFormat) ? 2 : (1 << c0->chrSrcVSubSample);
+    int src_height;
     uint8_t *dst[4];
 
-    /* wait until complete input has been received */
-    if (!(c->src_ranges.nb_ranges == 1        &&
-          c->src_ranges.ranges[0].start == 0 &&
-          c->src_ranges.ranges[0].len == c->srcH))
+    /* wait until the input rows the requested output depends on have been
+     * received, only the rows received from the top on are used */
+    if (!c->src_ranges.nb_ranges || c->src_ranges.ranges[0].start)
+        return AVERROR(EAGAIN);
+    src_height = c->src_ranges.ranges[0].len;
+    if (src_height < c->srcH)
+        src_height &= ~(macro_height - 1);
+    if (src_height < src_rows_needed(c, slice_start, slice_start + slice_height))
         return AVERROR(EAGAIN);
 
     if ((slice_start > 0 || slice_height < c->dstH) &&
-        (slice_start % align || slice_height % align)) {
+        (slice_start % align ||
+         (slice_height % align && slice_start + slice_height != c->dstH))) {
         av_log(c, AV_LOG_ERROR,
                "Incorrectly aligned output: %u/%u not multiples of %u\n",
                slice_start, slice_height, align);
@@ -1152,6 +1190,7 @@ int sws_receive_slice(struct SwsContext *c, unsigned int slice_start,
         int nb_jobs = c->slice_ctx[0]->dither == SWS_DITHER_ED ? 1 : c->nb_slice_ctx;
         int ret = 0;
 
+        c->src_slice_height = src_height;
         c->dst_slice_start  = slice_start;
         c->dst_slice_height = slice_height;
 
@@ -1170,12 +1209,13 @@ int sws_receive_slice(struct SwsContext *c, unsigned int slice_start,
     }
 
     for (int i = 0; i < FF_ARRAY_ELEMS(dst); i++) {
-        ptrdiff_t offset = c->frame_dst->linesize[i] * (slice_start >> c->chrDstVSubSample);
+        const int vshift = (i == 1 || i == 2) ? c->chrDstVSubSample : 0;
+        ptrdiff_t offset = c->frame_dst->linesize[i] * (slice_start >> vshift);
         dst[i] = FF_PTR_ADD(c->frame_dst->data[i], offset);
     }
 
     return scale_internal(c, (const uint8_t * const *)c->frame_src->data,
-                          c->frame_src->linesize, 0, c->srcH,
+                          c->frame_src->linesize, 0, src_height,
                           dst, c->frame_dst->linesize, slice_start, slice_height);
 }
 
@@ -1237,7 +1277,7 @@ void ff_sws_slice_worker(void *priv, int jobnr, int threadnr,
         }
 
         err = scale_internal(c, (const uint8_t * const *)parent->frame_src->data,
-                             parent->frame_src->linesize, 0, c->srcH,
+                             parent->frame_src->linesize, 0, parent->src_slice_height,
                              dst, parent->frame_dst->linesize,
                              parent->dst_slice_start + slice_start, slice_end - slice_start);
     }
@@ -312,6 +312,8 @@ typedef struct SwsContext {
     // values passed to current sws_receive_slice() call
     int dst_slice_start;
     int dst_slice_height;
+    // number of input rows available to the current sws_receive_slice() call
+    int src_slice_height;
 
     /**
      * Note that src, dst, srcStride, dstStride will be copied in the
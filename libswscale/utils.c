@@ -2593,8 +2593,8 @@ int ff_range_add(RangeList *rl, unsigned int start, unsigned int len)
         Range *cur  = &rl->ranges[idx];
         if (prev->start + prev->len == cur->start) {
             prev->len += cur->len;
-            memmove(rl->ranges + idx - 1, rl->ranges + idx,
-                    sizeof(*rl->ranges) * (rl->nb_ranges - idx));
+            memmove(rl->ranges + idx, rl->ranges + idx + 1,
+                    sizeof(*rl->ranges) * (rl->nb_ranges - idx - 1));
             rl->nb_ranges--;
             idx--;
         }
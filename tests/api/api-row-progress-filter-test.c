@@ -0,0 +1,288 @@
+/*
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/**
+ * Row progress filter test: frames are added with
+ * av_buffersrc_add_frame_row_progress() while a second thread is still
+ * writing their rows, each stripe only once the filter waits for it, and
+ * must be scaled like the same frames added complete.
+ */
+
+#include <string.h>
+
+#include "libavutil/frame.h"
+#include "libavutil/pixdesc.h"
+#include "libavutil/thread.h"
+#include "libavfilter/avfilter.h"
+#include "libavfilter/buffersink.h"
+#include "libavfilter/buffersrc.h"
+
+#define WIDTH     320
+#define HEIGHT    256
+#define CROP_TOP  16
+#define STRIPE    16
+#define NB_FRAMES 3
+#define SCALE     "160:120:flags=bitexact+accurate_rnd"
+
+typedef struct Progress {
+    pthread_mutex_t mutex;
+    pthread_cond_t  cond;
+    AVFrame *frame;
+    int      rows;
+    int      waiting;
+    int      done;
+    /* number of waits which returned before the frame was complete */
+    int      nb_partial;
+} Progress;
+
+static void fill_rows(AVFrame *frame, int start, int end, int n)
+{
+    const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(frame->format);
+
+    for (int i = 0; i < 3; i++) {
+        int shift_w = i ? desc->log2_chroma_w : 0;
+        int shift_h = i ? desc->log2_chroma_h : 0;
+
+        for (int y = start >> shift_h; y < end >> shift_h; y++) {
+            uint8_t *row = frame->data[i] + y * frame->linesize[i];
+
+            for (int x = 0; x < frame->width >> shift_w; x++)
+                row[x] = x * (i + 3) + y * (2 * i + 5) + n * 17;
+        }
+    }
+}
+
+/* write a stripe each time the filter is waiting for rows */
+static void *write_rows(void *arg)
+{
+    Progress *p = arg;
+    int n = p->frame->pts;
+
+    pthread_mutex_lock(&p->mutex);
+    while (p->rows < p->frame->height) {
+        while (!p->waiting && !p->done)
+            pthread_cond_wait(&p->cond, &p->mutex);
+        if (p->done)
+            break;
+        fill_rows(p->frame, p->rows, p->rows + STRIPE, n);
+        p->rows   += STRIPE;
+        p->waiting = 0;
+        pthread_cond_broadcast(&p->cond);
+    }
+    pthread_mutex_unlock(&p->mutex);
+    return NULL;
+}
+
+static int await_rows(AVBufferRef *progress, int rows)
+{
+    Progress *p = (Progress *)progress->data;
+    int ret;
+
+    pthread_mutex_lock(&p->mutex);
+    while (p->rows < FFMIN(rows, p->frame->height)) {
+        p->waiting = 1;
+        pthread_cond_broadcast(&p->cond);
+        pthread_cond_wait(&p->cond, &p->mutex);
+    }
+    if (p->rows < p->frame->height) {
+        ret = p->rows;
+        p->nb_partial++;
+    } else {
+        ret = INT_MAX;
+    }
+    pthread_mutex_unlock(&p->mutex);
+    return ret;
+}
+
+static int init_graph(AVFilterGraph **graph, AVFilterContext **src, AVFilterContext **sink)
+{
+    AVFilterContext *scale;
+    char args[256];
+    int ret;
+
+    *graph = avfilter_graph_alloc();
+    if (!*graph)
+        return AVERROR(ENOMEM);
+
+    snprintf(args, sizeof(args), "video_size=%dx%d:pix_fmt=%d:time_base=1/25",
+             WIDTH, HEIGHT - CROP_TOP, AV_PIX_FMT_YUV420P);
+    ret = avfilter_graph_create_filter(src, avfilter_get_by_name("buffer"),
+                                       "src", args, NULL, *graph);
+    if (ret < 0)
+        return ret;
+    ret = avfilter_graph_create_filter(&scale, avfilter_get_by_name("scale"),
+                                       "scale", SCALE, NULL, *graph);
+    if (ret < 0)
+        return ret;
+    ret = avfilter_graph_create_filter(sink, avfilter_get_by_name("buffersink"),
+                                       "sink", NULL, NULL, *graph);
+    if (ret < 0)
+        return ret;
+
+    if ((ret = avfilter_link(*src, 0, scale, 0)) < 0 ||
+        (ret = avfilter_link(scale, 0, *sink, 0)) < 0)
+        return ret;
+
+    return avfilter_graph_config(*graph, NULL);
+}
+
+static int frames_differ(const AVFrame *a, const AVFrame *b)
+{
+    if (a->width != b->width || a->height != b->height || a->format != b->format)
+        return 1;
+
+    for (int i = 0; i < 3; i++) {
+        int w = i ? AV_CEIL_RSHIFT(a->width,  1) : a->width;
+        int h = i ? AV_CEIL_RSHIFT(a->height, 1) : a->height;
+
+        for (int y = 0; y < h; y++)
+            if (memcmp(a->data[i] + y * a->linesize[i],
+                       b->data[i] + y * b->linesize[i], w))
+                return 1;
+    }
+    return 0;
+}
+
+static int filter_frame(int n, AVFilterContext *src, AVFilterContext *sink,
+                        AVFilterContext *ref_src, AVFilterContext *ref_sink)
+{
+    AVFrame *frame = av_frame_alloc(), *out = av_frame_alloc(), *ref = av_frame_alloc();
+    AVBufferRef *progress = NULL;
+    Progress *p;
+    pthread_t thread;
+    int thread_started = 0, ret;
+
+    if (!frame || !out || !ref) {
+        ret = AVERROR(ENOMEM);
+        goto end;
+    }
+
+    frame->format   = AV_PIX_FMT_YUV420P;
+    frame->width    = WIDTH;
+    frame->height   = HEIGHT;
+    frame->pts      = n;
+    frame->crop_top = CROP_TOP;
+    ret = av_frame_get_buffer(frame, 0);
+    if (ret < 0)
+        goto end;
+    for (int i = 0; i < FF_ARRAY_ELEMS(frame->buf) && frame->buf[i]; i++)
+        memset(frame->buf[i]->data, 0, frame->buf[i]->size);
+
+    progress = av_buffer_allocz(sizeof(Progress));
+    if (!progress) {
+        ret = AVERROR(ENOMEM);
+        goto end;
+    }
+    p = (Progress *)progress->data;
+    p->frame = frame;
+    pthread_mutex_init(&p->mutex, NULL);
+    pthread_cond_init(&p->cond, NULL);
+
+    ret = av_buffersrc_add_frame_row_progress(src, frame, AV_BUFFERSRC_FLAG_KEEP_REF,
+                                              await_rows, progress);
+    if (ret < 0) {
+        av_log(NULL, AV_LOG_ERROR, "Can't add frame %d with row progress\n", n);
+        goto end;
+    }
+
+    ret = AVERROR(pthread_create(&thread, NULL, write_rows, p));
+    if (ret < 0)
+        goto end;
+    thread_started = 1;
+
+    ret = av_buffersink_get_frame(sink, out);
+    if (ret < 0) {
+        av_log(NULL, AV_LOG_ERROR, "Can't get scaled frame %d\n", n);
+        goto end;
+    }
+
+    pthread_mutex_lock(&p->mutex);
+    p->done = 1;
+    pthread_cond_broadcast(&p->cond);
+    pthread_mutex_unlock(&p->mutex);
+    pthread_join(thread, NULL);
+    thread_started = 0;
+
+    if (!p->nb_partial) {
+        av_log(NULL, AV_LOG_ERROR, "Frame %d was not scaled before it was complete\n", n);
+        ret = AVERROR_BUG;
+        goto end;
+    }
+
+    /* the same frame, complete, without row progress; any rows the filter
+     * did not wait for are only written now */
+    fill_rows(frame, p->rows, frame->height, n);
+    frame->crop_top = CROP_TOP;
+    ret = av_frame_apply_cropping(frame, 0);
+    if (ret >= 0)
+        ret = av_buffersrc_add_frame_flags(ref_src, frame, AV_BUFFERSRC_FLAG_KEEP_REF);
+    if (ret >= 0)
+        ret = av_buffersink_get_frame(ref_sink, ref);
+    if (ret < 0) {
+        av_log(NULL, AV_LOG_ERROR, "Can't scale complete frame %d\n", n);
+        goto end;
+    }
+
+    if (frames_differ(out, ref)) {
+        av_log(NULL, AV_LOG_ERROR, "Frame %d scaled while written differs "
+               "from the complete frame scaled\n", n);
+        ret = AVERROR_INVALIDDATA;
+    }
+
+end:
+    if (thread_started) {
+        pthread_mutex_lock(&p->mutex);
+        p->done = 1;
+        pthread_cond_broadcast(&p->cond);
+        pthread_mutex_unlock(&p->mutex);
+        pthread_join(thread, NULL);
+    }
+    if (progress) {
+        /* the graph no longer references the progress once the frame is out */
+        pthread_mutex_destroy(&p->mutex);
+        pthread_cond_destroy(&p->cond);
+        av_buffer_unref(&progress);
+    }
+    av_frame_free(&frame);
+    av_frame_free(&out);
+    av_frame_free(&ref);
+    return ret;
+}
+
+int main(void)
+{
+    AVFilterGraph *graph = NULL, *ref_graph = NULL;
+    AVFilterContext *src, *sink, *ref_src, *ref_sink;
+    int ret;
+
+    ret = init_graph(&graph, &src, &sink);
+    if (ret >= 0)
+        ret = init_graph(&ref_graph, &ref_src, &ref_sink);
+    if (ret < 0)
+        av_log(NULL, AV_LOG_ERROR, "Can't create the filter graphs\n");
+
+    for (int n = 0; ret >= 0 && n < NB_FRAMES; n++)
+        ret = filter_frame(n, src, sink, ref_src, ref_sink);
+
+    avfilter_graph_free(&graph);
+    avfilter_graph_free(&ref_graph);
+
+    return ret < 0;
+}
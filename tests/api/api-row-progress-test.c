@@ -0,0 +1,367 @@
+/*
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/**
+ * Row progress test: a second thread copies the rows of the frames passed to
+ * draw_horiz_band() as soon as they are reported decoded, and the copies
+ * must match the frames output by the decoder.
+ */
+
+#include <stdatomic.h>
+#include <string.h>
+
+#include "libavutil/adler32.h"
+#include "libavutil/imgutils.h"
+#include "libavutil/pixdesc.h"
+#include "libavutil/thread.h"
+#include "libavutil/threadmessage.h"
+#include "libavcodec/avcodec.h"
+#include "libavformat/avformat.h"
+
+/* attached to the packets, and so to the frames, to identify them */
+typedef struct FrameTag {
+    int        index;
+    atomic_int sent;
+} FrameTag;
+
+typedef struct RowsMessage {
+    AVFrame     *frame;
+    AVBufferRef *progress;
+    int          index;
+    uint32_t     checksum;
+} RowsMessage;
+
+typedef struct TestContext {
+    AVThreadMessageQueue *in;
+    AVThreadMessageQueue *out;
+    atomic_int error;
+
+    /* checksums of the copied frames by index, only used by the main thread */
+    uint32_t *checksums;
+    uint8_t  *copied;
+    int       nb_checksums;
+} TestContext;
+
+static uint32_t frame_checksum(const AVFrame *frame)
+{
+    const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(frame->format);
+    uint32_t checksum = 0;
+
+    for (int i = 0; i < 3; i++) {
+        int w = i ? AV_CEIL_RSHIFT(frame->width,  desc->log2_chroma_w) : frame->width;
+        int h = i ? AV_CEIL_RSHIFT(frame->height, desc->log2_chroma_h) : frame->height;
+
+        for (int y = 0; y < h; y++)
+            checksum = av_adler32_update(checksum, frame->data[i] + y * frame->linesize[i], w);
+    }
+    return checksum;
+}
+
+static void draw_horiz_band(AVCodecContext *ctx, const AVFrame *fr, int offset[4],
+                            int slice_position, int type, int height)
+{
+    TestContext *t = ctx->opaque;
+    FrameTag *tag;
+    RowsMessage msg = { 0 };
+    int ret;
+
+    if (!fr->opaque_ref)
+        return;
+    tag = (FrameTag *)fr->opaque_ref->data;
+
+    /* hand each frame to the copying thread once, when its first rows are
+     * decoded; with frame threading, this is called from several threads */
+    if (atomic_exchange(&tag->sent, 1))
+        return;
+
+    msg.index    = tag->index;
+    msg.progress = avcodec_get_row_progress(fr);
+    msg.frame    = av_frame_clone(fr);
+    if (!msg.progress || !msg.frame) {
+        av_log(NULL, AV_LOG_ERROR, "Can't get the frame progress\n");
+        goto fail;
+    }
+    ret = av_thread_message_queue_send(t->in, &msg, 0);
+    if (ret >= 0)
+        return;
+fail:
+    atomic_store(&t->error, 1);
+    av_buffer_unref(&msg.progress);
+    av_frame_free(&msg.frame);
+}
+
+static void *copy_rows(void *arg)
+{
+    TestContext *t = arg;
+    RowsMessage msg;
+
+    while (av_thread_message_queue_recv(t->in, &msg, 0) >= 0) {
+        AVFrame *src = msg.frame;
+        const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(src->format);
+        AVFrame *dst = av_frame_alloc();
+        int copied = 0, rows = 0, ret;
+
+        if (!dst)
+            goto fail;
+        dst->format = src->format;
+        dst->width  = src->width;
+        dst->height = src->height;
+        ret = av_frame_get_buffer(dst, 0);
+        if (ret < 0)
+            goto fail;
+
+        while (rows < src->height) {
+            rows = avcodec_row_progress_await(msg.progress, copied + 16);
+            rows = FFMIN(rows, src->height);
+            if (rows < src->height)
+                rows &= ~((1 << desc->log2_chroma_h) - 1);
+
+            for (int i = 0; i < 3; i++) {
+                int shift = i ? desc->log2_chroma_h : 0;
+                int start = copied >> shift;
+                int end   = AV_CEIL_RSHIFT(rows, shift);
+
+                av_image_copy_plane(dst->data[i] + start * dst->linesize[i], dst->linesize[i],
+                                    src->data[i] + start * src->linesize[i], src->linesize[i],
+                                    AV_CEIL_RSHIFT(src->width, i ? desc->log2_chroma_w : 0),
+                                    end - start);
+            }
+            copied = rows;
+        }
+
+        dst->crop_top    = src->crop_top;
+        dst->crop_bottom = src->crop_bottom;
+        dst->crop_left   = src->crop_left;
+        dst->crop_right  = src->crop_right;
+        ret = av_frame_apply_cropping(dst, 0);
+        if (ret < 0)
+            goto fail;
+        msg.checksum = frame_checksum(dst);
+
+        av_frame_free(&dst);
+        av_frame_free(&msg.frame);
+        av_buffer_unref(&msg.progress);
+        ret = av_thread_message_queue_send(t->out, &msg, 0);
+        if (ret < 0)
+            break;
+        continue;
+fail:
+        av_frame_free(&dst);
+        av_frame_free(&msg.frame);
+        av_buffer_unref(&msg.progress);
+        av_thread_message_queue_set_err_recv(t->out, AVERROR(ENOMEM));
+        break;
+    }
+    av_thread_message_queue_set_err_recv(t->out, AVERROR_EOF);
+    return NULL;
+}
+
+static void free_message(void *arg)
+{
+    RowsMessage *msg = arg;
+
+    av_frame_free(&msg->frame);
+    av_buffer_unref(&msg->progress);
+}
+
+static int check_frame(TestContext *t, const AVFrame *frame)
+{
+    int n;
+
+    if (!frame->opaque_ref) {
+        av_log(NULL, AV_LOG_ERROR, "Output frame without packet properties\n");
+        return AVERROR_INVALIDDATA;
+    }
+    n = ((FrameTag *)frame->opaque_ref->data)->index;
+
+    while (n >= t->nb_checksums || !t->copied[n]) {
+        RowsMessage msg;
+        int ret = av_thread_message_queue_recv(t->out, &msg, 0);
+        if (ret < 0) {
+            av_log(NULL, AV_LOG_ERROR, "No rows copied for frame %d\n", n);
+            return ret;
+        }
+        if (msg.index >= t->nb_checksums) {
+            int size = FFMAX(msg.index + 1, 2 * t->nb_checksums);
+
+            ret = av_reallocp_array(&t->checksums, size, sizeof(*t->checksums));
+            if (ret < 0)
+                return ret;
+            ret = av_reallocp_array(&t->copied, size, sizeof(*t->copied));
+            if (ret < 0)
+                return ret;
+            memset(t->copied + t->nb_checksums, 0, size - t->nb_checksums);
+            t->nb_checksums = size;
+        }
+        t->checksums[msg.index] = msg.checksum;
+        t->copied[msg.index]    = 1;
+    }
+
+    if (t->checksums[n] != frame_checksum(frame)) {
+        av_log(NULL, AV_LOG_ERROR, "Rows copied for frame %d differ from the output\n", n);
+        return AVERROR_INVALIDDATA;
+    }
+    return 0;
+}
+
+static int video_decode(const char *input_filename, int threads)
+{
+    TestContext t = { 0 };
+    const AVCodec *codec;
+    AVCodecContext *ctx = NULL;
+    AVFormatContext *fmt_ctx = NULL;
+    AVFrame *fr = NULL;
+    AVPacket *pkt = NULL;
+    pthread_t thread;
+    int thread_started = 0, video_stream, nb_packets = 0, nb_frames = 0, result;
+
+    result = avformat_open_input(&fmt_ctx, input_filename, NULL, NULL);
+    if (result < 0) {
+        av_log(NULL, AV_LOG_ERROR, "Can't open file\n");
+        return result;
+    }
+
+    result = avformat_find_stream_info(fmt_ctx, NULL);
+    if (result < 0) {
+        av_log(NULL, AV_LOG_ERROR, "Can't get stream info\n");
+        goto end;
+    }
+
+    result = video_stream = av_find_best_stream(fmt_ctx, AVMEDIA_TYPE_VIDEO, -1, -1, &codec, 0);
+    if (result < 0) {
+        av_log(NULL, AV_LOG_ERROR, "Can't find video stream in input file\n");
+        goto end;
+    }
+
+    ctx = avcodec_alloc_context3(codec);
+    fr  = av_frame_alloc();
+    pkt = av_packet_alloc();
+    if (!ctx || !fr || !pkt) {
+        result = AVERROR(ENOMEM);
+        goto end;
+    }
+
+    result = avcodec_parameters_to_context(ctx, fmt_ctx->streams[video_stream]->codecpar);
+    if (result < 0) {
+        av_log(NULL, AV_LOG_ERROR, "Can't copy decoder context\n");
+        goto end;
+    }
+
+    ctx->opaque            = &t;
+    ctx->flags            |= AV_CODEC_FLAG_COPY_OPAQUE;
+    ctx->draw_horiz_band   = draw_horiz_band;
+    ctx->thread_count      = threads;
+    ctx->thread_type       = FF_THREAD_FRAME;
+    ctx->export_side_data |= AV_CODEC_EXPORT_DATA_ROW_PROGRESS;
+
+    result = avcodec_open2(ctx, codec, NULL);
+    if (result < 0) {
+        av_log(ctx, AV_LOG_ERROR, "Can't open decoder\n");
+        goto end;
+    }
+
+    if ((result = av_thread_message_queue_alloc(&t.in,  64, sizeof(RowsMessage))) < 0 ||
+        (result = av_thread_message_queue_alloc(&t.out, 64, sizeof(RowsMessage))) < 0)
+        goto end;
+    av_thread_message_queue_set_free_func(t.in,  free_message);
+    av_thread_message_queue_set_free_func(t.out, free_message);
+
+    result = AVERROR(pthread_create(&thread, NULL, copy_rows, &t));
+    if (result < 0)
+        goto end;
+    thread_started = 1;
+
+    while (result >= 0) {
+        result = av_read_frame(fmt_ctx, pkt);
+        if (result >= 0 && pkt->stream_index != video_stream) {
+            av_packet_unref(pkt);
+            continue;
+        }
+        if (result >= 0) {
+            pkt->opaque_ref = av_buffer_allocz(sizeof(FrameTag));
+            if (!pkt->opaque_ref) {
+                result = AVERROR(ENOMEM);
+                goto end;
+            }
+            ((FrameTag *)pkt->opaque_ref->data)->index = nb_packets++;
+        }
+
+        // pkt will be empty on read error/EOF
+        result = avcodec_send_packet(ctx, pkt);
+        av_packet_unref(pkt);
+        if (result < 0) {
+            av_log(NULL, AV_LOG_ERROR, "Error submitting a packet for decoding\n");
+            goto end;
+        }
+
+        while (result >= 0) {
+            result = avcodec_receive_frame(ctx, fr);
+            if (result == AVERROR_EOF)
+                goto end;
+            if (result == AVERROR(EAGAIN)) {
+                result = 0;
+                break;
+            }
+            if (result < 0) {
+                av_log(NULL, AV_LOG_ERROR, "Error decoding frame\n");
+                goto end;
+            }
+            if (atomic_load(&t.error)) {
+                result = AVERROR(ENOMEM);
+                goto end;
+            }
+
+            result = check_frame(&t, fr);
+            nb_frames++;
+            av_frame_unref(fr);
+        }
+    }
+
+end:
+    if (result == AVERROR_EOF)
+        result = nb_frames ? 0 : AVERROR_INVALIDDATA;
+    if (thread_started) {
+        av_thread_message_queue_set_err_recv(t.in, AVERROR_EOF);
+        av_thread_message_queue_set_err_send(t.out, AVERROR_EOF);
+        pthread_join(thread, NULL);
+    }
+    av_thread_message_queue_free(&t.in);
+    av_thread_message_queue_free(&t.out);
+    av_freep(&t.checksums);
+    av_freep(&t.copied);
+    av_packet_free(&pkt);
+    av_frame_free(&fr);
+    avcodec_free_context(&ctx);
+    avformat_close_input(&fmt_ctx);
+    return result;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 3) {
+        av_log(NULL, AV_LOG_ERROR, "Incorrect input: expected %s <threads> <name of a video file>\n", argv[0]);
+        return 1;
+    }
+
+    if (video_decode(argv[2], atoi(argv[1])) < 0)
+        return 1;
+
+    return 0;
+}
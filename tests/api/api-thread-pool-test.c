@@ -0,0 +1,281 @@
+/*
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Shared decoder thread pool test.
+ * Encodes a short MPEG-4 stream, then decodes it with several frame-threaded
+ * decoders sharing one thread pool, fed in turn from a single thread, and
+ * compares their output with single-threaded decoding.
+ */
+
+#include "libavcodec/avcodec.h"
+#include "libavutil/adler32.h"
+#include "libavutil/common.h"
+#include "libavutil/frame.h"
+#include "libavutil/pixdesc.h"
+
+#define WIDTH         176
+#define HEIGHT        144
+#define NB_FRAMES     40
+#define NB_DECODERS   4
+#define FRAME_THREADS 3
+
+typedef struct Decoder {
+    AVCodecContext *avctx;
+    int nb_frames;
+} Decoder;
+
+static AVPacket *packets[NB_FRAMES + 1];
+static int nb_packets;
+static uint32_t checksums[NB_FRAMES];
+static int nb_checksums;
+
+static uint32_t frame_checksum(const AVFrame *frame)
+{
+    const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(frame->format);
+    uint32_t checksum = 0;
+
+    for (int i = 0; i < 3; i++) {
+        int w = i ? AV_CEIL_RSHIFT(frame->width,  desc->log2_chroma_w) : frame->width;
+        int h = i ? AV_CEIL_RSHIFT(frame->height, desc->log2_chroma_h) : frame->height;
+
+        for (int y = 0; y < h; y++)
+            checksum = av_adler32_update(checksum, frame->data[i] + y * frame->linesize[i], w);
+    }
+
+    return checksum;
+}
+
+static int encode(void)
+{
+    const AVCodec *enc = avcodec_find_encoder(AV_CODEC_ID_MPEG4);
+    AVCodecContext *ctx = NULL;
+    AVFrame *frame = NULL;
+    AVPacket *pkt = NULL;
+    int ret;
+
+    if (!enc) {
+        av_log(NULL, AV_LOG_ERROR, "Can't find encoder\n");
+        return AVERROR_ENCODER_NOT_FOUND;
+    }
+
+    ctx   = avcodec_alloc_context3(enc);
+    frame = av_frame_alloc();
+    pkt   = av_packet_alloc();
+    if (!ctx || !frame || !pkt) {
+        ret = AVERROR(ENOMEM);
+        goto end;
+    }
+
+    ctx->width        = WIDTH;
+    ctx->height       = HEIGHT;
+    ctx->pix_fmt      = AV_PIX_FMT_YUV420P;
+    ctx->time_base    = (AVRational){ 1, 25 };
+    ctx->gop_size     = 12;
+    ctx->max_b_frames = 2;
+    ctx->flags       |= AV_CODEC_FLAG_BITEXACT;
+
+    ret = avcodec_open2(ctx, enc, NULL);
+    if (ret < 0) {
+        av_log(ctx, AV_LOG_ERROR, "Can't open encoder\n");
+        goto end;
+    }
+
+    frame->format = ctx->pix_fmt;
+    frame->width  = ctx->width;
+    frame->height = ctx->height;
+    ret = av_frame_get_buffer(frame, 0);
+    if (ret < 0)
+        goto end;
+
+    for (int i = 0; i <= NB_FRAMES; i++) {
+        if (i < NB_FRAMES) {
+            ret = av_frame_make_writable(frame);
+            if (ret < 0)
+                goto end;
+            for (int y = 0; y < HEIGHT; y++)
+                for (int x = 0; x < WIDTH; x++)
+                    frame->data[0][y * frame->linesize[0] + x] = x + y + i * 3;
+            for (int y = 0; y < HEIGHT / 2; y++)
+                for (int x = 0; x < WIDTH / 2; x++) {
+                    frame->data[1][y * frame->linesize[1] + x] = 128 + y + i * 2;
+                    frame->data[2][y * frame->linesize[2] + x] = 64 + x + i * 5;
+                }
+            frame->pts = i;
+        }
+
+        ret = avcodec_send_frame(ctx, i < NB_FRAMES ? frame : NULL);
+        if (ret < 0)
+            goto end;
+
+        while ((ret = avcodec_receive_packet(ctx, pkt)) >= 0) {
+            if (nb_packets >= FF_ARRAY_ELEMS(packets)) {
+                ret = AVERROR_BUG;
+                goto end;
+            }
+            packets[nb_packets++] = av_packet_clone(pkt);
+            av_packet_unref(pkt);
+            if (!packets[nb_packets - 1]) {
+                ret = AVERROR(ENOMEM);
+                goto end;
+            }
+        }
+        if (ret != AVERROR(EAGAIN) && ret != AVERROR_EOF)
+            goto end;
+    }
+    ret = 0;
+
+end:
+    av_packet_free(&pkt);
+    av_frame_free(&frame);
+    avcodec_free_context(&ctx);
+    return ret;
+}
+
+static int open_decoder(Decoder *dec, int threads, AVBufferRef *pool)
+{
+    const AVCodec *codec = avcodec_find_decoder(AV_CODEC_ID_MPEG4);
+    int ret;
+
+    if (!codec) {
+        av_log(NULL, AV_LOG_ERROR, "Can't find decoder\n");
+        return AVERROR_DECODER_NOT_FOUND;
+    }
+
+    dec->avctx = avcodec_alloc_context3(codec);
+    if (!dec->avctx)
+        return AVERROR(ENOMEM);
+
+    dec->avctx->thread_count = threads;
+    dec->avctx->thread_type  = FF_THREAD_FRAME;
+    dec->avctx->flags       |= AV_CODEC_FLAG_BITEXACT;
+    if (pool) {
+        dec->avctx->thread_pool = av_buffer_ref(pool);
+        if (!dec->avctx->thread_pool)
+            return AVERROR(ENOMEM);
+    }
+
+    ret = avcodec_open2(dec->avctx, codec, NULL);
+    if (ret < 0) {
+        av_log(dec->avctx, AV_LOG_ERROR, "Can't open decoder\n");
+        return ret;
+    }
+    if (threads > 1 && !(dec->avctx->active_thread_type & FF_THREAD_FRAME)) {
+        av_log(dec->avctx, AV_LOG_ERROR, "Frame threading not active\n");
+        return AVERROR_BUG;
+    }
+
+    return 0;
+}
+
+/* Send one packet, or flush with NULL, and check the frames it returns. */
+static int decode(Decoder *dec, const AVPacket *pkt, AVFrame *frame, int ref)
+{
+    int ret = avcodec_send_packet(dec->avctx, pkt);
+    if (ret < 0)
+        return ret;
+
+    while ((ret = avcodec_receive_frame(dec->avctx, frame)) >= 0) {
+        uint32_t checksum = frame_checksum(frame);
+
+        av_frame_unref(frame);
+        if (ref) {
+            if (nb_checksums >= FF_ARRAY_ELEMS(checksums))
+                return AVERROR_BUG;
+            checksums[nb_checksums++] = checksum;
+        } else if (dec->nb_frames >= nb_checksums ||
+                   checksums[dec->nb_frames] != checksum) {
+            av_log(dec->avctx, AV_LOG_ERROR, "Frame %d differs\n", dec->nb_frames);
+            return AVERROR_INVALIDDATA;
+        }
+        dec->nb_frames++;
+    }
+
+    return ret == AVERROR(EAGAIN) || ret == AVERROR_EOF ? 0 : ret;
+}
+
+static int decode_reference(AVFrame *frame)
+{
+    Decoder dec = { 0 };
+    int ret = open_decoder(&dec, 1, NULL);
+
+    for (int i = 0; ret >= 0 && i <= nb_packets; i++)
+        ret = decode(&dec, i < nb_packets ? packets[i] : NULL, frame, 1);
+
+    avcodec_free_context(&dec.avctx);
+    return ret;
+}
+
+static int decode_shared(int pool_threads, AVFrame *frame)
+{
+    Decoder dec[NB_DECODERS] = { 0 };
+    AVBufferRef *pool = av_codec_thread_pool_alloc(pool_threads);
+    int ret = pool ? 0 : AVERROR(ENOMEM);
+
+    for (int j = 0; ret >= 0 && j < NB_DECODERS; j++)
+        ret = open_decoder(&dec[j], FRAME_THREADS, pool);
+
+    /* a single caller feeding all the decoders in turn is the case where
+     * a job waiting on its caller would hold up the other decoders */
+    for (int i = 0; ret >= 0 && i <= nb_packets; i++)
+        for (int j = 0; ret >= 0 && j < NB_DECODERS; j++)
+            ret = decode(&dec[j], i < nb_packets ? packets[i] : NULL, frame, 0);
+
+    for (int j = 0; j < NB_DECODERS; j++) {
+        if (ret >= 0 && dec[j].nb_frames != nb_checksums) {
+            av_log(NULL, AV_LOG_ERROR, "Decoder %d returned %d of %d frames\n",
+                   j, dec[j].nb_frames, nb_checksums);
+            ret = AVERROR_INVALIDDATA;
+        }
+        avcodec_free_context(&dec[j].avctx);
+    }
+    av_buffer_unref(&pool);
+
+    return ret;
+}
+
+int main(void)
+{
+    static const int pool_threads[] = { 1, 2, NB_DECODERS * FRAME_THREADS };
+    AVFrame *frame = av_frame_alloc();
+    int ret = frame ? 0 : AVERROR(ENOMEM);
+
+    if (ret >= 0)
+        ret = encode();
+    if (ret >= 0)
+        ret = decode_reference(frame);
+    if (ret >= 0 && nb_checksums != NB_FRAMES) {
+        av_log(NULL, AV_LOG_ERROR, "Decoded %d of %d frames\n", nb_checksums, NB_FRAMES);
+        ret = AVERROR_INVALIDDATA;
+    }
+
+    for (int i = 0; ret >= 0 && i < FF_ARRAY_ELEMS(pool_threads); i++) {
+        ret = decode_shared(pool_threads[i], frame);
+        if (ret < 0)
+            av_log(NULL, AV_LOG_ERROR, "Failed with a pool of %d threads\n",
+                   pool_threads[i]);
+    }
+
+    for (int i = 0; i < nb_packets; i++)
+        av_packet_free(&packets[i]);
+    av_frame_free(&frame);
+
+    return ret < 0;
+}
@@ -33,8 +33,8 @@
             for (int i = 0; i < 16*18*2; i++)    \
                 src[i] = rnd() & 0x3;            \
         } else {                                 \
-            for (int i = 0; i < 16*18; i += 2)   \
-                AV_WN16(&src[i], rnd() & 0xFF);  \
+            for (int i = 0; i < 16*18*2; i += 2) \
+                AV_WN16(&src[i], rnd() & ((1 << bit_depth) - 1)); \
         }                                        \
     } while (0)
 
@@ -56,8 +56,8 @@ static void check_chroma_mc(void)
 #define CHECK_CHROMA_MC(name)                                                                         \
             do {                                                                                      \
                 if (check_func(h.name## _pixels_tab[size], #name "_mc%d_%d", 1 << size, bit_depth)) { \
-                    for (int x = 0; x < 2; x++) {                                                     \
-                        for (int y = 0; y < 2; y++) {                                                 \
+                    for (int x = 0; x < 8; x++) {                                                     \
+                        for (int y = 0; y < 8; y++) {                                                 \
                             memcpy(dst0, src, 16 * 18 * SIZEOF_PIXEL);                                \
                             memcpy(dst1, src, 16 * 18 * SIZEOF_PIXEL);                                \
                             call_ref(dst0, src, 16 * SIZEOF_PIXEL, 16, x, y);                         \
@@ -66,9 +66,9 @@ static void check_chroma_mc(void)
                                 fprintf(stderr, #name ": x:%i, y:%i\n", x, y);                        \
                                 fail();                                                               \
                             }                                                                         \
-                            bench_new(dst1, src, 16 * SIZEOF_PIXEL, 16, x, y);                        \
                         }                                                                             \
                     }                                                                                 \
+                    bench_new(dst1, src, 16 * SIZEOF_PIXEL, 16, 1, 1);                                \
                 }                                                                                     \
             } while (0)
 
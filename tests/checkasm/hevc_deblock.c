@@ -18,6 +18,7 @@
 
 #include <string.h>
 
+#include "libavutil/common.h"
 #include "libavutil/intreadwrite.h"
 #include "libavutil/mem_internal.h"
 
@@ -88,6 +89,89 @@ static void check_deblock_chroma(HEVCDSPContext *h, int bit_depth)
     }
 }
 
+#define LUMA_TYPES 3
+
+/* Fill the 8x8 block around a luma edge so that the different filter
+ * decisions are all taken: type 0 is nearly flat and mostly takes the
+ * strong filter, type 1 adds more noise for the normal filter and type 2
+ * is random, which mostly leaves the edge untouched. */
+static void randomize_luma_edge(uint8_t *pix, ptrdiff_t xstride, ptrdiff_t ystride,
+                                int bit_depth, int type)
+{
+    const int max = (1 << bit_depth) - 1;
+
+    for (int seg = 0; seg < 2; seg++) {
+        const int amp   = (type ? 12 : 1) << (bit_depth - 8);
+        const int step  = ((int)(rnd() % 81) - 40) * (1 << (bit_depth - 8));
+        const int base  = max / 4 + rnd() % (max / 2);
+        const int slope = (int)(rnd() % 5) - 2;
+
+        for (int d = 4 * seg; d < 4 * seg + 4; d++) {
+            for (int k = -4; k < 4; k++) {
+                uint8_t *p = pix + d * ystride + k * xstride;
+                int v = base + slope * k + (k >= 0 ? step : 0) +
+                        (int)(rnd() % (2 * amp + 1)) - amp;
+
+                if (type == 2)
+                    v = rnd() & max;
+                v = av_clip(v, 0, max);
+                if (bit_depth > 8)
+                    AV_WN16A(p, v);
+                else
+                    *p = v;
+            }
+        }
+    }
+}
+
+static void check_deblock_luma(HEVCDSPContext *h, int bit_depth)
+{
+    int32_t tc[2] = { 0, 0 };
+    uint8_t no_p[2] = { 0, 0 };
+    uint8_t no_q[2] = { 0, 0 };
+    LOCAL_ALIGNED_32(uint8_t, buf0, [BUF_SIZE]);
+    LOCAL_ALIGNED_32(uint8_t, buf1, [BUF_SIZE]);
+    const struct {
+        void (*func)(uint8_t *pix, ptrdiff_t stride, int beta, const int32_t *tc,
+                     const uint8_t *no_p, const uint8_t *no_q);
+        const char *name;
+        ptrdiff_t xstride, ystride, offset;
+    } tests[2] = {
+        { h->hevc_h_loop_filter_luma, "hevc_h_loop_filter_luma",
+          BUF_STRIDE, SIZEOF_PIXEL, BUF_OFFSET + 4 * BUF_STRIDE },
+        { h->hevc_v_loop_filter_luma, "hevc_v_loop_filter_luma",
+          SIZEOF_PIXEL, BUF_STRIDE, BUF_OFFSET + 4 * SIZEOF_PIXEL },
+    };
+
+    declare_func_emms(AV_CPU_FLAG_MMX, void, uint8_t *pix, ptrdiff_t stride, int beta,
+                      const int32_t *tc, const uint8_t *no_p, const uint8_t *no_q);
+
+    for (int t = 0; t < 2; t++) {
+        if (check_func(tests[t].func, "%s%d", tests[t].name, bit_depth)) {
+            for (int i = 0; i < 4 * LUMA_TYPES; i++) {
+                // see betatable[] and tctable[] in hevc_filter.c
+                int beta = rnd() % 65;
+                tc[0] = rnd() % 25;
+                tc[1] = rnd() % 25;
+
+                randomize_buffers(buf0, buf1, BUF_SIZE);
+                randomize_luma_edge(buf0 + tests[t].offset, tests[t].xstride,
+                                    tests[t].ystride, bit_depth, i % LUMA_TYPES);
+                memcpy(buf1, buf0, BUF_SIZE);
+
+                call_ref(buf0 + tests[t].offset, BUF_STRIDE, beta, tc, no_p, no_q);
+                call_new(buf1 + tests[t].offset, BUF_STRIDE, beta, tc, no_p, no_q);
+                if (memcmp(buf0, buf1, BUF_SIZE))
+                    fail();
+            }
+            tc[0] = tc[1] = 24;
+            randomize_luma_edge(buf1 + tests[t].offset, tests[t].xstride,
+                                tests[t].ystride, bit_depth, 0);
+            bench_new(buf1 + tests[t].offset, BUF_STRIDE, 64, tc, no_p, no_q);
+        }
+    }
+}
+
 void checkasm_check_hevc_deblock(void)
 {
     int bit_depth;
@@ -98,4 +182,11 @@ void checkasm_check_hevc_deblock(void)
         check_deblock_chroma(&h, bit_depth);
     }
     report("chroma");
+
+    for (bit_depth = 8; bit_depth <= 12; bit_depth += 2) {
+        HEVCDSPContext h;
+        ff_hevc_dsp_init(&h, bit_depth);
+        check_deblock_luma(&h, bit_depth);
+    }
+    report("luma");
 }
@@ -28,7 +28,7 @@
 
 static const uint32_t pixel_mask[] = { 0xffffffff, 0x01ff01ff, 0x03ff03ff, 0x07ff07ff, 0x0fff0fff };
 static const uint32_t pixel_mask16[] = { 0x00ff00ff, 0x01ff01ff, 0x03ff03ff, 0x07ff07ff, 0x0fff0fff };
-static const int sizes[] = { -1, 4, 6, 8, 12, 16, 24, 32, 48, 64 };
+static const int sizes[] = { 2, 4, 6, 8, 12, 16, 24, 32, 48, 64 };
 static const int weights[] = { 0, 128, 255, -1 };
 static const int denoms[] = {0, 7, 12, -1 };
 static const int offsets[] = {0, 255, -1 };
@@ -87,7 +87,7 @@ static void checkasm_check_hevc_qpel(void)
 
         for (i = 0; i < 2; i++) {
             for (j = 0; j < 2; j++) {
-                for (size = 1; size < 10; size++) {
+                for (size = 0; size < 10; size++) {
                     const char *type;
                     switch ((j << 1) | i) {
                     case 0: type = "pel_pixels"; break; // 0 0
@@ -131,7 +131,7 @@ static void checkasm_check_hevc_qpel_uni(void)
 
         for (i = 0; i < 2; i++) {
             for (j = 0; j < 2; j++) {
-                for (size = 1; size < 10; size++) {
+                for (size = 0; size < 10; size++) {
                     const char *type;
                     switch ((j << 1) | i) {
                     case 0: type = "pel_uni_pixels"; break; // 0 0
@@ -173,7 +173,7 @@ static void checkasm_check_hevc_qpel_uni_w(void)
 
         for (i = 0; i < 2; i++) {
             for (j = 0; j < 2; j++) {
-                for (size = 1; size < 10; size++) {
+                for (size = 0; size < 10; size++) {
                     const char *type;
                     switch ((j << 1) | i) {
                     case 0: type = "pel_uni_w_pixels"; break; // 0 0
@@ -223,7 +223,7 @@ static void checkasm_check_hevc_qpel_bi(void)
 
         for (i = 0; i < 2; i++) {
             for (j = 0; j < 2; j++) {
-                for (size = 1; size < 10; size++) {
+                for (size = 0; size < 10; size++) {
                     const char *type;
                     switch ((j << 1) | i) {
                     case 0: type = "pel_bi_pixels"; break; // 0 0
@@ -269,7 +269,7 @@ static void checkasm_check_hevc_qpel_bi_w(void)
 
         for (i = 0; i < 2; i++) {
             for (j = 0; j < 2; j++) {
-                for (size = 1; size < 10; size++) {
+                for (size = 0; size < 10; size++) {
                     const char *type;
                     switch ((j << 1) | i) {
                     case 0: type = "pel_bi_w_pixels"; break; // 0 0
@@ -319,7 +319,7 @@ static void checkasm_check_hevc_epel(void)
 
         for (i = 0; i < 2; i++) {
             for (j = 0; j < 2; j++) {
-                for (size = 1; size < 10; size++) {
+                for (size = 0; size < 10; size++) {
                     const char *type;
                     switch ((j << 1) | i) {
                     case 0: type = "pel_pixels"; break; // 0 0
@@ -363,7 +363,7 @@ static void checkasm_check_hevc_epel_uni(void)
 
         for (i = 0; i < 2; i++) {
             for (j = 0; j < 2; j++) {
-                for (size = 1; size < 10; size++) {
+                for (size = 0; size < 10; size++) {
                     const char *type;
                     switch ((j << 1) | i) {
                     case 0: type = "pel_uni_pixels"; break; // 0 0
@@ -405,7 +405,7 @@ static void checkasm_check_hevc_epel_uni_w(void)
 
         for (i = 0; i < 2; i++) {
             for (j = 0; j < 2; j++) {
-                for (size = 1; size < 10; size++) {
+                for (size = 0; size < 10; size++) {
                     const char *type;
                     switch ((j << 1) | i) {
                     case 0: type = "pel_uni_w_pixels"; break; // 0 0
@@ -455,7 +455,7 @@ static void checkasm_check_hevc_epel_bi(void)
 
         for (i = 0; i < 2; i++) {
             for (j = 0; j < 2; j++) {
-                for (size = 1; size < 10; size++) {
+                for (size = 0; size < 10; size++) {
                     const char *type;
                     switch ((j << 1) | i) {
                     case 0: type = "pel_bi_pixels"; break; // 0 0
@@ -501,7 +501,7 @@ static void checkasm_check_hevc_epel_bi_w(void)
 
         for (i = 0; i < 2; i++) {
             for (j = 0; j < 2; j++) {
-                for (size = 1; size < 10; size++) {
+                for (size = 0; size < 10; size++) {
                     const char *type;
                     switch ((j << 1) | i) {
                     case 0: type = "pel_bi_w_pixels"; break; // 0 0
@@ -0,0 +1,138 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <string.h>
+
+#include "libavutil/intreadwrite.h"
+#include "libavutil/mem_internal.h"
+
+#include "libavcodec/hevcpred.h"
+
+#include "checkasm.h"
+
+static const uint32_t pixel_mask[3] = { 0xffffffff, 0x03ff03ff, 0x0fff0fff };
+
+#define SIZEOF_PIXEL ((bit_depth + 7) / 8)
+// the stride is passed in pixels
+#define BUF_STRIDE (32 * 2)
+#define BUF_SIZE (BUF_STRIDE * 32 * SIZEOF_PIXEL)
+#define BUF_SIZE_MAX (BUF_STRIDE * 32 * 2)
+// top and left hold 2 * size + 1 samples starting at index -1
+#define REF_SIZE ((2 * 32 + 4) * 2)
+
+#define randomize_buffers(buf, size)                        \
+    do {                                                    \
+        uint32_t mask = pixel_mask[(bit_depth - 8) >> 1];   \
+        int k;                                              \
+        for (k = 0; k < size; k += 4)                       \
+            AV_WN32A(buf + k, rnd() & mask);                \
+    } while (0)
+
+static void check_pred_planar(HEVCPredContext *h, uint8_t *dst0, uint8_t *dst1,
+                              const uint8_t *top, const uint8_t *left, int bit_depth)
+{
+    declare_func(void, uint8_t *src, const uint8_t *top,
+                 const uint8_t *left, ptrdiff_t stride);
+
+    for (int i = 0; i < 4; i++) {
+        if (check_func(h->pred_planar[i], "hevc_pred_planar_%dx%d_%d",
+                       4 << i, 4 << i, bit_depth)) {
+            memset(dst0, 0, BUF_SIZE);
+            memset(dst1, 0, BUF_SIZE);
+            call_ref(dst0, top, left, BUF_STRIDE);
+            call_new(dst1, top, left, BUF_STRIDE);
+            if (memcmp(dst0, dst1, BUF_SIZE))
+                fail();
+            bench_new(dst1, top, left, BUF_STRIDE);
+        }
+    }
+}
+
+static void check_pred_dc(HEVCPredContext *h, uint8_t *dst0, uint8_t *dst1,
+                          const uint8_t *top, const uint8_t *left, int bit_depth)
+{
+    declare_func(void, uint8_t *src, const uint8_t *top, const uint8_t *left,
+                 ptrdiff_t stride, int log2_size, int c_idx);
+
+    for (int log2_size = 2; log2_size <= 5; log2_size++) {
+        for (int c_idx = 0; c_idx < 2; c_idx++) {
+            if (check_func(h->pred_dc, "hevc_pred_dc_%dx%d_%s_%d", 1 << log2_size,
+                           1 << log2_size, c_idx ? "chroma" : "luma", bit_depth)) {
+                memset(dst0, 0, BUF_SIZE);
+                memset(dst1, 0, BUF_SIZE);
+                call_ref(dst0, top, left, BUF_STRIDE, log2_size, c_idx);
+                call_new(dst1, top, left, BUF_STRIDE, log2_size, c_idx);
+                if (memcmp(dst0, dst1, BUF_SIZE))
+                    fail();
+                bench_new(dst1, top, left, BUF_STRIDE, log2_size, c_idx);
+            }
+        }
+    }
+}
+
+static void check_pred_angular(HEVCPredContext *h, uint8_t *dst0, uint8_t *dst1,
+                               const uint8_t *top, const uint8_t *left, int bit_depth)
+{
+    declare_func(void, uint8_t *src, const uint8_t *top, const uint8_t *left,
+                 ptrdiff_t stride, int c_idx, int mode);
+
+    for (int i = 0; i < 4; i++) {
+        for (int c_idx = 0; c_idx < 2; c_idx++) {
+            if (check_func(h->pred_angular[i], "hevc_pred_angular_%dx%d_%s_%d", 4 << i,
+                           4 << i, c_idx ? "chroma" : "luma", bit_depth)) {
+                // modes 0 and 1 are planar and DC
+                for (int mode = 2; mode < 35; mode++) {
+                    memset(dst0, 0, BUF_SIZE);
+                    memset(dst1, 0, BUF_SIZE);
+                    call_ref(dst0, top, left, BUF_STRIDE, c_idx, mode);
+                    call_new(dst1, top, left, BUF_STRIDE, c_idx, mode);
+                    if (memcmp(dst0, dst1, BUF_SIZE))
+                        fail();
+                }
+                // 10 and 26 take the edge filter, 18 is the pure diagonal
+                bench_new(dst1, top, left, BUF_STRIDE, c_idx, 22);
+            }
+        }
+    }
+}
+
+void checkasm_check_hevc_pred(void)
+{
+    LOCAL_ALIGNED_32(uint8_t, dst0, [BUF_SIZE_MAX]);
+    LOCAL_ALIGNED_32(uint8_t, dst1, [BUF_SIZE_MAX]);
+    LOCAL_ALIGNED_32(uint8_t, top,  [REF_SIZE]);
+    LOCAL_ALIGNED_32(uint8_t, left, [REF_SIZE]);
+    int bit_depth;
+
+    for (bit_depth = 8; bit_depth <= 12; bit_depth += 2) {
+        HEVCPredContext h;
+        // index -1 of both references is the shared corner sample
+        uint8_t *t = top  + 4 * SIZEOF_PIXEL;
+        uint8_t *l = left + 4 * SIZEOF_PIXEL;
+
+        ff_hevc_pred_init(&h, bit_depth);
+        randomize_buffers(top, REF_SIZE);
+        randomize_buffers(left, REF_SIZE);
+        memcpy(l - SIZEOF_PIXEL, t - SIZEOF_PIXEL, SIZEOF_PIXEL);
+
+        check_pred_planar(&h, dst0, dst1, t, l, bit_depth);
+        check_pred_dc(&h, dst0, dst1, t, l, bit_depth);
+        check_pred_angular(&h, dst0, dst1, t, l, bit_depth);
+    }
+    report("pred");
+}
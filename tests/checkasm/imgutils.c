@@ -0,0 +1,97 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+#include <string.h>
+#include "checkasm.h"
+#include "libavutil/cpu.h"
+#include "libavutil/imgutils.h"
+#include "libavutil/imgutils_internal.h"
+#include "libavutil/mem_internal.h"
+
+#if ARCH_AARCH64
+#include "libavutil/aarch64/cpu.h"
+#endif
+
+#define WIDTH  256
+#define HEIGHT 8
+#define STRIDE (WIDTH + 64)
+
+#define randomize_buffers(buf, size)      \
+    do {                                  \
+        int j;                            \
+        uint8_t *tmp_buf = (uint8_t *)buf;\
+        for (j = 0; j < size; j++)        \
+            tmp_buf[j] = rnd() & 0xFF;    \
+    } while (0)
+
+typedef void (*copy_plane_func)(uint8_t *dst, ptrdiff_t dst_linesize,
+                                const uint8_t *src, ptrdiff_t src_linesize,
+                                ptrdiff_t bytewidth, int height);
+
+static void image_copy_plane_c(uint8_t *dst, ptrdiff_t dst_linesize,
+                               const uint8_t *src, ptrdiff_t src_linesize,
+                               ptrdiff_t bytewidth, int height)
+{
+    av_image_copy_plane(dst, dst_linesize, src, src_linesize,
+                        bytewidth, height);
+}
+
+static copy_plane_func get_copy_plane_uc_from(void)
+{
+#if ARCH_AARCH64
+    if (have_neon(av_get_cpu_flags()))
+        return ff_image_copy_plane_uc_from_neon;
+#endif
+    return image_copy_plane_c;
+}
+
+static void check_copy_plane_uc_from(void)
+{
+    LOCAL_ALIGNED_32(uint8_t, src,     [STRIDE * HEIGHT]);
+    LOCAL_ALIGNED_32(uint8_t, dst_ref, [STRIDE * HEIGHT]);
+    LOCAL_ALIGNED_32(uint8_t, dst_new, [STRIDE * HEIGHT]);
+    static const int widths[] = { 1, 15, 16, 17, 63, 64, 65, 127, 200, WIDTH };
+
+    declare_func(void, uint8_t *dst, ptrdiff_t dst_linesize,
+                 const uint8_t *src, ptrdiff_t src_linesize,
+                 ptrdiff_t bytewidth, int height);
+
+    randomize_buffers(src, STRIDE * HEIGHT);
+
+    if (check_func(get_copy_plane_uc_from(), "image_copy_plane_uc_from")) {
+        for (int i = 0; i < FF_ARRAY_ELEMS(widths); i++) {
+            int w = widths[i];
+            // Exercise both tightly packed and padded, unaligned rows.
+            ptrdiff_t src_linesize = i & 1 ? STRIDE : FFALIGN(w, 16);
+            ptrdiff_t dst_linesize = i & 2 ? STRIDE : w;
+
+            memset(dst_ref, 0, STRIDE * HEIGHT);
+            memset(dst_new, 0, STRIDE * HEIGHT);
+            call_ref(dst_ref, dst_linesize, src + (i & 1), src_linesize, w, HEIGHT);
+            call_new(dst_new, dst_linesize, src + (i & 1), src_linesize, w, HEIGHT);
+            if (memcmp(dst_ref, dst_new, STRIDE * HEIGHT))
+                fail();
+        }
+        bench_new(dst_new, STRIDE, src, STRIDE, WIDTH, HEIGHT);
+    }
+}
+
+void checkasm_check_imgutils(void)
+{
+    check_copy_plane_uc_from();
+    report("image_copy_plane_uc_from");
+}
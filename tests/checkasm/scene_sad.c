@@ -0,0 +1,63 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "checkasm.h"
+#include "libavfilter/scene_sad.h"
+#include "libavutil/mem_internal.h"
+
+#define WIDTH  256
+#define HEIGHT 16
+
+static void check_scene_sad(int depth)
+{
+    LOCAL_ALIGNED_16(uint8_t, src1, [WIDTH * 2 * HEIGHT]);
+    LOCAL_ALIGNED_16(uint8_t, src2, [WIDTH * 2 * HEIGHT]);
+    static const int widths[] = { WIDTH, WIDTH - 1, 35, 7 };
+    const int bytes    = depth / 8;
+    const int linesize = WIDTH * bytes;
+    ff_scene_sad_fn sad = ff_scene_sad_get_fn(depth);
+
+    declare_func(void, const uint8_t *src1, ptrdiff_t stride1,
+                 const uint8_t *src2, ptrdiff_t stride2,
+                 ptrdiff_t width, ptrdiff_t height, uint64_t *sum);
+
+    if (check_func(sad, "scene_sad%d", depth)) {
+        for (int i = 0; i < FF_ARRAY_ELEMS(widths); i++) {
+            uint64_t sum_ref = 0, sum_new = 1;
+
+            for (int j = 0; j < WIDTH * 2 * HEIGHT; j++) {
+                src1[j] = rnd();
+                src2[j] = rnd();
+            }
+            call_ref(src1, linesize, src2, linesize, widths[i], HEIGHT, &sum_ref);
+            call_new(src1, linesize, src2, linesize, widths[i], HEIGHT, &sum_new);
+            if (sum_ref != sum_new)
+                fail();
+        }
+        bench_new(src1, linesize, src2, linesize, WIDTH, HEIGHT, &(uint64_t){ 0 });
+    }
+}
+
+void checkasm_check_scene_sad(void)
+{
+    check_scene_sad(8);
+    report("scene_sad8");
+
+    check_scene_sad(16);
+    report("scene_sad16");
+}
@@ -136,7 +136,8 @@ void checkasm_check_blend(void)
     check_and_report(or_16, BLEND_OR, 2)
     check_and_report(phoenix_16, BLEND_PHOENIX, 2)
     check_and_report(subtract_16, BLEND_SUBTRACT, 2)
-    check_and_report(xor_16, BLEND_SUBTRACT, 2)
+    check_and_report(xor_16, BLEND_XOR, 2)
+    check_and_report(hardmix_16, BLEND_HARDMIX, 2)
 
     report("16bit");
 
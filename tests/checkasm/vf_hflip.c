@@ -51,11 +51,9 @@ static void check_hflip(int step, const char * report_name){
     memset(dst_new, 0, WIDTH_PADDED);
     randomize_buffers(src, WIDTH_PADDED);
 
-    if (step == 2) {
-        w /= 2;
-        for (i = 0; i < 4; i++)
-            step_array[i] = step;
-    }
+    w /= step;
+    for (i = 0; i < 4; i++)
+        step_array[i] = step;
 
     ff_hflip_init(&s, step_array, 4);
 
@@ -76,4 +74,16 @@ void checkasm_check_vf_hflip(void)
 
     check_hflip(2, "short");
     report("hflip_short");
+
+    check_hflip(3, "b24");
+    report("hflip_b24");
+
+    check_hflip(4, "dword");
+    report("hflip_dword");
+
+    check_hflip(6, "b48");
+    report("hflip_b48");
+
+    check_hflip(8, "qword");
+    report("hflip_qword");
 }
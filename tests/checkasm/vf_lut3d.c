@@ -0,0 +1,148 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <string.h>
+#include "checkasm.h"
+#include "libavfilter/lut3d.h"
+#include "libavutil/frame.h"
+#include "libavutil/mem.h"
+
+#define WIDTH   67
+#define HEIGHT  4
+#define LUTSIZE 17
+
+static void randomize_frame(AVFrame *frame, const AVPixFmtDescriptor *desc)
+{
+    for (int p = 0; p < desc->nb_components; p++) {
+        for (int y = 0; y < frame->height; y++) {
+            uint8_t *row = frame->data[p] + y * frame->linesize[p];
+
+            for (int x = 0; x < frame->width; x++) {
+                if (desc->flags & AV_PIX_FMT_FLAG_FLOAT)
+                    ((float *)row)[x] = (int)(rnd() % 1200) / 1000.0f - 0.1f;
+                else if (desc->comp[0].depth > 8)
+                    ((uint16_t *)row)[x] = rnd() & ((1 << desc->comp[0].depth) - 1);
+                else
+                    row[x] = rnd();
+            }
+        }
+    }
+}
+
+/* The SIMD versions may round the last bit differently: allow integer
+ * samples to differ by one and float samples by a small epsilon. */
+static int frames_differ(const AVFrame *a, const AVFrame *b,
+                         const AVPixFmtDescriptor *desc)
+{
+    for (int p = 0; p < desc->nb_components; p++) {
+        for (int y = 0; y < a->height; y++) {
+            const uint8_t *ra = a->data[p] + y * a->linesize[p];
+            const uint8_t *rb = b->data[p] + y * b->linesize[p];
+
+            for (int x = 0; x < a->width; x++) {
+                if (desc->flags & AV_PIX_FMT_FLAG_FLOAT) {
+                    if (!float_near_abs_eps(((const float *)ra)[x],
+                                            ((const float *)rb)[x], 1e-5f))
+                        return 1;
+                } else if (desc->comp[0].depth > 8) {
+                    if (abs(((const uint16_t *)ra)[x] - ((const uint16_t *)rb)[x]) > 1)
+                        return 1;
+                } else if (abs(ra[x] - rb[x]) > 1) {
+                    return 1;
+                }
+            }
+        }
+    }
+    return 0;
+}
+
+static void check_lut3d(enum AVPixelFormat format)
+{
+    const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(format);
+    AVFilterLink link = { .format = format };
+    AVFilterLink *inputs[1] = { &link };
+    LUT3DContext s = { 0 };
+    AVFilterContext ctx = { .priv = &s, .inputs = inputs, .nb_inputs = 1 };
+    AVFrame *in      = av_frame_alloc();
+    AVFrame *out_ref = av_frame_alloc();
+    AVFrame *out_new = av_frame_alloc();
+    ThreadData td_ref = { in, out_ref }, td_new = { in, out_new };
+
+    declare_func(int, AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs);
+
+    s.lutsize  = LUTSIZE;
+    s.lutsize2 = LUTSIZE * LUTSIZE;
+    s.scale    = (struct rgbvec){ 1.0f, 1.0f, 1.0f };
+    s.interpolation = INTERPOLATE_TETRAHEDRAL;
+    /* one spare entry, as allocated by the filter */
+    s.lut = av_malloc_array(LUTSIZE * LUTSIZE * LUTSIZE + 1, sizeof(*s.lut));
+    if (!in || !out_ref || !out_new || !s.lut)
+        goto end;
+
+    for (int i = 0; i < LUTSIZE * LUTSIZE * LUTSIZE + 1; i++)
+        s.lut[i] = (struct rgbvec){ (rnd() % 1000) / 999.0f,
+                                    (rnd() % 1000) / 999.0f,
+                                    (rnd() % 1000) / 999.0f };
+
+    for (int i = 0; i < 3; i++) {
+        AVFrame *frame = i == 0 ? in : i == 1 ? out_ref : out_new;
+
+        frame->format = format;
+        frame->width  = WIDTH;
+        frame->height = HEIGHT;
+        if (av_frame_get_buffer(frame, 0) < 0)
+            goto end;
+    }
+
+    ff_lut3d_init(&s, desc);
+
+    if (check_func(s.interp, "tetrahedral_%s", desc->name)) {
+        randomize_frame(in, desc);
+        for (int p = 0; p < 4 && out_ref->buf[p]; p++) {
+            memset(out_ref->buf[p]->data, 0, out_ref->buf[p]->size);
+            memset(out_new->buf[p]->data, 0, out_new->buf[p]->size);
+        }
+
+        call_ref(&ctx, &td_ref, 0, 1);
+        call_new(&ctx, &td_new, 0, 1);
+        if (frames_differ(out_ref, out_new, desc))
+            fail();
+
+        bench_new(&ctx, &td_new, 0, 1);
+    }
+
+end:
+    av_frame_free(&in);
+    av_frame_free(&out_ref);
+    av_frame_free(&out_new);
+    av_freep(&s.lut);
+}
+
+void checkasm_check_vf_lut3d(void)
+{
+    static const enum AVPixelFormat formats[] = {
+        AV_PIX_FMT_GBRP,   AV_PIX_FMT_GBRAP,
+        AV_PIX_FMT_GBRP10, AV_PIX_FMT_GBRP12,
+        AV_PIX_FMT_GBRP16, AV_PIX_FMT_GBRAP16,
+        AV_PIX_FMT_GBRPF32, AV_PIX_FMT_GBRAPF32,
+    };
+
+    for (int i = 0; i < FF_ARRAY_ELEMS(formats); i++)
+        check_lut3d(formats[i]);
+    report("tetrahedral");
+}
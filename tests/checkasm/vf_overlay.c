@@ -0,0 +1,116 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <string.h>
+#include "checkasm.h"
+#include "libavfilter/vf_overlay.h"
+#include "libavutil/mem_internal.h"
+
+#define WIDTH 256
+#define ALINESIZE (2 * WIDTH)
+
+#define FAST_DIV255(x) ((((x) + 128) * 257) >> 16)
+
+/* The C code blends inline rather than through blend_row, so the
+ * references below follow blend_plane() for 8-bit straight alpha. */
+static int overlay_row_44_c(uint8_t *d, uint8_t *da, uint8_t *s, uint8_t *a,
+                            int w, ptrdiff_t alinesize)
+{
+    for (int x = 0; x < w; x++)
+        d[x] = FAST_DIV255(d[x] * (255 - a[x]) + s[x] * a[x]);
+    return w;
+}
+
+static int overlay_row_22_c(uint8_t *d, uint8_t *da, uint8_t *s, uint8_t *a,
+                            int w, ptrdiff_t alinesize)
+{
+    for (int x = 0; x < w - 1; x++) {
+        int alpha = (a[2 * x] + ((a[2 * x] + a[2 * x + 1]) >> 1)) >> 1;
+        d[x] = FAST_DIV255(d[x] * (255 - alpha) + s[x] * alpha);
+    }
+    return w - 1;
+}
+
+static int overlay_row_20_c(uint8_t *d, uint8_t *da, uint8_t *s, uint8_t *a,
+                            int w, ptrdiff_t alinesize)
+{
+    for (int x = 0; x < w - 1; x++) {
+        int alpha = (a[2 * x] + a[2 * x + 1] +
+                     a[alinesize + 2 * x] + a[alinesize + 2 * x + 1]) >> 2;
+        d[x] = FAST_DIV255(d[x] * (255 - alpha) + s[x] * alpha);
+    }
+    return w - 1;
+}
+
+static void check_overlay_row(const char *name, int format, int pix_format,
+                              int plane,
+                              int (*ref)(uint8_t *d, uint8_t *da, uint8_t *s,
+                                         uint8_t *a, int w, ptrdiff_t alinesize))
+{
+    LOCAL_ALIGNED_16(uint8_t, d_ref, [WIDTH]);
+    LOCAL_ALIGNED_16(uint8_t, d_new, [WIDTH]);
+    LOCAL_ALIGNED_16(uint8_t, d_old, [WIDTH]);
+    LOCAL_ALIGNED_16(uint8_t, src,   [WIDTH]);
+    LOCAL_ALIGNED_16(uint8_t, alpha, [2 * ALINESIZE]);
+    static const int widths[] = { WIDTH, WIDTH - 3, 17 };
+    OverlayContext s = { 0 };
+    int (*blend_row)(uint8_t *d, uint8_t *da, uint8_t *s, uint8_t *a,
+                     int w, ptrdiff_t alinesize);
+
+    declare_func(int, uint8_t *d, uint8_t *da, uint8_t *s, uint8_t *a,
+                 int w, ptrdiff_t alinesize);
+
+    ff_overlay_init_blend_row(&s, format, pix_format, 0, 0);
+    blend_row = s.blend_row[plane] ? s.blend_row[plane] : ref;
+
+    if (check_func(blend_row, "%s", name)) {
+        for (int i = 0; i < FF_ARRAY_ELEMS(widths); i++) {
+            int n_ref, n_new;
+
+            for (int j = 0; j < WIDTH; j++) {
+                d_old[j] = d_ref[j] = d_new[j] = rnd();
+                src[j] = rnd();
+            }
+            /* Favour fully transparent and opaque pixels. */
+            for (int j = 0; j < 2 * ALINESIZE; j++) {
+                int r = rnd();
+                alpha[j] = r & 0x300 ? r : r & 0x400 ? 255 : 0;
+            }
+
+            n_ref = call_ref(d_ref, NULL, src, alpha, widths[i], ALINESIZE);
+            n_new = call_new(d_new, NULL, src, alpha, widths[i], ALINESIZE);
+            /* SIMD versions may leave a tail for the C code. */
+            if (n_new < 0 || n_new > n_ref ||
+                memcmp(d_ref, d_new, n_new) ||
+                memcmp(d_old + n_new, d_new + n_new, WIDTH - n_new))
+                fail();
+        }
+        bench_new(d_new, NULL, src, alpha, WIDTH, ALINESIZE);
+    }
+}
+
+void checkasm_check_vf_overlay(void)
+{
+    check_overlay_row("overlay_row_44", OVERLAY_FORMAT_YUV444, AV_PIX_FMT_YUV444P,
+                      0, overlay_row_44_c);
+    check_overlay_row("overlay_row_22", OVERLAY_FORMAT_YUV422, AV_PIX_FMT_YUV422P,
+                      1, overlay_row_22_c);
+    check_overlay_row("overlay_row_20", OVERLAY_FORMAT_YUV420, AV_PIX_FMT_YUV420P,
+                      1, overlay_row_20_c);
+    report("overlay_row");
+}
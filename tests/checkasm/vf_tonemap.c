@@ -0,0 +1,93 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "checkasm.h"
+#include "libavfilter/tonemapdsp.h"
+#include "libavutil/mem_internal.h"
+
+#define WIDTH 256
+#define PEAK  10.0f
+
+static const char *const algo_names[TONEMAP_MAX] = {
+    [TONEMAP_NONE]     = "none",
+    [TONEMAP_LINEAR]   = "linear",
+    [TONEMAP_GAMMA]    = "gamma",
+    [TONEMAP_CLIP]     = "clip",
+    [TONEMAP_REINHARD] = "reinhard",
+    [TONEMAP_HABLE]    = "hable",
+    [TONEMAP_MOBIUS]   = "mobius",
+};
+
+static const float default_params[TONEMAP_MAX] = {
+    [TONEMAP_NONE]     = 1.0f,
+    [TONEMAP_LINEAR]   = 1.0f,
+    [TONEMAP_GAMMA]    = 1.8f,
+    [TONEMAP_CLIP]     = 1.0f,
+    [TONEMAP_REINHARD] = 1.0f,
+    [TONEMAP_HABLE]    = 1.0f,
+    [TONEMAP_MOBIUS]   = 0.3f,
+};
+
+void checkasm_check_vf_tonemap(void)
+{
+    LOCAL_ALIGNED_16(float, src, [3 * WIDTH]);
+    LOCAL_ALIGNED_16(float, dst_ref, [3 * WIDTH]);
+    LOCAL_ALIGNED_16(float, dst_new, [3 * WIDTH]);
+    static const float coeffs[3] = { 0.2627f, 0.6780f, 0.0593f };
+    static const float desats[] = { 0.0f, 2.0f };
+    static const int widths[] = { WIDTH, WIDTH - 3, 5 };
+    TonemapDSPContext dsp;
+
+    declare_func(void, float *dst[3], const float *src[3], int w,
+                 const TonemapParams *p);
+
+    ff_tonemapdsp_init(&dsp);
+
+    for (int algo = 0; algo < TONEMAP_MAX; algo++) {
+        for (int d = 0; d < FF_ARRAY_ELEMS(desats); d++) {
+            if (check_func(dsp.tonemap_row[algo], "tonemap_row_%s%s",
+                           algo_names[algo], desats[d] > 0 ? "_desat" : "")) {
+                const float *srcp[3] = { src, src + WIDTH, src + 2 * WIDTH };
+                float *dstp_ref[3] = { dst_ref, dst_ref + WIDTH, dst_ref + 2 * WIDTH };
+                float *dstp_new[3] = { dst_new, dst_new + WIDTH, dst_new + 2 * WIDTH };
+                TonemapParams p;
+
+                ff_tonemap_init_params(&p, algo, default_params[algo], PEAK,
+                                       desats[d], coeffs);
+
+                for (int i = 0; i < FF_ARRAY_ELEMS(widths); i++) {
+                    int w = widths[i];
+
+                    for (int x = 0; x < 3 * WIDTH; x++)
+                        src[x] = (rnd() & 0xFFFFFF) * (1.2f * PEAK / 0xFFFFFF);
+
+                    call_ref(dstp_ref, srcp, w, &p);
+                    call_new(dstp_new, srcp, w, &p);
+                    for (int c = 0; c < 3; c++) {
+                        if (!float_near_abs_eps_array(dstp_ref[c], dstp_new[c], 1e-5f, w)) {
+                            fail();
+                            break;
+                        }
+                    }
+                }
+                bench_new(dstp_new, srcp, WIDTH, &p);
+            }
+        }
+    }
+    report("tonemap_row");
+}
@@ -0,0 +1,72 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <string.h>
+#include "checkasm.h"
+#include "libavfilter/transpose.h"
+#include "libavutil/intreadwrite.h"
+#include "libavutil/mem_internal.h"
+
+#define MAX_STEP 8
+#define LINESIZE (8 * MAX_STEP + 16)
+#define BUF_SIZE (8 * LINESIZE)
+
+static void check_transpose(int pixstep)
+{
+    LOCAL_ALIGNED_16(uint8_t, src,     [BUF_SIZE]);
+    LOCAL_ALIGNED_16(uint8_t, dst_ref, [BUF_SIZE]);
+    LOCAL_ALIGNED_16(uint8_t, dst_new, [BUF_SIZE]);
+    TransVtable v;
+
+    declare_func(void, uint8_t *src, ptrdiff_t src_linesize,
+                 uint8_t *dst, ptrdiff_t dst_linesize);
+
+    ff_transpose_init(&v, pixstep);
+
+    if (check_func(v.transpose_8x8, "transpose_8x8_%d", pixstep * 8)) {
+        for (int dir = 0; dir < 4; dir++) {
+            /* The filter walks the source and/or the destination
+             * bottom-up depending on the direction. */
+            ptrdiff_t src_linesize = dir & 1 ? -LINESIZE : LINESIZE;
+            ptrdiff_t dst_linesize = dir & 2 ? -LINESIZE : LINESIZE;
+            uint8_t *s  = dir & 1 ? src     + 7 * LINESIZE : src;
+            uint8_t *d0 = dir & 2 ? dst_ref + 7 * LINESIZE : dst_ref;
+            uint8_t *d1 = dir & 2 ? dst_new + 7 * LINESIZE : dst_new;
+
+            for (int i = 0; i < BUF_SIZE; i += 4)
+                AV_WN32A(src + i, rnd());
+            memset(dst_ref, 0, BUF_SIZE);
+            memset(dst_new, 0, BUF_SIZE);
+
+            call_ref(s, src_linesize, d0, dst_linesize);
+            call_new(s, src_linesize, d1, dst_linesize);
+            if (memcmp(dst_ref, dst_new, BUF_SIZE))
+                fail();
+        }
+        bench_new(src, LINESIZE, dst_new, LINESIZE);
+    }
+}
+
+void checkasm_check_vf_transpose(void)
+{
+    static const int pixsteps[] = { 1, 2, 3, 4, 6, 8 };
+
+    for (int i = 0; i < FF_ARRAY_ELEMS(pixsteps); i++)
+        check_transpose(pixsteps[i]);
+    report("transpose_8x8");
+}
@@ -0,0 +1,95 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <string.h>
+#include "checkasm.h"
+#include "libavfilter/yadif.h"
+#include "libavutil/mem_internal.h"
+
+#define WIDTH 256
+#define MAX_ALIGN 8
+
+#define randomize_buffers(buf0, buf1, mask, count) \
+    for (size_t i = 0; i < count; i++) \
+        buf0[i] = buf1[i] = rnd() & mask
+
+#define BODY(type, depth)                                                      \
+    do {                                                                       \
+        LOCAL_ALIGNED_16(type, prev0, [5*WIDTH]);                              \
+        LOCAL_ALIGNED_16(type, prev1, [5*WIDTH]);                              \
+        LOCAL_ALIGNED_16(type, next0, [5*WIDTH]);                              \
+        LOCAL_ALIGNED_16(type, next1, [5*WIDTH]);                              \
+        LOCAL_ALIGNED_16(type, cur0,  [5*WIDTH]);                              \
+        LOCAL_ALIGNED_16(type, cur1,  [5*WIDTH]);                              \
+        LOCAL_ALIGNED_16(type, dst0,  [WIDTH]);                                \
+        LOCAL_ALIGNED_16(type, dst1,  [WIDTH]);                                \
+        const int stride = WIDTH * sizeof(type);                               \
+        const int mask = (1 << depth) - 1;                                     \
+        /* filter_slice() leaves 3 pixels on the left and MAX_ALIGN / df - 1   \
+         * on the right to filter_edges(), which rewrites them. */             \
+        const int w = WIDTH - (3 + MAX_ALIGN / sizeof(type) - 1);              \
+                                                                               \
+        declare_func(void, void *dst, void *prev, void *cur, void *next,       \
+                     int w, int prefs, int mrefs, int parity, int mode);       \
+                                                                               \
+        for (int parity = 0; parity < 2; parity++) {                           \
+            for (int mode = 0; mode < 4; mode++) {                             \
+                randomize_buffers(prev0, prev1, mask, 5*WIDTH);                \
+                randomize_buffers(next0, next1, mask, 5*WIDTH);                \
+                randomize_buffers( cur0,  cur1, mask, 5*WIDTH);                \
+                memset(dst0, 0, WIDTH * sizeof(type));                         \
+                memset(dst1, 0, WIDTH * sizeof(type));                         \
+                                                                               \
+                call_ref(dst0 + 3, prev0 + 2*WIDTH + 3, cur0 + 2*WIDTH + 3,    \
+                         next0 + 2*WIDTH + 3, w, stride, -stride,              \
+                         parity, mode);                                        \
+                call_new(dst1 + 3, prev1 + 2*WIDTH + 3, cur1 + 2*WIDTH + 3,    \
+                         next1 + 2*WIDTH + 3, w, stride, -stride,              \
+                         parity, mode);                                        \
+                                                                               \
+                if (memcmp(dst0, dst1, (w + 3) * sizeof(type))                 \
+                        || memcmp(prev0, prev1, 5*WIDTH * sizeof(type))        \
+                        || memcmp(next0, next1, 5*WIDTH * sizeof(type))        \
+                        || memcmp( cur0,  cur1, 5*WIDTH * sizeof(type)))       \
+                    fail();                                                    \
+            }                                                                  \
+        }                                                                      \
+        bench_new(dst1 + 3, prev1 + 2*WIDTH + 3, cur1 + 2*WIDTH + 3,           \
+                  next1 + 2*WIDTH + 3, w, stride, -stride, 0, 0);              \
+    } while (0)
+
+void checkasm_check_vf_yadif(void)
+{
+    YADIFContext ctx_8, ctx_10, ctx_16;
+
+    ff_yadif_init_filter_line(&ctx_8, 8);
+    ff_yadif_init_filter_line(&ctx_10, 10);
+    ff_yadif_init_filter_line(&ctx_16, 16);
+
+    if (check_func(ctx_8.filter_line, "yadif8"))
+        BODY(uint8_t, 8);
+    report("yadif8");
+
+    if (check_func(ctx_10.filter_line, "yadif10"))
+        BODY(uint16_t, 10);
+    report("yadif10");
+
+    if (check_func(ctx_16.filter_line, "yadif16"))
+        BODY(uint16_t, 16);
+    report("yadif16");
+}
@@ -16,6 +16,30 @@ FATE_API_SAMPLES_LIBAVFORMAT-$(call DEMDEC, H264, H264) += fate-api-h264-slice
 fate-api-h264-slice: $(APITESTSDIR)/api-h264-slice-test$(EXESUF)
 fate-api-h264-slice: CMD = run $(APITESTSDIR)/api-h264-slice-test$(EXESUF) 2 $(TARGET_SAMPLES)/h264/crew_cif.nal
 
+FATE_API_ROW_PROGRESS-$(call DEMDEC, H264, H264) += fate-api-row-progress-h264
+fate-api-row-progress-h264: $(APITESTSDIR)/api-row-progress-test$(EXESUF)
+fate-api-row-progress-h264: CMD = run $(APITESTSDIR)/api-row-progress-test$(EXESUF) 1 $(TARGET_SAMPLES)/h264-conformance/SVA_NL2_E.264
+fate-api-row-progress-h264: CMP = null
+
+FATE_API_ROW_PROGRESS-$(call DEMDEC, H264, H264) += fate-api-row-progress-h264-frame-threads
+fate-api-row-progress-h264-frame-threads: $(APITESTSDIR)/api-row-progress-test$(EXESUF)
+fate-api-row-progress-h264-frame-threads: CMD = run $(APITESTSDIR)/api-row-progress-test$(EXESUF) 3 $(TARGET_SAMPLES)/h264/crew_cif.nal
+fate-api-row-progress-h264-frame-threads: CMP = null
+
+FATE_API_ROW_PROGRESS-$(call DEMDEC, HEVC, HEVC) += fate-api-row-progress-hevc
+fate-api-row-progress-hevc: $(APITESTSDIR)/api-row-progress-test$(EXESUF)
+fate-api-row-progress-hevc: CMD = run $(APITESTSDIR)/api-row-progress-test$(EXESUF) 3 $(TARGET_SAMPLES)/hevc-conformance/WPP_A_ericsson_MAIN_2.bit
+fate-api-row-progress-hevc: CMP = null
+
+FATE_API_SAMPLES_LIBAVFORMAT-$(HAVE_THREADS) += $(FATE_API_ROW_PROGRESS-yes)
+
+FATE_API_ROW_PROGRESS_FILTER-$(CONFIG_SCALE_FILTER) += fate-api-row-progress-scale
+fate-api-row-progress-scale: $(APITESTSDIR)/api-row-progress-filter-test$(EXESUF)
+fate-api-row-progress-scale: CMD = run $(APITESTSDIR)/api-row-progress-filter-test$(EXESUF)
+fate-api-row-progress-scale: CMP = null
+
+FATE_API-$(HAVE_THREADS) += $(FATE_API_ROW_PROGRESS_FILTER-yes)
+
 FATE_API_LIBAVFORMAT-$(call DEMDEC, FLV, FLV) += fate-api-seek
 fate-api-seek: $(APITESTSDIR)/api-seek-test$(EXESUF) fate-lavf-flv
 fate-lavf-flv: KEEP_FILES ?= 1
@@ -27,6 +51,13 @@ fate-api-threadmessage: $(APITESTSDIR)/api-threadmessage-test$(EXESUF)
 fate-api-threadmessage: CMD = run $(APITESTSDIR)/api-threadmessage-test$(EXESUF) 3 10 30 50 2 20 40
 fate-api-threadmessage: CMP = null
 
+FATE_API_THREAD_POOL-$(call ALLYES, MPEG4_ENCODER MPEG4_DECODER) += fate-api-thread-pool
+fate-api-thread-pool: $(APITESTSDIR)/api-thread-pool-test$(EXESUF)
+fate-api-thread-pool: CMD = run $(APITESTSDIR)/api-thread-pool-test$(EXESUF)
+fate-api-thread-pool: CMP = null
+
+FATE_API_LIBAVCODEC-$(HAVE_THREADS) += $(FATE_API_THREAD_POOL-yes)
+
 FATE_API_SAMPLES-$(CONFIG_AVFORMAT) += $(FATE_API_SAMPLES_LIBAVFORMAT-yes)
 
 ifdef SAMPLES
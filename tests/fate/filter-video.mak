@@ -424,6 +424,18 @@ FATE_FILTER_VSYNTH-$(call ALLYES, TESTSRC_FILTER SCALE2REF_FILTER NULLSINK_FILTE
 fate-filter-scale2ref_keep_aspect: tests/data/filtergraphs/scale2ref_keep_aspect
 fate-filter-scale2ref_keep_aspect: CMD = framemd5 -frames:v 5 -filter_complex_script $(TARGET_PATH)/tests/data/filtergraphs/scale2ref_keep_aspect -map "[main]"
 
+FATE_FILTER_VSYNTH-$(call ALLYES, TESTSRC_FILTER FORMAT_FILTER MULTISCALE_FILTER FRAMEMD5_MUXER FILE_PROTOCOL PIPE_PROTOCOL) += fate-filter-multiscale
+fate-filter-multiscale: tests/data/filtergraphs/multiscale
+fate-filter-multiscale: CMD = framemd5 -frames:v 5 -filter_complex_script $(TARGET_PATH)/tests/data/filtergraphs/multiscale -map "[out0]" -map "[out1]" -map "[out2]"
+
+# the fused crop and pad of scale must match the equivalent filter chain
+FATE_FILTER_VSYNTH-$(call ALLYES, TESTSRC_FILTER SPLIT_FILTER FORMAT_FILTER SCALE_FILTER FRAMEMD5_MUXER FILE_PROTOCOL PIPE_PROTOCOL) += fate-filter-scale_crop_pad
+FATE_FILTER_VSYNTH-$(call ALLYES, TESTSRC_FILTER SPLIT_FILTER FORMAT_FILTER SCALE_FILTER CROP_FILTER PAD_FILTER FRAMEMD5_MUXER FILE_PROTOCOL PIPE_PROTOCOL) += fate-filter-scale_crop_pad_chain
+fate-filter-scale_crop_pad: tests/data/filtergraphs/scale_crop_pad
+fate-filter-scale_crop_pad_chain: tests/data/filtergraphs/scale_crop_pad_chain
+fate-filter-scale_crop_pad fate-filter-scale_crop_pad_chain: CMD = framemd5 -frames:v 5 -filter_complex_script $(TARGET_PATH)/tests/data/filtergraphs/$(@:fate-filter-%=%) -map "[out0]" -map "[out1]"
+fate-filter-scale_crop_pad_chain: REF = $(SRC_PATH)/tests/ref/fate/filter-scale_crop_pad
+
 FATE_FILTER_VSYNTH-$(call FILTERDEMDEC, SCALE, RAWVIDEO, RAWVIDEO) += fate-filter-scalechroma
 fate-filter-scalechroma: tests/data/vsynth1.yuv
 fate-filter-scalechroma: CMD = framecrc -flags bitexact -s 352x288 -pix_fmt yuv444p -i $(TARGET_PATH)/tests/data/vsynth1.yuv -pix_fmt yuv420p -sws_flags +bitexact -vf scale=out_v_chr_pos=33:out_h_chr_pos=151
@@ -732,10 +744,19 @@ FATE_FILTER-$(call ALLYES, TESTSRC2_FILTER SPLIT_FILTER AVGBLUR_FILTER        \
                            METADATA_FILTER WRAPPED_AVFRAME_ENCODER NULL_MUXER \
                            PIPE_PROTOCOL) += $(FATE_FILTER_REFCMP_METADATA-yes)
 
+# the graph is run with and without concurrent filter activation and the
+# outputs are compared
+FATE_FILTER_GRAPH_THREADS-$(call ALLYES, TESTSRC_FILTER SINE_FILTER SPLIT_FILTER HFLIP_FILTER VFLIP_FILTER \
+                                         HUE_FILTER SENDCMD_FILTER GRAPHMONITOR_FILTER AGRAPHMONITOR_FILTER) += fate-filter-graph-threads
+fate-filter-graph-threads: tools/graph_bench$(EXESUF) tests/data/filtergraphs/graph_threads
+fate-filter-graph-threads: CMD = run tools/graph_bench$(EXESUF) -t 4 -n 25 $(TARGET_PATH)/tests/data/filtergraphs/graph_threads
+fate-filter-graph-threads: CMP = null
+FATE-yes += $(FATE_FILTER_GRAPH_THREADS-yes)
+
 FATE_SAMPLES_FFPROBE += $(FATE_METADATA_FILTER-yes)
 FATE_SAMPLES_FFMPEG += $(FATE_FILTER_SAMPLES-yes)
 FATE_FFMPEG += $(FATE_FILTER-yes)
 
-fate-vfilter: $(FATE_FILTER-yes) $(FATE_FILTER_SAMPLES-yes) $(FATE_FILTER_VSYNTH-yes)
+fate-vfilter: $(FATE_FILTER-yes) $(FATE_FILTER_SAMPLES-yes) $(FATE_FILTER_VSYNTH-yes) $(FATE_FILTER_GRAPH_THREADS-yes)
 
 fate-filter: fate-afilter fate-vfilter $(FATE_METADATA_FILTER-yes)
@@ -210,6 +210,31 @@ FATE_HEVC-$(call FRAMECRC, HEVC, HEVC, HEVC_PARSER SCALE_FILTER) +=         \
                                                     $(HEVC_TESTS_422_10BIN) \
                                                     $(HEVC_TESTS_444_12BIT) \
 
+# WPP streams again with wavefront row threads inside frame threads, all
+# frame threads sharing one pool of wpp_threads workers
+HEVC_SAMPLES_WPP_8BIT  = $(filter WPP_%_ericsson_MAIN_2, $(HEVC_SAMPLES_8BIT))
+HEVC_SAMPLES_WPP_10BIT = $(filter WPP_%_ericsson_MAIN10_2, $(HEVC_SAMPLES_10BIT))
+HEVC_TESTS_WPP_8BIT  = $(addprefix fate-hevc-wpp-threads-, $(HEVC_SAMPLES_WPP_8BIT))
+HEVC_TESTS_WPP_10BIT = $(addprefix fate-hevc-wpp-threads-, $(HEVC_SAMPLES_WPP_10BIT))
+
+$(HEVC_TESTS_WPP_8BIT): SCALE_OPTS := -pix_fmt yuv420p
+$(HEVC_TESTS_WPP_10BIT): SCALE_OPTS := -pix_fmt yuv420p10le -vf scale
+fate-hevc-wpp-threads-%: CMD = threads=3 thread_type=frame framecrc -wpp_threads 2 -flags unaligned -i $(TARGET_SAMPLES)/hevc-conformance/$(subst fate-hevc-wpp-threads-,,$(@)).bit $(SCALE_OPTS)
+fate-hevc-wpp-threads-%: REF = $(SRC_PATH)/tests/ref/fate/hevc-conformance-$(subst fate-hevc-wpp-threads-,,$(@))
+
+FATE_HEVC-$(call FRAMECRC, HEVC, HEVC, HEVC_PARSER) += $(HEVC_TESTS_WPP_8BIT)
+FATE_HEVC-$(call FRAMECRC, HEVC, HEVC, HEVC_PARSER SCALE_FILTER) += $(HEVC_TESTS_WPP_10BIT)
+
+# keyframes_only on streams of a single IRAP picture, which must be decoded
+# and output as without it, with frame threads
+HEVC_SAMPLES_KEYFRAMES_8BIT = $(filter IPRED_B_Nokia_3 ipcm_E_NEC_2, $(HEVC_SAMPLES_8BIT))
+HEVC_TESTS_KEYFRAMES_8BIT   = $(addprefix fate-hevc-keyframes-only-, $(HEVC_SAMPLES_KEYFRAMES_8BIT))
+
+fate-hevc-keyframes-only-%: CMD = threads=2 thread_type=frame framecrc -keyframes_only 1 -flags unaligned -i $(TARGET_SAMPLES)/hevc-conformance/$(subst fate-hevc-keyframes-only-,,$(@)).bit -pix_fmt yuv420p
+fate-hevc-keyframes-only-%: REF = $(SRC_PATH)/tests/ref/fate/hevc-conformance-$(subst fate-hevc-keyframes-only-,,$(@))
+
+FATE_HEVC-$(call FRAMECRC, HEVC, HEVC, HEVC_PARSER) += $(HEVC_TESTS_KEYFRAMES_8BIT)
+
 fate-hevc-paramchange-yuv420p-yuv420p10: CMD = framecrc -vsync passthrough -i $(TARGET_SAMPLES)/hevc/paramchange_yuv420p_yuv420p10.hevc -sws_flags area+accurate_rnd+bitexact
 FATE_HEVC-$(call FRAMECRC, HEVC, HEVC, HEVC_PARSER SCALE_FILTER LARGE_TESTS) += fate-hevc-paramchange-yuv420p-yuv420p10
 
@@ -136,6 +136,8 @@ int ds_open(DecodeContext *dc, const char *url, int stream_idx)
         return ret;
     }
 
+    if (stream_idx < 0)
+        stream_idx = av_find_best_stream(dc->demuxer, AVMEDIA_TYPE_VIDEO, -1, -1, NULL, 0);
     if (stream_idx < 0 || stream_idx >= dc->demuxer->nb_streams)
         return AVERROR(EINVAL);
 
@@ -45,6 +45,10 @@ typedef struct DecodeContext {
     int              max_frames;
 } DecodeContext;
 
+/**
+ * Open url for decoding the stream with index stream_idx, or the best
+ * video stream if stream_idx is negative.
+ */
 int ds_open(DecodeContext *dc, const char *url, int stream_idx);
 void ds_free(DecodeContext *dc);
 
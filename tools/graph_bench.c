@@ -0,0 +1,422 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/* Run filtergraph descriptions, such as the ones in tests/filtergraphs, on
+ * generated frames with and without concurrent filter activation and
+ * compare speed and output. */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "libavutil/adler32.h"
+#include "libavutil/channel_layout.h"
+#include "libavutil/error.h"
+#include "libavutil/file.h"
+#include "libavutil/frame.h"
+#include "libavutil/imgutils.h"
+#include "libavutil/mem.h"
+#include "libavutil/opt.h"
+#include "libavutil/parseutils.h"
+#include "libavutil/pixdesc.h"
+#include "libavutil/time.h"
+
+#include "libavfilter/avfilter.h"
+#include "libavfilter/buffersink.h"
+#include "libavfilter/buffersrc.h"
+
+#define SAMPLE_RATE   48000
+#define FRAME_SAMPLES 1024
+
+typedef struct BenchParams {
+    const char *threads;
+    int nb_frames;
+    int width, height;
+    enum AVPixelFormat pix_fmt;
+} BenchParams;
+
+typedef struct GraphRun {
+    AVFilterGraph *graph;
+    AVFilterContext **srcs;
+    int nb_srcs;
+    AVFilterContext **sinks;
+    int nb_sinks;
+    uint32_t *checksums;
+    AVFrame *frame;
+} GraphRun;
+
+static void run_free(GraphRun *r)
+{
+    avfilter_graph_free(&r->graph);
+    av_freep(&r->srcs);
+    av_freep(&r->sinks);
+    av_freep(&r->checksums);
+    av_frame_free(&r->frame);
+}
+
+static int add_src(GraphRun *r, const BenchParams *p, AVFilterInOut *in)
+{
+    enum AVMediaType type = avfilter_pad_get_type(in->filter_ctx->input_pads, in->pad_idx);
+    AVFilterContext *src;
+    char name[32], args[256];
+    int ret;
+
+    snprintf(name, sizeof(name), "src%d", r->nb_srcs);
+    if (type == AVMEDIA_TYPE_VIDEO) {
+        snprintf(args, sizeof(args),
+                 "video_size=%dx%d:pix_fmt=%d:time_base=1/25:pixel_aspect=1/1",
+                 p->width, p->height, p->pix_fmt);
+        ret = avfilter_graph_create_filter(&src, avfilter_get_by_name("buffer"),
+                                           name, args, NULL, r->graph);
+    } else if (type == AVMEDIA_TYPE_AUDIO) {
+        snprintf(args, sizeof(args),
+                 "sample_fmt=fltp:sample_rate=%d:channel_layout=stereo:time_base=1/%d",
+                 SAMPLE_RATE, SAMPLE_RATE);
+        ret = avfilter_graph_create_filter(&src, avfilter_get_by_name("abuffer"),
+                                           name, args, NULL, r->graph);
+    } else {
+        return AVERROR(ENOSYS);
+    }
+    if (ret < 0)
+        return ret;
+
+    ret = avfilter_link(src, 0, in->filter_ctx, in->pad_idx);
+    if (ret < 0)
+        return ret;
+    r->srcs[r->nb_srcs++] = src;
+    return 0;
+}
+
+static int add_sink(GraphRun *r, AVFilterInOut *out)
+{
+    enum AVMediaType type = avfilter_pad_get_type(out->filter_ctx->output_pads, out->pad_idx);
+    AVFilterContext *sink;
+    char name[32];
+    int ret;
+
+    snprintf(name, sizeof(name), "sink%d", r->nb_sinks);
+    ret = avfilter_graph_create_filter(&sink,
+                                       avfilter_get_by_name(type == AVMEDIA_TYPE_VIDEO ?
+                                                            "buffersink" : "abuffersink"),
+                                       name, NULL, NULL, r->graph);
+    if (ret < 0)
+        return ret;
+
+    ret = avfilter_link(out->filter_ctx, out->pad_idx, sink, 0);
+    if (ret < 0)
+        return ret;
+    r->sinks[r->nb_sinks++] = sink;
+    return 0;
+}
+
+static int count_inout(const AVFilterInOut *l)
+{
+    int n = 0;
+    for (; l; l = l->next)
+        n++;
+    return n;
+}
+
+static int run_init(GraphRun *r, const BenchParams *p, const char *desc, int thread_type)
+{
+    AVFilterInOut *inputs = NULL, *outputs = NULL, *cur;
+    int ret;
+
+    r->graph = avfilter_graph_alloc();
+    if (!r->graph)
+        return AVERROR(ENOMEM);
+    ret = av_opt_set(r->graph, "threads", p->threads, 0);
+    if (ret < 0)
+        return ret;
+    r->graph->thread_type = thread_type;
+
+    ret = avfilter_graph_parse2(r->graph, desc, &inputs, &outputs);
+    if (ret < 0)
+        goto end;
+
+    r->srcs      = av_calloc(count_inout(inputs)  + 1, sizeof(*r->srcs));
+    r->sinks     = av_calloc(count_inout(outputs) + 1, sizeof(*r->sinks));
+    r->checksums = av_calloc(count_inout(outputs) + 1, sizeof(*r->checksums));
+    r->frame     = av_frame_alloc();
+    if (!r->srcs || !r->sinks || !r->checksums || !r->frame) {
+        ret = AVERROR(ENOMEM);
+        goto end;
+    }
+
+    for (cur = inputs; cur; cur = cur->next)
+        if ((ret = add_src(r, p, cur)) < 0)
+            goto end;
+    for (cur = outputs; cur; cur = cur->next)
+        if ((ret = add_sink(r, cur)) < 0)
+            goto end;
+
+    ret = avfilter_graph_config(r->graph, NULL);
+end:
+    avfilter_inout_free(&inputs);
+    avfilter_inout_free(&outputs);
+    return ret;
+}
+
+static int fill_frame(AVFrame *frame, AVFilterContext *src, int n)
+{
+    AVFilterLink *link = src->outputs[0];
+    int ret;
+
+    av_frame_unref(frame);
+    if (link->type == AVMEDIA_TYPE_VIDEO) {
+        const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(link->format);
+
+        frame->format = link->format;
+        frame->width  = link->w;
+        frame->height = link->h;
+        ret = av_frame_get_buffer(frame, 0);
+        if (ret < 0)
+            return ret;
+        for (int plane = 0; plane < 4 && frame->data[plane]; plane++) {
+            int h = plane == 1 || plane == 2 ?
+                    AV_CEIL_RSHIFT(frame->height, desc->log2_chroma_h) : frame->height;
+
+            /* fill the padding too, some filters read past the width */
+            for (int y = 0; y < h; y++)
+                for (int x = 0; x < frame->linesize[plane]; x++)
+                    frame->data[plane][y * frame->linesize[plane] + x] = x + 3 * y + 7 * n;
+        }
+    } else {
+        frame->format      = link->format;
+        frame->sample_rate = link->sample_rate;
+        frame->nb_samples  = FRAME_SAMPLES;
+        ret = av_channel_layout_copy(&frame->ch_layout, &link->ch_layout);
+        if (ret < 0)
+            return ret;
+        ret = av_frame_get_buffer(frame, 0);
+        if (ret < 0)
+            return ret;
+        for (int ch = 0; ch < frame->ch_layout.nb_channels; ch++) {
+            float *dst = (float *)frame->extended_data[ch];
+            for (int i = 0; i < frame->nb_samples; i++)
+                dst[i] = ((n * FRAME_SAMPLES + i + ch * 100) % 200 - 100) / 128.0f;
+        }
+    }
+    frame->pts = link->type == AVMEDIA_TYPE_VIDEO ? n : (int64_t)n * FRAME_SAMPLES;
+    return 0;
+}
+
+static uint32_t frame_checksum(uint32_t sum, const AVFrame *frame)
+{
+    if (frame->width) {
+        const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(frame->format);
+
+        for (int plane = 0; plane < 4 && frame->data[plane]; plane++) {
+            int h = plane == 1 || plane == 2 ?
+                    AV_CEIL_RSHIFT(frame->height, desc->log2_chroma_h) : frame->height;
+            int w = av_image_get_linesize(frame->format, frame->width, plane);
+
+            for (int y = 0; y < h; y++)
+                sum = av_adler32_update(sum, frame->data[plane] + y * frame->linesize[plane], w);
+        }
+    } else {
+        int planar = av_sample_fmt_is_planar(frame->format);
+        int size   = frame->nb_samples * av_get_bytes_per_sample(frame->format) *
+                     (planar ? 1 : frame->ch_layout.nb_channels);
+
+        for (int ch = 0; ch < (planar ? frame->ch_layout.nb_channels : 1); ch++)
+            sum = av_adler32_update(sum, frame->extended_data[ch], size);
+    }
+    return sum;
+}
+
+static int drain_sinks(GraphRun *r, int flush)
+{
+    for (int i = 0; i < r->nb_sinks; i++) {
+        int ret;
+
+        while ((ret = av_buffersink_get_frame(r->sinks[i], r->frame)) >= 0) {
+            r->checksums[i] = frame_checksum(r->checksums[i], r->frame);
+            av_frame_unref(r->frame);
+        }
+        if (ret != AVERROR(EAGAIN) && ret != AVERROR_EOF)
+            return ret;
+        if (flush && ret == AVERROR(EAGAIN))
+            return AVERROR_BUG;
+    }
+    return 0;
+}
+
+static int run_graph(GraphRun *r, const BenchParams *p, const char *desc,
+                     int thread_type, int64_t *elapsed)
+{
+    int64_t start;
+    int ret;
+
+    ret = run_init(r, p, desc, thread_type);
+    if (ret < 0)
+        return ret;
+
+    start = av_gettime_relative();
+
+    /* graphs with their own sources, pull nb_frames from each sink */
+    if (!r->nb_srcs) {
+        for (int n = 0; n < p->nb_frames; n++) {
+            for (int i = 0; i < r->nb_sinks; i++) {
+                ret = av_buffersink_get_frame(r->sinks[i], r->frame);
+                if (ret == AVERROR_EOF)
+                    continue;
+                if (ret < 0)
+                    return ret;
+                r->checksums[i] = frame_checksum(r->checksums[i], r->frame);
+                av_frame_unref(r->frame);
+            }
+        }
+        *elapsed = av_gettime_relative() - start;
+        return 0;
+    }
+
+    for (int n = 0; n < p->nb_frames; n++) {
+        for (int i = 0; i < r->nb_srcs; i++) {
+            ret = fill_frame(r->frame, r->srcs[i], n);
+            if (ret < 0)
+                return ret;
+            ret = av_buffersrc_add_frame(r->srcs[i], r->frame);
+            if (ret < 0)
+                return ret;
+        }
+        ret = drain_sinks(r, 0);
+        if (ret < 0)
+            return ret;
+    }
+    for (int i = 0; i < r->nb_srcs; i++) {
+        ret = av_buffersrc_close(r->srcs[i], AV_NOPTS_VALUE, 0);
+        if (ret < 0)
+            return ret;
+    }
+    ret = drain_sinks(r, 1);
+    *elapsed = av_gettime_relative() - start;
+    return ret;
+}
+
+static char *read_graph(const char *filename)
+{
+    uint8_t *buf;
+    size_t size;
+    char *desc;
+
+    if (av_file_map(filename, &buf, &size, 0, NULL) < 0)
+        return NULL;
+    desc = av_malloc(size + 1);
+    if (desc) {
+        memcpy(desc, buf, size);
+        desc[size] = 0;
+    }
+    av_file_unmap(buf, size);
+    return desc;
+}
+
+static void usage(const char *name)
+{
+    fprintf(stderr,
+            "Usage: %s [-n <frames>] [-s <size>] [-p <pix_fmt>] [-t <threads>] <graph file> [<graph file>...]\n"
+            "  -n  number of frames fed to each input (default 100)\n"
+            "  -s  size of the video input frames (default 1920x1080)\n"
+            "  -p  pixel format of the video input frames (default yuv420p)\n"
+            "  -t  number of graph threads (default auto)\n"
+            "Each graph is run with thread_type=slice and thread_type=slice+graph and\n"
+            "the outputs are compared, so filters should use bitexact options.\n",
+            name);
+}
+
+int main(int argc, char **argv)
+{
+    BenchParams p = {
+        .threads   = "0",
+        .nb_frames = 100,
+        .width     = 1920,
+        .height    = 1080,
+        .pix_fmt   = AV_PIX_FMT_YUV420P,
+    };
+    int nb_failed = 0;
+    int i;
+
+    for (i = 1; i < argc && argv[i][0] == '-'; i += 2) {
+        if (i + 1 >= argc) {
+            usage(argv[0]);
+            return 1;
+        }
+        if (!strcmp(argv[i], "-n"))
+            p.nb_frames = strtol(argv[i + 1], NULL, 0);
+        else if (!strcmp(argv[i], "-s")) {
+            if (av_parse_video_size(&p.width, &p.height, argv[i + 1]) < 0) {
+                fprintf(stderr, "Invalid size %s\n", argv[i + 1]);
+                return 1;
+            }
+        } else if (!strcmp(argv[i], "-p")) {
+            p.pix_fmt = av_get_pix_fmt(argv[i + 1]);
+            if (p.pix_fmt == AV_PIX_FMT_NONE) {
+                fprintf(stderr, "Invalid pixel format %s\n", argv[i + 1]);
+                return 1;
+            }
+        } else if (!strcmp(argv[i], "-t"))
+            p.threads = argv[i + 1];
+        else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (i >= argc || p.nb_frames <= 0) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    printf("%-40s %10s %10s %8s\n", "graph", "slice ms", "graph ms", "speedup");
+    for (; i < argc; i++) {
+        GraphRun serial = { 0 }, parallel = { 0 };
+        int64_t t_serial = 0, t_parallel = 0;
+        char *desc = read_graph(argv[i]);
+        int ret;
+
+        if (!desc) {
+            fprintf(stderr, "Error reading %s\n", argv[i]);
+            nb_failed++;
+            continue;
+        }
+
+        ret = run_graph(&serial, &p, desc, AVFILTER_THREAD_SLICE, &t_serial);
+        if (ret >= 0)
+            ret = run_graph(&parallel, &p, desc,
+                            AVFILTER_THREAD_SLICE | AVFILTER_THREAD_GRAPH, &t_parallel);
+        if (ret < 0) {
+            fprintf(stderr, "Error running %s: %s\n", argv[i], av_err2str(ret));
+            nb_failed++;
+        } else if (serial.nb_sinks != parallel.nb_sinks ||
+                   memcmp(serial.checksums, parallel.checksums,
+                          serial.nb_sinks * sizeof(*serial.checksums))) {
+            fprintf(stderr, "Output mismatch for %s\n", argv[i]);
+            nb_failed++;
+        } else {
+            printf("%-40s %10.1f %10.1f %7.2fx\n", argv[i],
+                   t_serial / 1000.0, t_parallel / 1000.0,
+                   t_parallel ? (double)t_serial / t_parallel : 0.0);
+        }
+
+        run_free(&serial);
+        run_free(&parallel);
+        av_free(desc);
+    }
+
+    return nb_failed ? 1 : 0;
+}
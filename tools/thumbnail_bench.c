@@ -0,0 +1,125 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/* Measure how many files per second can be opened and decoded up to their
+ * first few (key)frames, as done when generating thumbnails. */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "decode_simple.h"
+
+#include "libavutil/dict.h"
+#include "libavutil/error.h"
+#include "libavutil/time.h"
+
+#include "libavcodec/avcodec.h"
+
+static int process_frame(DecodeContext *dc, AVFrame *frame)
+{
+    return 0;
+}
+
+static void usage(const char *name)
+{
+    fprintf(stderr,
+            "Usage: %s [-m all|nokey|keyframes] [-n <frames>] [-t <threads>] <file> [<file>...]\n"
+            "  -m  all:       decode every frame\n"
+            "      nokey:     set skip_frame=nokey\n"
+            "      keyframes: also set the h264/hevc keyframes_only option (default)\n"
+            "  -n  number of frames to decode per file (default 1)\n"
+            "  -t  number of decoder threads (default 1)\n",
+            name);
+}
+
+int main(int argc, char **argv)
+{
+    const char *mode = "keyframes";
+    const char *threads = "1";
+    int max_frames = 1;
+    int nb_files = 0, nb_failed = 0;
+    int64_t nb_frames = 0, start, elapsed;
+    int i;
+
+    for (i = 1; i < argc && argv[i][0] == '-'; i += 2) {
+        if (i + 1 >= argc) {
+            usage(argv[0]);
+            return 1;
+        }
+        if (!strcmp(argv[i], "-m"))
+            mode = argv[i + 1];
+        else if (!strcmp(argv[i], "-n"))
+            max_frames = strtol(argv[i + 1], NULL, 0);
+        else if (!strcmp(argv[i], "-t"))
+            threads = argv[i + 1];
+        else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (i >= argc || max_frames < 0 ||
+        (strcmp(mode, "all") && strcmp(mode, "nokey") && strcmp(mode, "keyframes"))) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    start = av_gettime_relative();
+
+    for (; i < argc; i++) {
+        DecodeContext dc;
+        int ret;
+
+        ret = ds_open(&dc, argv[i], -1);
+        if (ret < 0) {
+            fprintf(stderr, "Error opening %s: %s\n", argv[i], av_err2str(ret));
+            ds_free(&dc);
+            nb_failed++;
+            continue;
+        }
+
+        dc.process_frame = process_frame;
+        dc.max_frames    = max_frames;
+
+        av_dict_set(&dc.decoder_opts, "threads", threads, 0);
+        if (strcmp(mode, "all"))
+            av_dict_set(&dc.decoder_opts, "skip_frame", "nokey", 0);
+        if (!strcmp(mode, "keyframes"))
+            av_dict_set(&dc.decoder_opts, "keyframes_only", "1", 0);
+
+        ret = ds_run(&dc);
+        if (ret < 0) {
+            fprintf(stderr, "Error decoding %s: %s\n", argv[i], av_err2str(ret));
+            nb_failed++;
+        } else {
+            nb_frames += dc.decoder->frame_num;
+            nb_files++;
+        }
+
+        ds_free(&dc);
+    }
+
+    elapsed = av_gettime_relative() - start;
+
+    printf("%d files (%d failed), %"PRId64" frames in %.3f s: %.2f files/s\n",
+           nb_files, nb_failed, nb_frames, elapsed / 1000000.0,
+           elapsed ? nb_files * 1000000.0 / elapsed : 0.0);
+
+    return nb_failed ? 1 : 0;
+}